@@ -1,5 +1,5 @@
 /*
-* Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+* Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
 *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -538,6 +538,12 @@ boardobjgrp_pmuset_exit:
 	return status;
 }
 
+/*
+ * Always sends the whole group. Groups are only SET from pmuinithandle
+ * after a PMU boot, which needs the full table anyway; later VFE, clk and
+ * volt changes go through their own RPCs, and the PMU has no partial-SET
+ * command. Tracking dirty objects for a delta SET would not save anything.
+ */
 int boardobjgrp_pmuset_impl_v1(struct gk20a *g,
 	struct boardobjgrp *pboardobjgrp)
 {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -904,6 +904,19 @@ int nvgpu_clk_set_fll_clk_gv10x(struct gk20a *g)
 	return status;
 }
 
+static int clk_volt_domain_to_rail(u8 railidx, u8 *rail)
+{
+	if (railidx == CTRL_VOLT_DOMAIN_LOGIC) {
+		*rail = CLK_PROG_VFE_ENTRY_LOGIC;
+	} else if (railidx == CTRL_VOLT_DOMAIN_SRAM) {
+		*rail = CLK_PROG_VFE_ENTRY_SRAM;
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 u32 clk_domain_get_f_or_v(
 	struct gk20a *g,
 	u32 clkapidomain,
@@ -922,11 +935,7 @@ u32 clk_domain_get_f_or_v(
 		return -EINVAL;
 	}
 
-	if (railidx == CTRL_VOLT_DOMAIN_LOGIC) {
-		rail = CLK_PROG_VFE_ENTRY_LOGIC;
-	} else if (railidx == CTRL_VOLT_DOMAIN_SRAM) {
-		rail = CLK_PROG_VFE_ENTRY_SRAM;
-	} else {
+	if (clk_volt_domain_to_rail(railidx, &rail) != 0) {
 		return -EINVAL;
 	}
 
@@ -940,3 +949,37 @@ u32 clk_domain_get_f_or_v(
 	}
 	return status;
 }
+
+/*
+ * Same as clk_domain_get_f_or_v(), but frequency to voltage lookups on a
+ * curve held by @lookup are a binary search instead of a boardobj walk.
+ */
+u32 clk_domain_get_f_or_v_cached(
+	struct gk20a *g,
+	struct clk_vf_lookup *lookup,
+	u32 clkapidomain,
+	u16 *pclkmhz,
+	u32 *pvoltuv,
+	u8 railidx
+)
+{
+	struct clk_vf_curve *curve;
+	u8 rail;
+
+	if ((lookup == NULL) || (pclkmhz == NULL) || (pvoltuv == NULL) ||
+	    (*pclkmhz == 0U) || (*pvoltuv != 0U) ||
+	    (clk_volt_domain_to_rail(railidx, &rail) != 0)) {
+		goto slow_path;
+	}
+
+	curve = clk_vf_lookup_curve(lookup, clkapidomain, rail);
+	if ((curve == NULL) || !curve->valid) {
+		goto slow_path;
+	}
+
+	return clk_vf_curve_f_to_v(curve, *pclkmhz, pvoltuv);
+
+slow_path:
+	return clk_domain_get_f_or_v(g, clkapidomain, pclkmhz, pvoltuv,
+			railidx);
+}
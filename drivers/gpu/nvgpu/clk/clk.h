@@ -1,7 +1,7 @@
 /*
  * general clock structures & definitions
  *
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -128,6 +128,14 @@ u32 clk_domain_get_f_or_v(
 	u32 *pvoltuv,
 	u8 railidx
 );
+u32 clk_domain_get_f_or_v_cached(
+	struct gk20a *g,
+	struct clk_vf_lookup *lookup,
+	u32 clkapidomain,
+	u16 *pclkmhz,
+	u32 *pvoltuv,
+	u8 railidx
+);
 int clk_get_fll_clks(struct gk20a *g, struct set_fll_clk *fllclk);
 int clk_set_fll_clks(struct gk20a *g, struct set_fll_clk *fllclk);
 int clk_pmu_freq_controller_load(struct gk20a *g, bool bload, u8 bit_idx);
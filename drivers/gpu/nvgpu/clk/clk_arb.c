@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -116,16 +116,34 @@ int nvgpu_clk_arb_update_vf_table(struct nvgpu_clk_arb *arb)
 	u32 gpc2clk_voltuv_sram = 0, mclk_voltuv_sram = 0;
 	u16 clk_cur;
 	u32 num_points;
+	u16 prev_mclk_min = arb->mclk_min, prev_mclk_max = arb->mclk_max;
+	bool gpc2clk_changed = true, mclk_changed = true;
 
 	struct clk_set_info *p5_info, *p0_info;
+	struct nvgpu_clk_vf_table *prev;
 
-	table = NV_ACCESS_ONCE(arb->current_vf_table);
+	prev = NV_ACCESS_ONCE(arb->current_vf_table);
 	/* make flag visible when all data has resolved in the tables */
 	nvgpu_smp_rmb();
 
-	table = (table == &arb->vf_table_pool[0]) ? &arb->vf_table_pool[1] :
+	table = (prev == &arb->vf_table_pool[0]) ? &arb->vf_table_pool[1] :
 		&arb->vf_table_pool[0];
 
+	/*
+	 * Refresh the per-domain curves. A domain whose curve did not move
+	 * keeps the points of the previous table.
+	 */
+	if (arb->vf_lookup) {
+		if (clk_vf_lookup_refresh(g, arb->vf_lookup,
+				CTRL_CLK_DOMAIN_GPC2CLK, &gpc2clk_changed) < 0)
+			gpc2clk_changed = true;
+		if (clk_vf_lookup_refresh(g, arb->vf_lookup,
+				CTRL_CLK_DOMAIN_MCLK, &mclk_changed) < 0)
+			mclk_changed = true;
+		clk_arb_dbg(g, "VF curves changed: gpc2clk %d mclk %d",
+			gpc2clk_changed, mclk_changed);
+	}
+
 	/* Get allowed memory ranges */
 	if (g->ops.clk_arb.get_arbiter_clk_range(g, CTRL_CLK_DOMAIN_GPC2CLK,
 						&arb->gpc2clk_min,
@@ -161,11 +179,27 @@ int nvgpu_clk_arb_update_vf_table(struct nvgpu_clk_arb *arb)
 		goto exit_vf_table;
 	}
 
-	memset(table->mclk_points, 0,
-		table->mclk_num_points*sizeof(struct nvgpu_clk_vf_point));
 	memset(table->gpc2clk_points, 0,
 		table->gpc2clk_num_points*sizeof(struct nvgpu_clk_vf_point));
 
+	/*
+	 * The MCLK f points come from the same curve, so an unchanged curve
+	 * and range give the same MCLK half of the table.
+	 */
+	if (!mclk_changed && prev && prev->mclk_num_points &&
+			(arb->mclk_min == prev_mclk_min) &&
+			(arb->mclk_max == prev_mclk_max)) {
+		memcpy(table->mclk_points, prev->mclk_points,
+			prev->mclk_num_points *
+			sizeof(struct nvgpu_clk_vf_point));
+		table->mclk_num_points = prev->mclk_num_points;
+		status = 0;
+		goto gpc2clk_points;
+	}
+
+	memset(table->mclk_points, 0,
+		table->mclk_num_points*sizeof(struct nvgpu_clk_vf_point));
+
 	p5_info = pstate_get_clk_set_info(g,
 			CTRL_PERF_PSTATE_P5, clkwhich_mclk);
 	if (!p5_info) {
@@ -189,7 +223,8 @@ int nvgpu_clk_arb_update_vf_table(struct nvgpu_clk_arb *arb)
 			table->mclk_points[j].mem_mhz = arb->mclk_f_points[i];
 			mclk_voltuv = mclk_voltuv_sram = 0;
 
-			status = clk_domain_get_f_or_v(g, CTRL_CLK_DOMAIN_MCLK,
+			status = clk_domain_get_f_or_v_cached(g,
+				arb->vf_lookup, CTRL_CLK_DOMAIN_MCLK,
 				&table->mclk_points[j].mem_mhz, &mclk_voltuv,
 				CTRL_VOLT_DOMAIN_LOGIC);
 			if (status < 0) {
@@ -197,7 +232,8 @@ int nvgpu_clk_arb_update_vf_table(struct nvgpu_clk_arb *arb)
 					"failed to get MCLK LOGIC voltage");
 				goto exit_vf_table;
 			}
-			status = clk_domain_get_f_or_v(g, CTRL_CLK_DOMAIN_MCLK,
+			status = clk_domain_get_f_or_v_cached(g,
+				arb->vf_lookup, CTRL_CLK_DOMAIN_MCLK,
 				&table->mclk_points[j].mem_mhz,
 				&mclk_voltuv_sram,
 				CTRL_VOLT_DOMAIN_SRAM);
@@ -228,6 +264,7 @@ int nvgpu_clk_arb_update_vf_table(struct nvgpu_clk_arb *arb)
 	}
 	table->mclk_num_points = num_points;
 
+gpc2clk_points:
 	p5_info = pstate_get_clk_set_info(g,
 			CTRL_PERF_PSTATE_P5, clkwhich_gpc2clk);
 	if (!p5_info) {
@@ -374,7 +411,8 @@ int nvgpu_clk_arb_update_vf_table(struct nvgpu_clk_arb *arb)
 		}
 
 		/* Calculate voltages */
-		status = clk_domain_get_f_or_v(g, CTRL_CLK_DOMAIN_GPC2CLK,
+		status = clk_domain_get_f_or_v_cached(g, arb->vf_lookup,
+						CTRL_CLK_DOMAIN_GPC2CLK,
 						&alt_gpc2clk, &gpc2clk_voltuv,
 						CTRL_VOLT_DOMAIN_LOGIC);
 		if (status < 0) {
@@ -382,7 +420,8 @@ int nvgpu_clk_arb_update_vf_table(struct nvgpu_clk_arb *arb)
 			goto exit_vf_table;
 		}
 
-		status = clk_domain_get_f_or_v(g, CTRL_CLK_DOMAIN_GPC2CLK,
+		status = clk_domain_get_f_or_v_cached(g, arb->vf_lookup,
+						CTRL_CLK_DOMAIN_GPC2CLK,
 						&alt_gpc2clk,
 						&gpc2clk_voltuv_sram,
 						CTRL_VOLT_DOMAIN_SRAM);
@@ -398,6 +437,7 @@ int nvgpu_clk_arb_update_vf_table(struct nvgpu_clk_arb *arb)
 	/* make table visible when all data has resolved in the tables */
 	nvgpu_smp_wmb();
 	arb->current_vf_table = table;
+	arb->vf_table_gen++;
 
 exit_vf_table:
 
@@ -819,6 +859,7 @@ int nvgpu_clk_arb_init_session(struct gk20a *g,
 {
 	struct nvgpu_clk_arb *arb = g->clk_arb;
 	struct nvgpu_clk_session *session = *(_session);
+	int err;
 
 	clk_arb_dbg(g, " ");
 
@@ -832,6 +873,12 @@ int nvgpu_clk_arb_init_session(struct gk20a *g,
 		return -ENOMEM;
 	session->g = g;
 
+	err = nvgpu_clk_arb_agg_alloc_slot(g, &arb->agg, &session->slot);
+	if (err < 0) {
+		nvgpu_kfree(g, session);
+		return err;
+	}
+
 	nvgpu_ref_init(&session->refcount);
 
 	session->zombie = false;
@@ -843,6 +890,7 @@ int nvgpu_clk_arb_init_session(struct gk20a *g,
 	session->target = &session->target_pool[0];
 
 	nvgpu_init_list_node(&session->targets);
+	nvgpu_init_list_node(&session->pending);
 	nvgpu_spinlock_init(&session->session_lock);
 
 	nvgpu_spinlock_acquire(&arb->sessions_lock);
@@ -880,6 +928,11 @@ void nvgpu_clk_arb_free_session(struct nvgpu_ref *refcount)
 	if (arb) {
 		nvgpu_spinlock_acquire(&arb->sessions_lock);
 		nvgpu_list_del(&session->link);
+		nvgpu_spinlock_acquire(&arb->pending_lock);
+		if (!nvgpu_list_empty(&session->pending))
+			nvgpu_list_del(&session->pending);
+		nvgpu_spinlock_release(&arb->pending_lock);
+		nvgpu_clk_arb_agg_free_slot(&arb->agg, session->slot);
 		nvgpu_spinlock_release(&arb->sessions_lock);
 	}
 
@@ -902,11 +955,96 @@ void nvgpu_clk_arb_release_session(struct gk20a *g,
 	clk_arb_dbg(g, " ");
 
 	session->zombie = true;
+	if (arb)
+		nvgpu_clk_arb_session_post(arb, session);
 	nvgpu_ref_put(&session->refcount, nvgpu_clk_arb_free_session);
 	if (arb)
 		nvgpu_clk_arb_worker_enqueue(g, &arb->update_arb_work_item);
 }
 
+/*
+ * Queue a session for the next arbiter run. Only queued sessions are
+ * looked at, the others keep their slot in the aggregation tree.
+ */
+void nvgpu_clk_arb_session_post(struct nvgpu_clk_arb *arb,
+	struct nvgpu_clk_session *session)
+{
+	nvgpu_spinlock_acquire(&arb->pending_lock);
+	if (nvgpu_list_empty(&session->pending))
+		nvgpu_list_add_tail(&session->pending, &arb->pending);
+	nvgpu_spinlock_release(&arb->pending_lock);
+}
+
+/*
+ * Pick up the latest committed request of every queued session and return
+ * the max target over all sessions. Sessions without an explicit request
+ * contribute 0.
+ */
+void nvgpu_clk_arb_aggregate_targets(struct nvgpu_clk_arb *arb,
+	u16 *gpc2clk_target, u16 *mclk_target)
+{
+	struct nvgpu_clk_session *session;
+	struct nvgpu_clk_dev *dev;
+	struct nvgpu_clk_dev *tmp;
+	struct nvgpu_clk_arb_target *target;
+	bool mclk_set, gpc2clk_set;
+
+	nvgpu_spinlock_acquire(&arb->sessions_lock);
+	while (true) {
+		nvgpu_spinlock_acquire(&arb->pending_lock);
+		if (nvgpu_list_empty(&arb->pending)) {
+			nvgpu_spinlock_release(&arb->pending_lock);
+			break;
+		}
+		session = nvgpu_list_first_entry(&arb->pending,
+				nvgpu_clk_session, pending);
+		nvgpu_list_del(&session->pending);
+		nvgpu_spinlock_release(&arb->pending_lock);
+
+		if (session->zombie) {
+			nvgpu_clk_arb_agg_set(&arb->agg, session->slot, 0, 0);
+			continue;
+		}
+
+		mclk_set = false;
+		gpc2clk_set = false;
+		target = (session->target == &session->target_pool[0] ?
+				&session->target_pool[1] :
+				&session->target_pool[0]);
+		nvgpu_spinlock_acquire(&session->session_lock);
+		if (!nvgpu_list_empty(&session->targets)) {
+			/* Copy over state */
+			target->mclk = session->target->mclk;
+			target->gpc2clk = session->target->gpc2clk;
+			/* Query the latest committed request */
+			nvgpu_list_for_each_entry_safe(dev, tmp,
+				&session->targets, nvgpu_clk_dev, node) {
+				if (!mclk_set && dev->mclk_target_mhz) {
+					target->mclk = dev->mclk_target_mhz;
+					mclk_set = true;
+				}
+				if (!gpc2clk_set && dev->gpc2clk_target_mhz) {
+					target->gpc2clk =
+						dev->gpc2clk_target_mhz;
+					gpc2clk_set = true;
+				}
+				nvgpu_ref_get(&dev->refcount);
+				nvgpu_list_del(&dev->node);
+				nvgpu_spinlock_acquire(&arb->requests_lock);
+				nvgpu_list_add(&dev->node, &arb->requests);
+				nvgpu_spinlock_release(&arb->requests_lock);
+			}
+			session->target = target;
+		}
+		nvgpu_spinlock_release(&session->session_lock);
+
+		nvgpu_clk_arb_agg_set(&arb->agg, session->slot,
+			session->target->gpc2clk, session->target->mclk);
+	}
+	nvgpu_clk_arb_agg_max(&arb->agg, gpc2clk_target, mclk_target);
+	nvgpu_spinlock_release(&arb->sessions_lock);
+}
+
 void nvgpu_clk_arb_schedule_vf_table_update(struct gk20a *g)
 {
 	struct nvgpu_clk_arb *arb = g->clk_arb;
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <nvgpu/bitops.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/clk_arb.h>
+#include <nvgpu/gk20a.h>
+
+#define CLK_ARB_AGG_INIT_SLOTS	64U
+
+static void clk_arb_agg_free_arrays(struct gk20a *g, unsigned long *slots,
+	u16 *gpc2clk, u16 *mclk)
+{
+	nvgpu_kfree(g, slots);
+	nvgpu_kfree(g, gpc2clk);
+	nvgpu_kfree(g, mclk);
+}
+
+static int clk_arb_agg_alloc_arrays(struct gk20a *g, u32 nr_slots,
+	unsigned long **slots, u16 **gpc2clk, u16 **mclk)
+{
+	*slots = nvgpu_kcalloc(g, BITS_TO_LONGS(nr_slots),
+			sizeof(unsigned long));
+	*gpc2clk = nvgpu_kcalloc(g, 2U * nr_slots, sizeof(u16));
+	*mclk = nvgpu_kcalloc(g, 2U * nr_slots, sizeof(u16));
+
+	if (*slots == NULL || *gpc2clk == NULL || *mclk == NULL) {
+		clk_arb_agg_free_arrays(g, *slots, *gpc2clk, *mclk);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/*
+ * Walk from a leaf towards the root. Once a node keeps its value none of
+ * its ancestors can change either.
+ */
+static bool clk_arb_agg_propagate(u16 *tree, u32 nr_slots, u32 slot)
+{
+	u32 i = nr_slots + slot;
+	u16 val;
+
+	while (i > 1U) {
+		i >>= 1;
+		val = max(tree[2U * i], tree[2U * i + 1U]);
+		if (tree[i] == val) {
+			return false;
+		}
+		tree[i] = val;
+	}
+
+	return true;
+}
+
+static void clk_arb_agg_rebuild(u16 *tree, u32 nr_slots)
+{
+	u32 i;
+
+	for (i = nr_slots - 1U; i > 0U; i--) {
+		tree[i] = max(tree[2U * i], tree[2U * i + 1U]);
+	}
+}
+
+int nvgpu_clk_arb_agg_init(struct gk20a *g, struct nvgpu_clk_arb_agg *agg)
+{
+	int err;
+
+	err = clk_arb_agg_alloc_arrays(g, CLK_ARB_AGG_INIT_SLOTS,
+			&agg->slots, &agg->gpc2clk, &agg->mclk);
+	if (err != 0) {
+		return err;
+	}
+
+	nvgpu_spinlock_init(&agg->lock);
+	agg->nr_slots = CLK_ARB_AGG_INIT_SLOTS;
+
+	return 0;
+}
+
+void nvgpu_clk_arb_agg_deinit(struct gk20a *g, struct nvgpu_clk_arb_agg *agg)
+{
+	clk_arb_agg_free_arrays(g, agg->slots, agg->gpc2clk, agg->mclk);
+	agg->slots = NULL;
+	agg->gpc2clk = NULL;
+	agg->mclk = NULL;
+	agg->nr_slots = 0U;
+}
+
+/*
+ * The tree is walked by the arbiter under a spinlock, so a full tree is
+ * doubled with the lock dropped and swapped in only if nobody else grew it
+ * in the meantime.
+ */
+int nvgpu_clk_arb_agg_alloc_slot(struct gk20a *g,
+	struct nvgpu_clk_arb_agg *agg, u32 *slot)
+{
+	unsigned long *slots, *old_slots;
+	u16 *gpc2clk, *mclk, *old_gpc2clk, *old_mclk;
+	unsigned long bit;
+	u32 nr_slots, i;
+	int err;
+
+	while (true) {
+		nvgpu_spinlock_acquire(&agg->lock);
+		nr_slots = agg->nr_slots;
+		bit = find_first_zero_bit(agg->slots, nr_slots);
+		if (bit < nr_slots) {
+			set_bit((int)bit, agg->slots);
+			nvgpu_spinlock_release(&agg->lock);
+			*slot = (u32)bit;
+			return 0;
+		}
+		nvgpu_spinlock_release(&agg->lock);
+
+		err = clk_arb_agg_alloc_arrays(g, 2U * nr_slots,
+				&slots, &gpc2clk, &mclk);
+		if (err != 0) {
+			return err;
+		}
+
+		nvgpu_spinlock_acquire(&agg->lock);
+		if (agg->nr_slots == nr_slots) {
+			for (i = 0U; i < BITS_TO_LONGS(nr_slots); i++) {
+				slots[i] = agg->slots[i];
+			}
+			for (i = 0U; i < nr_slots; i++) {
+				gpc2clk[2U * nr_slots + i] =
+					agg->gpc2clk[nr_slots + i];
+				mclk[2U * nr_slots + i] =
+					agg->mclk[nr_slots + i];
+			}
+			clk_arb_agg_rebuild(gpc2clk, 2U * nr_slots);
+			clk_arb_agg_rebuild(mclk, 2U * nr_slots);
+
+			old_slots = agg->slots;
+			old_gpc2clk = agg->gpc2clk;
+			old_mclk = agg->mclk;
+			agg->slots = slots;
+			agg->gpc2clk = gpc2clk;
+			agg->mclk = mclk;
+			agg->nr_slots = 2U * nr_slots;
+		} else {
+			old_slots = slots;
+			old_gpc2clk = gpc2clk;
+			old_mclk = mclk;
+		}
+		nvgpu_spinlock_release(&agg->lock);
+
+		clk_arb_agg_free_arrays(g, old_slots, old_gpc2clk, old_mclk);
+	}
+}
+
+void nvgpu_clk_arb_agg_free_slot(struct nvgpu_clk_arb_agg *agg, u32 slot)
+{
+	nvgpu_spinlock_acquire(&agg->lock);
+	agg->gpc2clk[agg->nr_slots + slot] = 0;
+	agg->mclk[agg->nr_slots + slot] = 0;
+	clk_arb_agg_propagate(agg->gpc2clk, agg->nr_slots, slot);
+	clk_arb_agg_propagate(agg->mclk, agg->nr_slots, slot);
+	clear_bit((int)slot, agg->slots);
+	nvgpu_spinlock_release(&agg->lock);
+}
+
+/*
+ * Update the targets of one slot. Returns true if the aggregate of either
+ * domain moved.
+ */
+bool nvgpu_clk_arb_agg_set(struct nvgpu_clk_arb_agg *agg, u32 slot,
+	u16 gpc2clk, u16 mclk)
+{
+	bool changed;
+
+	nvgpu_spinlock_acquire(&agg->lock);
+	agg->gpc2clk[agg->nr_slots + slot] = gpc2clk;
+	agg->mclk[agg->nr_slots + slot] = mclk;
+	changed = clk_arb_agg_propagate(agg->gpc2clk, agg->nr_slots, slot);
+	changed = clk_arb_agg_propagate(agg->mclk, agg->nr_slots, slot) ||
+		changed;
+	nvgpu_spinlock_release(&agg->lock);
+
+	return changed;
+}
+
+void nvgpu_clk_arb_agg_max(struct nvgpu_clk_arb_agg *agg,
+	u16 *gpc2clk, u16 *mclk)
+{
+	nvgpu_spinlock_acquire(&agg->lock);
+	*gpc2clk = agg->gpc2clk[1];
+	*mclk = agg->mclk[1];
+	nvgpu_spinlock_release(&agg->lock);
+}
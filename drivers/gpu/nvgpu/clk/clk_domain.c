@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -1664,3 +1664,208 @@ int clk_domain_clk_prog_link(struct gk20a *g, struct clk_pmupstate *pclk)
 done:
 	return status;
 }
+
+static u32 clk_vf_curve_hash(const struct clk_vf_curve *curve)
+{
+	u32 hash = 0x811c9dc5U;
+	u16 i;
+
+	for (i = 0; i < curve->num_points; i++) {
+		hash = (hash ^ curve->mhz[i]) * 0x01000193U;
+		hash = (hash ^ curve->uv[i]) * 0x01000193U;
+	}
+	for (i = 0; i < curve->num_segs; i++) {
+		hash = (hash ^ curve->seg_end[i]) * 0x01000193U;
+	}
+
+	return hash;
+}
+
+static int clk_vf_curve_build(struct gk20a *g, struct clk_pmupstate *pclk,
+			      struct clk_domain *pdomain,
+			      struct clk_vf_curve *curve)
+{
+	struct clk_domain_3x_master *p3xmaster =
+		(struct clk_domain_3x_master *)pdomain;
+	struct clk_prog_1x_master *pprog1xmaster;
+	struct ctrl_clk_clk_prog_1x_master_vf_entry *pvfentry;
+	struct clk_vf_point *pvfpoint;
+	struct clk_prog *pprog;
+	u16 n = 0;
+	u8 segs = 0;
+	u32 i, j;
+
+	if (curve->rail >= pclk->clk_progobjs.vf_entry_count) {
+		return -EINVAL;
+	}
+
+	for (i = p3xmaster->super.clk_prog_idx_first;
+	     i <= p3xmaster->super.clk_prog_idx_last; i++) {
+		pprog = CLK_CLK_PROG_GET(pclk, i);
+		if (!pprog->super.implements(g, &pprog->super,
+				CTRL_CLK_CLK_PROG_TYPE_1X_MASTER)) {
+			return -EINVAL;
+		}
+
+		if (segs == CLK_VF_CURVE_MAX_SEGS) {
+			return -ENOSPC;
+		}
+
+		pprog1xmaster = (struct clk_prog_1x_master *)pprog;
+		pvfentry = &pprog1xmaster->p_vf_entries[curve->rail];
+
+		for (j = pvfentry->vf_point_idx_first;
+		     j <= pvfentry->vf_point_idx_last; j++) {
+			if (n == CLK_VF_CURVE_MAX_POINTS) {
+				return -ENOSPC;
+			}
+
+			pvfpoint = CLK_CLK_VF_POINT_GET(pclk, j);
+			curve->mhz[n] = clkvfpointfreqmhzget(g, pvfpoint);
+			curve->uv[n] = clkvfpointvoltageuvget(g, pvfpoint);
+
+			/* binary search needs each segment sorted by freq */
+			if ((j != pvfentry->vf_point_idx_first) &&
+			    (curve->mhz[n] < curve->mhz[n - 1U])) {
+				return -EINVAL;
+			}
+			n++;
+		}
+
+		curve->seg_end[segs++] = n;
+	}
+
+	curve->num_points = n;
+	curve->num_segs = segs;
+
+	return 0;
+}
+
+struct clk_vf_curve *clk_vf_lookup_curve(struct clk_vf_lookup *lookup,
+					 u32 clkapidomain, u8 rail)
+{
+	u32 i;
+
+	for (i = 0; i < lookup->num_curves; i++) {
+		if ((lookup->curves[i].api_domain == clkapidomain) &&
+		    (lookup->curves[i].rail == rail)) {
+			return &lookup->curves[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Rebuild the LOGIC and SRAM curves of one domain from the current VF points.
+ * @changed is cleared only when both curves match the previous build, so the
+ * caller can leave the tables derived from an unchanged domain alone.
+ */
+int clk_vf_lookup_refresh(struct gk20a *g, struct clk_vf_lookup *lookup,
+			  u32 clkapidomain, bool *changed)
+{
+	static const u8 rails[] = {
+		CLK_PROG_VFE_ENTRY_LOGIC, CLK_PROG_VFE_ENTRY_SRAM
+	};
+	struct clk_pmupstate *pclk = &g->clk_pmu;
+	struct clk_domain *pdomain = NULL;
+	struct clk_domain *pcur;
+	struct clk_vf_curve *curve;
+	u32 old_hash;
+	bool was_valid;
+	u32 i;
+	u8 idx;
+
+	*changed = false;
+
+	BOARDOBJGRP_FOR_EACH(&(pclk->clk_domainobjs.super.super),
+			struct clk_domain *, pcur, idx) {
+		if (pcur->api_domain == clkapidomain) {
+			pdomain = pcur;
+			break;
+		}
+	}
+	if (pdomain == NULL) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(rails); i++) {
+		curve = clk_vf_lookup_curve(lookup, clkapidomain, rails[i]);
+		if (curve == NULL) {
+			if (lookup->num_curves == CLK_VF_LOOKUP_MAX_CURVES) {
+				return -ENOSPC;
+			}
+			curve = &lookup->curves[lookup->num_curves++];
+			curve->api_domain = clkapidomain;
+			curve->rail = rails[i];
+			curve->valid = false;
+		}
+
+		old_hash = curve->hash;
+		was_valid = curve->valid;
+
+		/*
+		 * Slave and fixed domains keep going through
+		 * clk_domain_get_f_or_v().
+		 */
+		curve->valid = (pdomain->clkdomainclkvfsearch ==
+					clkdomainvfsearch) &&
+			!pdomain->super.implements(g, &pdomain->super,
+				CTRL_CLK_CLK_DOMAIN_TYPE_3X_SLAVE) &&
+			(clk_vf_curve_build(g, pclk, pdomain, curve) == 0);
+
+		if (curve->valid) {
+			curve->hash = clk_vf_curve_hash(curve);
+		}
+
+		/* a curve that could not be built can not be compared */
+		if (!curve->valid || !was_valid ||
+		    (curve->hash != old_hash)) {
+			*changed = true;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Voltage for @clkmhz: the first segment whose top point reaches @clkmhz
+ * supplies the lowest point at or above it, as vflookup_prog_1x_master()
+ * does with its linear scan.
+ */
+int clk_vf_curve_f_to_v(const struct clk_vf_curve *curve, u16 clkmhz,
+			u32 *pvoltuv)
+{
+	u16 start = 0;
+	u16 lo, hi, mid;
+	u8 s;
+
+	if (!curve->valid || (clkmhz == 0U)) {
+		return -EINVAL;
+	}
+
+	for (s = 0; s < curve->num_segs; start = curve->seg_end[s++]) {
+		if ((curve->seg_end[s] == start) ||
+		    (clkmhz > curve->mhz[curve->seg_end[s] - 1U])) {
+			continue;
+		}
+
+		lo = start;
+		hi = curve->seg_end[s] - 1U;
+		while (lo < hi) {
+			mid = lo + ((hi - lo) / 2U);
+			if (curve->mhz[mid] >= clkmhz) {
+				hi = mid;
+			} else {
+				lo = mid + 1U;
+			}
+		}
+
+		if (curve->uv[lo] != 0U) {
+			*pvoltuv = curve->uv[lo];
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
@@ -1,5 +1,5 @@
 /*
-* Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+* Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
 *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -154,4 +154,37 @@ int clk_domain_clk_prog_link(struct gk20a *g, struct clk_pmupstate *pclk);
 	((struct clk_domain *)BOARDOBJGRP_OBJ_GET_BY_IDX(		\
 		&pclk->clk_domainobjs.super.super, (u8)(idx)))
 
+#define CLK_VF_CURVE_MAX_POINTS		CTRL_BOARDOBJGRP_E255_MAX_OBJECTS
+#define CLK_VF_CURVE_MAX_SEGS		8U
+#define CLK_VF_LOOKUP_MAX_CURVES	4U
+
+/*
+ * Flattened copy of one master domain's VF curve for one rail. Each segment
+ * holds the VF points of one CLK_PROG, in the order clkdomainvfsearch()
+ * visits them, so lookups return the same voltage as the boardobj walk.
+ */
+struct clk_vf_curve {
+	u32 api_domain;
+	u8 rail;
+	bool valid;
+	u8 num_segs;
+	u16 num_points;
+	u32 hash;
+	u16 seg_end[CLK_VF_CURVE_MAX_SEGS];
+	u16 mhz[CLK_VF_CURVE_MAX_POINTS];
+	u32 uv[CLK_VF_CURVE_MAX_POINTS];
+};
+
+struct clk_vf_lookup {
+	u32 num_curves;
+	struct clk_vf_curve curves[CLK_VF_LOOKUP_MAX_CURVES];
+};
+
+int clk_vf_lookup_refresh(struct gk20a *g, struct clk_vf_lookup *lookup,
+			  u32 clkapidomain, bool *changed);
+struct clk_vf_curve *clk_vf_lookup_curve(struct clk_vf_lookup *lookup,
+					 u32 clkapidomain, u8 rail);
+int clk_vf_curve_f_to_v(const struct clk_vf_curve *curve, u16 clkmhz,
+			u32 *pvoltuv);
+
 #endif /* NVGPU_CLK_DOMAIN_H */
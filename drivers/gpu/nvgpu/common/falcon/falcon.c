@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2017-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -255,6 +255,13 @@ int nvgpu_flcn_copy_from_dmem(struct nvgpu_falcon *flcn,
 	return flcn_ops->copy_from_dmem(flcn, src, dst, size, port);
 }
 
+/*
+ * IMEM/DMEM loads stay on the IMEMD/DMEMD ports. A DMATRF path needs the
+ * falcon bound to an instance block with a ctxdma, and none of the large
+ * loads have one: devinit, minion and nvdec mem_unlock all run before it
+ * exists. The PMU copies made after boot are small, secure, or go to a
+ * running falcon whose DMA engine belongs to the ucode.
+ */
 int nvgpu_flcn_copy_to_dmem(struct nvgpu_falcon *flcn,
 	u32 dst, u8 *src, u32 size, u8 port)
 {
@@ -146,9 +146,11 @@ int gv100_fb_memory_unlock(struct gk20a *g)
 	 * traps even if VPR isn’t actually supported
 	 */
 	if (!g->ops.pmu.is_debug_mode_enabled(g)) {
-		mem_unlock_fw = nvgpu_request_firmware(g, MEM_UNLOCK_PROD_BIN, 0);
+		mem_unlock_fw = nvgpu_request_firmware(g, MEM_UNLOCK_PROD_BIN,
+				NVGPU_REQUEST_FIRMWARE_CACHE);
 	} else {
-		mem_unlock_fw = nvgpu_request_firmware(g, MEM_UNLOCK_DBG_BIN, 0);
+		mem_unlock_fw = nvgpu_request_firmware(g, MEM_UNLOCK_DBG_BIN,
+				NVGPU_REQUEST_FIRMWARE_CACHE);
 	}
 	if (!mem_unlock_fw) {
 		nvgpu_err(g, "mem unlock ucode get fail");
@@ -512,6 +512,9 @@ unbind:
 	ch->ref_actions_put = 0;
 #endif
 
+	nvgpu_atomic_set(&ch->trace.put, 0);
+	memset(ch->trace.ents, 0, sizeof(ch->trace.ents));
+
 	nvgpu_cond_destroy(&ch->notifier_wq);
 	nvgpu_cond_destroy(&ch->semaphore_wq);
 
@@ -524,6 +527,54 @@ unbind:
 	free_channel(f, ch);
 }
 
+static const char *nvgpu_channel_trace_event_name(u32 type)
+{
+	switch (type) {
+	case NVGPU_CHANNEL_TRACE_SUBMIT:
+		return "submit";
+	case NVGPU_CHANNEL_TRACE_JOB_ADD:
+		return "job_add";
+	case NVGPU_CHANNEL_TRACE_FENCE_DONE:
+		return "fence_done";
+	case NVGPU_CHANNEL_TRACE_CLEANUP:
+		return "cleanup";
+	case NVGPU_CHANNEL_TRACE_TIMEOUT:
+		return "timeout";
+	default:
+		return "?";
+	}
+}
+
+/*
+ * Print the event history of a channel, oldest first. With a NULL output the
+ * history goes to the kernel log.
+ */
+void nvgpu_channel_trace_dump(struct channel_gk20a *ch,
+		struct gk20a_debug_output *o)
+{
+	struct gk20a *g = ch->g;
+	u32 put = (u32)nvgpu_atomic_read(&ch->trace.put);
+	u32 n = min(put, NVGPU_CHANNEL_TRACE_ENTRIES);
+	u32 i;
+
+	for (i = put - n; i != put; i++) {
+		const struct nvgpu_channel_trace_event *ev = &ch->trace.ents[
+			i & (NVGPU_CHANNEL_TRACE_ENTRIES - 1U)];
+
+		if (o != NULL) {
+			gk20a_debug_output(o, "ch %d: %llu %s %u 0x%llx\n",
+				ch->chid, ev->timestamp,
+				nvgpu_channel_trace_event_name(ev->type),
+				ev->arg0, ev->arg1);
+		} else {
+			nvgpu_err(g, "ch %d: %llu %s %u 0x%llx",
+				ch->chid, ev->timestamp,
+				nvgpu_channel_trace_event_name(ev->type),
+				ev->arg0, ev->arg1);
+		}
+	}
+}
+
 static void gk20a_channel_dump_ref_actions(struct channel_gk20a *ch)
 {
 #if GK20A_CHANNEL_REFCOUNT_TRACKING
@@ -1572,8 +1623,12 @@ static void gk20a_channel_timeout_handler(struct channel_gk20a *ch)
 		nvgpu_err(g, "Job on channel %d timed out",
 			  ch->chid);
 
+		nvgpu_channel_trace_record(ch, NVGPU_CHANNEL_TRACE_TIMEOUT,
+			new_gp_get, new_pb_get);
+
 		/* force reset calls gk20a_debug_dump but not this */
 		if (ch->timeout.debug_dump) {
+			nvgpu_channel_trace_dump(ch, NULL);
 			gk20a_gr_debug_dump(g);
 		}
 
@@ -1957,6 +2012,12 @@ int gk20a_channel_add_job(struct channel_gk20a *c,
 		 */
 		nvgpu_smp_wmb();
 		channel_gk20a_joblist_add(c, job);
+		nvgpu_atomic_inc(&c->g->fifo.activity.jobs);
+		if (job->wait_cmd != NULL && job->wait_cmd->valid) {
+			nvgpu_atomic_inc(&c->g->fifo.activity.waits);
+		}
+		nvgpu_channel_trace_record(c, NVGPU_CHANNEL_TRACE_JOB_ADD,
+			(u32)num_mapped_buffers, c->gpfifo.put);
 
 		if (!pre_alloc_enabled) {
 			channel_gk20a_joblist_unlock(c);
@@ -1992,6 +2053,7 @@ void gk20a_channel_clean_up_jobs(struct channel_gk20a *c,
 	struct gk20a *g;
 	bool job_finished = false;
 	bool watchdog_on = false;
+	u32 jobs_cleaned = 0;
 
 	c = gk20a_channel_get(c);
 	if (c == NULL) {
@@ -2040,7 +2102,12 @@ void gk20a_channel_clean_up_jobs(struct channel_gk20a *c,
 		channel_gk20a_joblist_unlock(c);
 
 		completed = gk20a_fence_is_expired(job->post_fence);
-		if (!completed) {
+		if (completed) {
+			nvgpu_channel_trace_record(c,
+				NVGPU_CHANNEL_TRACE_FENCE_DONE,
+				job->post_fence->syncpt_id,
+				job->post_fence->syncpt_value);
+		} else {
 			/*
 			 * The watchdog eventually sees an updated gp_get if
 			 * something happened in this loop. A new job can have
@@ -2092,6 +2159,11 @@ void gk20a_channel_clean_up_jobs(struct channel_gk20a *c,
 		 * it to the pool). */
 		gk20a_fence_put(job->post_fence);
 
+		nvgpu_atomic_dec(&g->fifo.activity.jobs);
+		if (job->wait_cmd != NULL && job->wait_cmd->valid) {
+			nvgpu_atomic_dec(&g->fifo.activity.waits);
+		}
+
 		/* Free the private command buffers (wait_cmd first and
 		 * then incr_cmd i.e. order of allocation) */
 		gk20a_free_priv_cmdbuf(c, job->wait_cmd);
@@ -2109,6 +2181,7 @@ void gk20a_channel_clean_up_jobs(struct channel_gk20a *c,
 
 		channel_gk20a_free_job(c, job);
 		job_finished = true;
+		jobs_cleaned++;
 
 		/*
 		 * Deterministic channels have a channel-wide power reference;
@@ -2126,6 +2199,11 @@ void gk20a_channel_clean_up_jobs(struct channel_gk20a *c,
 
 	nvgpu_mutex_release(&c->joblist.cleanup_lock);
 
+	if (jobs_cleaned > 0U) {
+		nvgpu_channel_trace_record(c, NVGPU_CHANNEL_TRACE_CLEANUP,
+			jobs_cleaned, clean_all ? 1ULL : 0ULL);
+	}
+
 	if ((job_finished) &&
 			(g->os_channel.work_completion_signal != NULL)) {
 		g->os_channel.work_completion_signal(c);
@@ -497,8 +497,9 @@ static int nvgpu_submit_channel_gpfifo(struct channel_gk20a *c,
 					  fence ? fence->id : 0,
 					  fence ? fence->value : 0);
 
-	nvgpu_log_info(g, "pre-submit put %d, get %d, size %d",
-		c->gpfifo.put, c->gpfifo.get, c->gpfifo.entry_num);
+	nvgpu_log_bin(g, gpu_dbg_info,
+		"pre-submit ch %llu put %llu, get %llu, size %llu",
+		c->chid, c->gpfifo.put, c->gpfifo.get, c->gpfifo.entry_num);
 
 	/*
 	 * Make sure we have enough space for gpfifo entries. Check cached
@@ -570,6 +571,9 @@ static int nvgpu_submit_channel_gpfifo(struct channel_gk20a *c,
 		nvgpu_rwsem_up_read(&g->deterministic_busy);
 	}
 
+	nvgpu_channel_trace_record(c, NVGPU_CHANNEL_TRACE_SUBMIT,
+		num_entries, c->gpfifo.put);
+
 	trace_gk20a_channel_submitted_gpfifo(g->name,
 				c->chid,
 				num_entries,
@@ -577,8 +581,11 @@ static int nvgpu_submit_channel_gpfifo(struct channel_gk20a *c,
 				post_fence ? post_fence->syncpt_id : 0,
 				post_fence ? post_fence->syncpt_value : 0);
 
-	nvgpu_log_info(g, "post-submit put %d, get %d, size %d",
-		c->gpfifo.put, c->gpfifo.get, c->gpfifo.entry_num);
+	nvgpu_log_bin(g, gpu_dbg_info,
+		"post-submit ch %llu put %llu, get %llu, size %llu",
+		c->chid, c->gpfifo.put, c->gpfifo.get, c->gpfifo.entry_num);
+
+	nvgpu_atomic64_inc(&g->fifo.activity.submits);
 
 	gk20a_fifo_profile_snapshot(profile, PROFILE_END);
 
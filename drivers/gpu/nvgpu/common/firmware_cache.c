@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <nvgpu/firmware.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/log.h>
+#include <nvgpu/gk20a.h>
+
+/*
+ * FNV-1a over the image. This only has to catch accidental corruption of the
+ * cached copy; the falcons authenticate the ucode themselves.
+ */
+static u32 nvgpu_firmware_cache_hash(const u8 *data, size_t size)
+{
+	u32 hash = 0x811c9dc5U;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 0x01000193U;
+	}
+
+	return hash;
+}
+
+static u32 nvgpu_firmware_cache_chip(struct gk20a *g)
+{
+	return g->params.gpu_arch + g->params.gpu_impl;
+}
+
+static struct nvgpu_firmware_cache_entry *nvgpu_firmware_cache_find(
+	struct gk20a *g, const char *fw_name)
+{
+	struct nvgpu_firmware_cache *cache = &g->fw_cache;
+	struct nvgpu_firmware_cache_entry *entry;
+
+	nvgpu_list_for_each_entry(entry, &cache->entries,
+			nvgpu_firmware_cache_entry, list) {
+		if (strncmp(entry->name, fw_name, sizeof(entry->name)) == 0) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static void nvgpu_firmware_cache_free_entry(struct gk20a *g,
+	struct nvgpu_firmware_cache_entry *entry)
+{
+	g->fw_cache.bytes -= entry->size;
+	nvgpu_list_del(&entry->list);
+	nvgpu_kfree(g, entry->data);
+	nvgpu_kfree(g, entry);
+}
+
+void nvgpu_firmware_cache_init(struct gk20a *g)
+{
+	struct nvgpu_firmware_cache *cache = &g->fw_cache;
+
+	nvgpu_mutex_init(&cache->lock);
+	nvgpu_init_list_node(&cache->entries);
+	cache->bytes = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+}
+
+struct nvgpu_firmware *nvgpu_firmware_cache_get(struct gk20a *g,
+						const char *fw_name)
+{
+	struct nvgpu_firmware_cache *cache = &g->fw_cache;
+	struct nvgpu_firmware_cache_entry *entry;
+	struct nvgpu_firmware *fw = NULL;
+	size_t size;
+
+	nvgpu_mutex_acquire(&cache->lock);
+
+	entry = nvgpu_firmware_cache_find(g, fw_name);
+	if (entry == NULL) {
+		goto miss;
+	}
+
+	if (entry->chip != nvgpu_firmware_cache_chip(g) ||
+	    entry->hash != nvgpu_firmware_cache_hash(entry->data,
+						       entry->size)) {
+		nvgpu_warn(g, "dropping stale cached firmware %s", fw_name);
+		nvgpu_firmware_cache_free_entry(g, entry);
+		goto miss;
+	}
+
+	size = entry->size;
+
+	/*
+	 * Allocate with the lock dropped: the memory-pressure hook takes it
+	 * from reclaim context.
+	 */
+	nvgpu_mutex_release(&cache->lock);
+
+	fw = nvgpu_kzalloc(g, sizeof(*fw));
+	if (fw == NULL) {
+		return NULL;
+	}
+
+	fw->data = nvgpu_kmalloc(g, size);
+	if (fw->data == NULL) {
+		nvgpu_kfree(g, fw);
+		return NULL;
+	}
+
+	nvgpu_mutex_acquire(&cache->lock);
+
+	/* the entry may have been released or replaced meanwhile */
+	entry = nvgpu_firmware_cache_find(g, fw_name);
+	if (entry == NULL || entry->size != size) {
+		nvgpu_kfree(g, fw->data);
+		nvgpu_kfree(g, fw);
+		goto miss;
+	}
+
+	memcpy(fw->data, entry->data, size);
+	fw->size = size;
+	cache->hits++;
+
+	nvgpu_mutex_release(&cache->lock);
+
+	nvgpu_log_info(g, "firmware %s served from cache", fw_name);
+	return fw;
+
+miss:
+	cache->misses++;
+	nvgpu_mutex_release(&cache->lock);
+	return NULL;
+}
+
+int nvgpu_firmware_cache_put(struct gk20a *g, const char *fw_name,
+			     const struct nvgpu_firmware *fw)
+{
+	struct nvgpu_firmware_cache *cache = &g->fw_cache;
+	struct nvgpu_firmware_cache_entry *entry, *old;
+
+	if (strlen(fw_name) >= NVGPU_FIRMWARE_CACHE_NAME_LEN) {
+		return -EINVAL;
+	}
+
+	entry = nvgpu_kzalloc(g, sizeof(*entry));
+	if (entry == NULL) {
+		return -ENOMEM;
+	}
+
+	entry->data = nvgpu_kmalloc(g, fw->size);
+	if (entry->data == NULL) {
+		nvgpu_kfree(g, entry);
+		return -ENOMEM;
+	}
+
+	memcpy(entry->data, fw->data, fw->size);
+	entry->size = fw->size;
+	entry->hash = nvgpu_firmware_cache_hash(entry->data, entry->size);
+	entry->chip = nvgpu_firmware_cache_chip(g);
+	(void)strncpy(entry->name, fw_name, sizeof(entry->name) - 1U);
+
+	nvgpu_mutex_acquire(&cache->lock);
+
+	old = nvgpu_firmware_cache_find(g, fw_name);
+	if (old != NULL) {
+		nvgpu_firmware_cache_free_entry(g, old);
+	}
+
+	nvgpu_list_add_tail(&entry->list, &cache->entries);
+	cache->bytes += entry->size;
+
+	nvgpu_mutex_release(&cache->lock);
+
+	return 0;
+}
+
+int nvgpu_firmware_cache_shrink(struct gk20a *g, size_t nr_bytes,
+				size_t *freed)
+{
+	struct nvgpu_firmware_cache *cache = &g->fw_cache;
+	struct nvgpu_firmware_cache_entry *entry, *tmp;
+	size_t start;
+
+	*freed = 0;
+
+	if (!nvgpu_mutex_tryacquire(&cache->lock)) {
+		return -EBUSY;
+	}
+
+	/* entries are added at the tail, so the oldest go first */
+	start = cache->bytes;
+	nvgpu_list_for_each_entry_safe(entry, tmp, &cache->entries,
+			nvgpu_firmware_cache_entry, list) {
+		if (start - cache->bytes >= nr_bytes) {
+			break;
+		}
+		nvgpu_firmware_cache_free_entry(g, entry);
+	}
+	*freed = start - cache->bytes;
+
+	nvgpu_mutex_release(&cache->lock);
+
+	return 0;
+}
+
+size_t nvgpu_firmware_cache_release(struct gk20a *g)
+{
+	struct nvgpu_firmware_cache *cache = &g->fw_cache;
+	struct nvgpu_firmware_cache_entry *entry, *tmp;
+	size_t freed;
+
+	nvgpu_mutex_acquire(&cache->lock);
+
+	freed = cache->bytes;
+	nvgpu_list_for_each_entry_safe(entry, tmp, &cache->entries,
+			nvgpu_firmware_cache_entry, list) {
+		nvgpu_firmware_cache_free_entry(g, entry);
+	}
+
+	nvgpu_mutex_release(&cache->lock);
+
+	if (freed != 0U) {
+		nvgpu_log_info(g, "released %zu bytes of cached firmware",
+			       freed);
+	}
+
+	return freed;
+}
+
+void nvgpu_firmware_cache_deinit(struct gk20a *g)
+{
+	nvgpu_firmware_cache_release(g);
+	nvgpu_mutex_destroy(&g->fw_cache.lock);
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <nvgpu/init_sched.h>
+#include <nvgpu/barrier.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/log.h>
+#include <nvgpu/gk20a.h>
+
+void nvgpu_init_sched_init(struct nvgpu_init_sched *sched, struct gk20a *g)
+{
+	(void) memset(sched, 0, sizeof(*sched));
+	sched->g = g;
+	sched->start_ns = nvgpu_current_time_ns();
+}
+
+int nvgpu_init_sched_add(struct nvgpu_init_sched *sched, const char *name,
+		int (*fn)(struct gk20a *g), u32 deps, u32 flags)
+{
+	struct nvgpu_init_stage *stage;
+	u32 idx = sched->nr_stages;
+
+	if (idx >= NVGPU_INIT_SCHED_MAX_STAGES) {
+		nvgpu_err(sched->g, "too many init stages, dropping %s", name);
+		return -ENOSPC;
+	}
+
+	/* a stage can only wait for stages added before it */
+	if ((deps & ~(BIT32(idx) - 1U)) != 0U) {
+		nvgpu_err(sched->g, "init stage %s: bad deps 0x%x", name, deps);
+		return -EINVAL;
+	}
+
+	stage = &sched->stages[idx];
+	(void) memset(stage, 0, sizeof(*stage));
+	stage->name = name;
+	stage->fn = fn;
+	stage->deps = deps;
+	stage->flags = flags;
+	stage->sched = sched;
+
+	sched->nr_stages++;
+
+	return (int)idx;
+}
+
+static void nvgpu_init_sched_exec(struct nvgpu_init_stage *stage)
+{
+	struct gk20a *g = stage->sched->g;
+
+	stage->start_ns = nvgpu_current_time_ns();
+	stage->err = stage->fn(g);
+	stage->end_ns = nvgpu_current_time_ns();
+
+	if (stage->err != 0) {
+		nvgpu_err(g, "init stage %s failed: %d",
+			stage->name, stage->err);
+	}
+}
+
+static int nvgpu_init_sched_worker(void *arg)
+{
+	struct nvgpu_init_stage *stage = arg;
+
+	nvgpu_init_sched_exec(stage);
+
+	/* publish err and timestamps before the finished flag */
+	nvgpu_smp_wmb();
+	NV_ACCESS_ONCE(stage->finished) = true;
+	(void) nvgpu_cond_broadcast(&stage->sched->wq);
+
+	return 0;
+}
+
+/* mask of the @running workers that have completed their stage */
+static u32 nvgpu_init_sched_finished(struct nvgpu_init_sched *sched,
+		u32 running)
+{
+	u32 finished = 0U;
+	u32 idx;
+
+	for (idx = sched->first_pending; idx < sched->nr_stages; idx++) {
+		if ((running & BIT32(idx)) != 0U &&
+			NV_ACCESS_ONCE(sched->stages[idx].finished)) {
+			finished |= BIT32(idx);
+		}
+	}
+
+	return finished;
+}
+
+/*
+ * Collect a worker. Callers first wait for its finished flag on the
+ * scheduler's condition, so the join only reclaims a thread that is
+ * already on its way out.
+ */
+static void nvgpu_init_sched_reap(struct nvgpu_init_sched *sched,
+		u32 idx, u32 *running, int *err)
+{
+	struct nvgpu_init_stage *stage = &sched->stages[idx];
+
+	(void) NVGPU_COND_WAIT(&sched->wq,
+			NV_ACCESS_ONCE(stage->finished), 0);
+	nvgpu_smp_rmb();
+	nvgpu_thread_join(&stage->worker);
+
+	*running &= ~BIT32(idx);
+	sched->done |= BIT32(idx);
+	if (stage->err != 0 && *err == 0) {
+		*err = stage->err;
+	}
+}
+
+/*
+ * Start a stage whose dependencies are all done. Returns true if the stage
+ * completed synchronously, false if it was handed to a worker thread.
+ */
+static bool nvgpu_init_sched_start(struct nvgpu_init_sched *sched, u32 idx,
+		u32 *running, int *err)
+{
+	struct nvgpu_init_stage *stage = &sched->stages[idx];
+	struct gk20a *g = sched->g;
+	char tname[32];
+
+	if (stage->fn == NULL) {
+		sched->done |= BIT32(idx);
+		return true;
+	}
+
+	if ((stage->flags & NVGPU_INIT_STAGE_PARALLEL) != 0U) {
+		(void) snprintf(tname, sizeof(tname), "nvgpu_init_%s",
+				stage->name);
+		if (nvgpu_thread_create(&stage->worker, stage,
+				nvgpu_init_sched_worker, tname) == 0) {
+			stage->on_worker = true;
+			*running |= BIT32(idx);
+			return false;
+		}
+		nvgpu_warn(g, "no worker for init stage %s, running inline",
+			stage->name);
+	}
+
+	nvgpu_init_sched_exec(stage);
+	stage->finished = true;
+	sched->done |= BIT32(idx);
+	if (stage->err != 0 && *err == 0) {
+		*err = stage->err;
+	}
+
+	return true;
+}
+
+int nvgpu_init_sched_run(struct nvgpu_init_sched *sched)
+{
+	struct gk20a *g = sched->g;
+	u32 first = sched->first_pending;
+	u32 started = 0U;
+	u32 running = 0U;
+	u32 all, done, idx;
+	bool progress;
+	int err;
+
+	err = nvgpu_cond_init(&sched->wq);
+	if (err != 0) {
+		return err;
+	}
+
+	all = (sched->nr_stages == 32U) ? U32_MAX :
+		(BIT32(sched->nr_stages) - 1U);
+	all &= ~(BIT32(first) - 1U);
+
+	while ((sched->done & all) != all) {
+		progress = false;
+
+		/* collect workers that are already done without blocking */
+		done = nvgpu_init_sched_finished(sched, running);
+		for (idx = first; idx < sched->nr_stages; idx++) {
+			if ((done & BIT32(idx)) != 0U) {
+				nvgpu_init_sched_reap(sched, idx,
+					&running, &err);
+				progress = true;
+			}
+		}
+
+		if (err != 0) {
+			break;
+		}
+
+		for (idx = first; idx < sched->nr_stages; idx++) {
+			struct nvgpu_init_stage *stage = &sched->stages[idx];
+
+			if ((started & BIT32(idx)) != 0U ||
+				(stage->deps & ~sched->done) != 0U) {
+				continue;
+			}
+
+			started |= BIT32(idx);
+			progress = true;
+
+			/*
+			 * An inline stage may have taken a while; rescan so
+			 * that its dependents and finished workers are picked
+			 * up in order.
+			 */
+			if (nvgpu_init_sched_start(sched, idx,
+					&running, &err)) {
+				break;
+			}
+		}
+
+		if (err != 0) {
+			break;
+		}
+
+		if (progress) {
+			continue;
+		}
+
+		if (running == 0U) {
+			nvgpu_err(g, "init stages 0x%x can not make progress",
+				all & ~sched->done);
+			err = -EINVAL;
+			break;
+		}
+
+		/* nothing runnable here, sleep until any worker is done */
+		(void) NVGPU_COND_WAIT(&sched->wq,
+				nvgpu_init_sched_finished(sched, running) != 0U,
+				0);
+	}
+
+	/* never leave a worker behind, even on error */
+	for (idx = first; idx < sched->nr_stages; idx++) {
+		if ((running & BIT32(idx)) != 0U) {
+			nvgpu_init_sched_reap(sched, idx, &running, &err);
+		}
+	}
+
+	sched->first_pending = sched->nr_stages;
+	nvgpu_cond_destroy(&sched->wq);
+
+	return err;
+}
+
+void nvgpu_init_sched_report(struct nvgpu_init_sched *sched)
+{
+	struct gk20a *g = sched->g;
+	struct nvgpu_init_stage *stage;
+	s64 end_ns = sched->start_ns;
+	u32 idx;
+
+	for (idx = 0U; idx < sched->nr_stages; idx++) {
+		stage = &sched->stages[idx];
+		if (stage->fn == NULL || !stage->finished) {
+			continue;
+		}
+
+		nvgpu_log_info(g, "%-12s %s start %8lld us, took %8lld us%s",
+			stage->name, stage->on_worker ? "worker" : "inline",
+			(stage->start_ns - sched->start_ns) / 1000,
+			(stage->end_ns - stage->start_ns) / 1000,
+			stage->err != 0 ? " (failed)" : "");
+
+		if (stage->end_ns > end_ns) {
+			end_ns = stage->end_ns;
+		}
+	}
+
+	nvgpu_log_info(g, "init stages done after %lld us",
+		(end_ns - sched->start_ns) / 1000);
+}
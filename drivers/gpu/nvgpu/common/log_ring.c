@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <nvgpu/log.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/atomic.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/debug.h>
+#include <nvgpu/gk20a.h>
+
+struct nvgpu_log_ring_entry {
+	u64 timestamp;
+	const char *func_name;
+	const char *fmt;
+	u32 line;
+	u64 args[4];
+};
+
+struct nvgpu_log_ring {
+	nvgpu_atomic_t put;
+	nvgpu_atomic_t dropped;
+	nvgpu_atomic_t window_count;
+	nvgpu_atomic64_t window_start_ms;
+	struct nvgpu_log_ring_entry ents[NVGPU_LOG_RING_ENTRIES];
+};
+
+int nvgpu_log_ring_init(struct gk20a *g)
+{
+	struct nvgpu_log_ring *ring;
+
+	if (g->log_ring != NULL) {
+		return 0;
+	}
+
+	ring = nvgpu_vzalloc(g, sizeof(*ring));
+	if (ring == NULL) {
+		return -ENOMEM;
+	}
+
+	g->log_ring = ring;
+
+	return 0;
+}
+
+void nvgpu_log_ring_deinit(struct gk20a *g)
+{
+	struct nvgpu_log_ring *ring = g->log_ring;
+
+	g->log_ring_mask = 0ULL;
+	g->log_ring = NULL;
+	nvgpu_vfree(g, ring);
+}
+
+/*
+ * Admit at most NVGPU_LOG_RING_WINDOW_LIMIT records per window. The window
+ * roll-over can race with a concurrent recorder, which at worst lets a few
+ * extra records through.
+ */
+static bool nvgpu_log_ring_admit(struct nvgpu_log_ring *ring)
+{
+	s64 now = nvgpu_current_time_ms();
+	long start = nvgpu_atomic64_read(&ring->window_start_ms);
+
+	if ((now - start) >= NVGPU_LOG_RING_WINDOW_MS) {
+		if (nvgpu_atomic64_cmpxchg(&ring->window_start_ms, start,
+				(long)now) == start) {
+			nvgpu_atomic_set(&ring->window_count, 0);
+		}
+	}
+
+	if ((u32)nvgpu_atomic_inc_return(&ring->window_count) >
+			NVGPU_LOG_RING_WINDOW_LIMIT) {
+		nvgpu_atomic_inc(&ring->dropped);
+		return false;
+	}
+
+	return true;
+}
+
+void __nvgpu_log_ring(struct gk20a *g, u64 log_mask,
+		      const char *func_name, int line, const char *fmt,
+		      u64 a0, u64 a1, u64 a2, u64 a3)
+{
+	struct nvgpu_log_ring *ring = g->log_ring;
+	struct nvgpu_log_ring_entry *ent;
+	u32 idx;
+
+	if (ring == NULL || (log_mask & g->log_ring_mask) == 0ULL) {
+		return;
+	}
+
+	if (!nvgpu_log_ring_admit(ring)) {
+		return;
+	}
+
+	idx = (u32)nvgpu_atomic_inc_return(&ring->put) - 1U;
+	ent = &ring->ents[idx & (NVGPU_LOG_RING_ENTRIES - 1U)];
+
+	ent->timestamp = nvgpu_hr_timestamp();
+	ent->func_name = func_name;
+	ent->fmt = fmt;
+	ent->line = (u32)line;
+	ent->args[0] = a0;
+	ent->args[1] = a1;
+	ent->args[2] = a2;
+	ent->args[3] = a3;
+}
+
+/*
+ * Print path of nvgpu_log_bin() for categories that are also enabled in the
+ * regular log mask. The record format always consumes four arguments.
+ */
+void __nvgpu_log_ring_dbg(struct gk20a *g, u64 log_mask,
+			  const char *func_name, int line, const char *fmt,
+			  u64 a0, u64 a1, u64 a2, u64 a3)
+{
+	__nvgpu_log_dbg(g, log_mask, func_name, line, fmt, a0, a1, a2, a3);
+}
+
+void nvgpu_log_ring_stats(struct gk20a *g, u32 *records, u32 *dropped)
+{
+	struct nvgpu_log_ring *ring = g->log_ring;
+
+	*records = 0U;
+	*dropped = 0U;
+	if (ring != NULL) {
+		*records = (u32)nvgpu_atomic_read(&ring->put);
+		*dropped = (u32)nvgpu_atomic_read(&ring->dropped);
+	}
+}
+
+/*
+ * Format record @seq, counted from the first record ever written, into @buf.
+ * Returns -ENOENT if that record has not been written yet or has already
+ * been overwritten.
+ */
+int nvgpu_log_ring_decode(struct gk20a *g, u32 seq, char *buf, size_t size)
+{
+	struct nvgpu_log_ring *ring = g->log_ring;
+	struct nvgpu_log_ring_entry *ent;
+	u32 put;
+	int len;
+
+	if (ring == NULL || size == 0U) {
+		return -ENOENT;
+	}
+
+	put = (u32)nvgpu_atomic_read(&ring->put);
+	if ((put - seq - 1U) >= min(put, NVGPU_LOG_RING_ENTRIES)) {
+		return -ENOENT;
+	}
+
+	ent = &ring->ents[seq & (NVGPU_LOG_RING_ENTRIES - 1U)];
+	if (ent->fmt == NULL) {
+		return -ENOENT;
+	}
+
+	len = snprintf(buf, size, "%llu %s:%u ", ent->timestamp,
+		ent->func_name, ent->line);
+	if (len >= 0 && (size_t)len < size) {
+		(void) snprintf(buf + len, size - (size_t)len, ent->fmt,
+			ent->args[0], ent->args[1], ent->args[2],
+			ent->args[3]);
+	}
+
+	return 0;
+}
+
+void nvgpu_log_ring_dump(struct gk20a *g, struct gk20a_debug_output *o)
+{
+	char line[160];
+	u32 put, dropped, n, i;
+
+	if (g->log_ring == NULL) {
+		return;
+	}
+
+	nvgpu_log_ring_stats(g, &put, &dropped);
+	n = min(put, NVGPU_LOG_RING_ENTRIES);
+
+	gk20a_debug_output(o, "records=%u dropped=%u\n", put, dropped);
+
+	for (i = put - n; i != put; i++) {
+		if (nvgpu_log_ring_decode(g, i, line, sizeof(line)) == 0) {
+			gk20a_debug_output(o, "%s\n", line);
+		}
+	}
+}
@@ -54,6 +54,21 @@
 		}							\
 	} while (0)
 
+/*
+ * Per-level mapping trace, hit for every PDE/PTE range of a map. Unless the
+ * mapping asked for debug prints it goes through the binary log ring.
+ */
+#define __gmmu_dbg_v_bin(g, attrs, fmt, a0, a1, a2, a3)		\
+	do {								\
+		if (attrs->debug) {					\
+			nvgpu_info(g, fmt, (u64)(a0), (u64)(a1),	\
+				   (u64)(a2), (u64)(a3));		\
+		} else {						\
+			nvgpu_log_bin(g, gpu_dbg_map_v, fmt,		\
+				      a0, a1, a2, a3);			\
+		}							\
+	} while (0)
+
 static int pd_allocate(struct vm_gk20a *vm,
 		       struct nvgpu_gmmu_pd *pd,
 		       const struct gk20a_mmu_level *l,
@@ -368,10 +383,9 @@ static int __set_pd_level(struct vm_gk20a *vm,
 
 	pde_range = 1ULL << (u64)l->lo_bit[attrs->pgsz];
 
-	__gmmu_dbg_v(g, attrs,
-		     "L=%d   %sGPU virt %#-12llx +%#-9llx -> phys %#-12llx",
+	__gmmu_dbg_v_bin(g, attrs,
+		     "L=%llu   GPU virt %#-12llx +%#-9llx -> phys %#-12llx",
 		     lvl,
-		     __lvl_debug[lvl],
 		     virt_addr,
 		     length,
 		     phys_addr);
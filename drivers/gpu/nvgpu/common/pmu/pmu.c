@@ -587,6 +587,7 @@ int nvgpu_pmu_destroy(struct gk20a *g)
 	nvgpu_pmu_state_change(g, PMU_STATE_OFF, false);
 	pmu->pmu_ready = false;
 	pmu->perfmon_ready = false;
+	nvgpu_pmu_load_ring_reset(&pmu->load_ring);
 	pmu->zbc_ready = false;
 	g->pmu_lsf_pmu_wpr_init_done = false;
 	__nvgpu_set_enabled(g, NVGPU_PMU_FECS_BOOTSTRAP_DONE, false);
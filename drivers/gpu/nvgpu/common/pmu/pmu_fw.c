@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2017-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -1656,6 +1656,8 @@ static void nvgpu_remove_pmu_support(struct nvgpu_pmu *pmu)
 	nvgpu_mutex_destroy(&pmu->isr_mutex);
 	nvgpu_mutex_destroy(&pmu->pmu_copy_lock);
 	nvgpu_mutex_destroy(&pmu->pmu_seq_lock);
+
+	nvgpu_pmu_rpc_pool_deinit(pmu);
 }
 
 int nvgpu_init_pmu_fw_support(struct nvgpu_pmu *pmu)
@@ -1690,15 +1692,24 @@ int nvgpu_init_pmu_fw_support(struct nvgpu_pmu *pmu)
 		goto fail_pmu_copy;
 	}
 
+	err = nvgpu_pmu_rpc_pool_init(pmu);
+	if (err) {
+		goto fail_pmu_seq;
+	}
+
+	nvgpu_pmu_load_ring_init(&pmu->load_ring);
+
 	pmu->remove_support = nvgpu_remove_pmu_support;
 
 	err = nvgpu_init_pmu_fw_ver_ops(pmu);
 	if (err) {
-		goto fail_pmu_seq;
+		goto fail_rpc_pool;
 	}
 
 	goto exit;
 
+fail_rpc_pool:
+	nvgpu_pmu_rpc_pool_deinit(pmu);
 fail_pmu_seq:
 	nvgpu_mutex_destroy(&pmu->pmu_seq_lock);
 fail_pmu_copy:
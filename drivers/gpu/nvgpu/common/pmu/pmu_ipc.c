@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2017-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -35,12 +35,21 @@ void nvgpu_pmu_seq_init(struct nvgpu_pmu *pmu)
 
 	memset(pmu->seq, 0,
 		sizeof(struct pmu_sequence) * PMU_MAX_NUM_SEQUENCES);
-	memset(pmu->pmu_seq_tbl, 0,
-		sizeof(pmu->pmu_seq_tbl));
+	memset(pmu->ipc_stats, 0, sizeof(pmu->ipc_stats));
 
+	/* Push in reverse so that ids are handed out from 0 up. */
 	for (i = 0; i < PMU_MAX_NUM_SEQUENCES; i++) {
-		pmu->seq[i].id = i;
+		pmu->seq[i].id = (u8)i;
+		pmu->seq[i].desc = PMU_INVALID_SEQ_DESC;
+		pmu->seq_free_stack[i] = (u8)(PMU_MAX_NUM_SEQUENCES - 1U - i);
 	}
+	pmu->seq_free_cnt = PMU_MAX_NUM_SEQUENCES;
+	pmu->seq_inflight_peak = 0;
+}
+
+u32 nvgpu_pmu_seq_inflight(struct nvgpu_pmu *pmu)
+{
+	return PMU_MAX_NUM_SEQUENCES - NV_ACCESS_ONCE(pmu->seq_free_cnt);
 }
 
 static int pmu_seq_acquire(struct nvgpu_pmu *pmu,
@@ -48,20 +57,23 @@ static int pmu_seq_acquire(struct nvgpu_pmu *pmu,
 {
 	struct gk20a *g = gk20a_from_pmu(pmu);
 	struct pmu_sequence *seq;
-	u32 index;
+	u32 inflight;
 
 	nvgpu_mutex_acquire(&pmu->pmu_seq_lock);
-	index = find_first_zero_bit(pmu->pmu_seq_tbl,
-				sizeof(pmu->pmu_seq_tbl));
-	if (index >= sizeof(pmu->pmu_seq_tbl)) {
+	if (pmu->seq_free_cnt == 0U) {
 		nvgpu_err(g, "no free sequence available");
 		nvgpu_mutex_release(&pmu->pmu_seq_lock);
 		return -EAGAIN;
 	}
-	set_bit(index, pmu->pmu_seq_tbl);
+	pmu->seq_free_cnt--;
+	seq = &pmu->seq[pmu->seq_free_stack[pmu->seq_free_cnt]];
+
+	inflight = PMU_MAX_NUM_SEQUENCES - pmu->seq_free_cnt;
+	if (inflight > pmu->seq_inflight_peak) {
+		pmu->seq_inflight_peak = inflight;
+	}
 	nvgpu_mutex_release(&pmu->pmu_seq_lock);
 
-	seq = &pmu->seq[index];
 	seq->state = PMU_SEQ_STATE_PENDING;
 
 	*pseq = seq;
@@ -71,21 +83,23 @@ static int pmu_seq_acquire(struct nvgpu_pmu *pmu,
 static void pmu_seq_release(struct nvgpu_pmu *pmu,
 			struct pmu_sequence *seq)
 {
-	struct gk20a *g = gk20a_from_pmu(pmu);
+	u8 id = seq->id;
 
-	seq->state	= PMU_SEQ_STATE_FREE;
-	seq->desc	= PMU_INVALID_SEQ_DESC;
-	seq->callback	= NULL;
-	seq->cb_params	= NULL;
-	seq->msg	= NULL;
-	seq->out_payload = NULL;
-	g->ops.pmu_ver.pmu_allocation_set_dmem_size(pmu,
-		g->ops.pmu_ver.get_pmu_seq_in_a_ptr(seq), 0);
-	g->ops.pmu_ver.pmu_allocation_set_dmem_size(pmu,
-		g->ops.pmu_ver.get_pmu_seq_out_a_ptr(seq), 0);
+	/*
+	 * Clearing the whole sequence also zeroes the in/out allocations,
+	 * whatever their version, so there is no need to go through the
+	 * per-version ops field by field.
+	 */
+	memset(seq, 0, sizeof(*seq));
+	seq->id = id;
+	seq->state = PMU_SEQ_STATE_FREE;
+	seq->desc = PMU_INVALID_SEQ_DESC;
 
-	clear_bit(seq->id, pmu->pmu_seq_tbl);
+	nvgpu_mutex_acquire(&pmu->pmu_seq_lock);
+	pmu->seq_free_stack[pmu->seq_free_cnt++] = id;
+	nvgpu_mutex_release(&pmu->pmu_seq_lock);
 }
+
 /* mutex */
 int nvgpu_pmu_mutex_acquire(struct nvgpu_pmu *pmu, u32 id, u32 *token)
 {
@@ -234,6 +248,7 @@ static int pmu_write_cmd(struct nvgpu_pmu *pmu, struct pmu_cmd *cmd,
 	struct gk20a *g = gk20a_from_pmu(pmu);
 	struct nvgpu_falcon_queue *queue;
 	struct nvgpu_timeout timeout;
+	unsigned long delay = GR_IDLE_CHECK_DEFAULT;
 	int err;
 
 	nvgpu_log_fn(g, " ");
@@ -241,10 +256,16 @@ static int pmu_write_cmd(struct nvgpu_pmu *pmu, struct pmu_cmd *cmd,
 	queue = &pmu->queue[queue_id];
 	nvgpu_timeout_init(g, &timeout, timeout_ms, NVGPU_TIMER_CPU_TIMER);
 
+	/*
+	 * The PMU drains its command queues quickly, so back off
+	 * exponentially from a short delay rather than always sleeping
+	 * for a millisecond when the queue is full.
+	 */
 	do {
 		err = nvgpu_flcn_queue_push(pmu->flcn, queue, cmd, cmd->hdr.size);
 		if (err == -EAGAIN && nvgpu_timeout_expired(&timeout) == 0) {
-			nvgpu_usleep_range(1000, 2000);
+			nvgpu_usleep_range(delay, delay * 2U);
+			delay = min_t(u32, delay << 1, GR_IDLE_CHECK_MAX);
 		} else {
 			break;
 		}
@@ -472,6 +493,8 @@ int nvgpu_pmu_cmd_post(struct gk20a *g, struct pmu_cmd *cmd,
 	seq->msg = msg;
 	seq->out_payload = NULL;
 	seq->desc = pmu->next_seq_desc++;
+	seq->unit_id = cmd->hdr.unit_id;
+	seq->post_time_ns = nvgpu_current_time_ns();
 
 	*seq_desc = seq->desc;
 
@@ -583,6 +606,17 @@ static int pmu_response_handle(struct nvgpu_pmu *pmu,
 		seq->in_mem = NULL;
 	}
 
+	if (seq->unit_id < PMU_UNIT_END) {
+		struct pmu_ipc_unit_stats *stats = &pmu->ipc_stats[seq->unit_id];
+		u64 delta = (u64)(nvgpu_current_time_ns() - seq->post_time_ns);
+
+		stats->completed++;
+		stats->total_ns += delta;
+		if (delta > stats->max_ns) {
+			stats->max_ns = delta;
+		}
+	}
+
 	if (seq->callback) {
 		seq->callback(g, msg, seq->cb_params, seq->desc, ret);
 	}
@@ -757,6 +791,134 @@ int pmu_wait_message_cond(struct nvgpu_pmu *pmu, u32 timeout_ms,
 	return -ETIMEDOUT;
 }
 
+int nvgpu_pmu_rpc_pool_init(struct nvgpu_pmu *pmu)
+{
+	struct gk20a *g = gk20a_from_pmu(pmu);
+	int err;
+
+	pmu->rpc_pool = nvgpu_kzalloc(g,
+		sizeof(struct pmu_rpc_pool_slot) * PMU_RPC_POOL_SLOTS);
+	if (pmu->rpc_pool == NULL) {
+		return -ENOMEM;
+	}
+
+	err = nvgpu_cond_init(&pmu->rpc_cond);
+	if (err != 0) {
+		nvgpu_kfree(g, pmu->rpc_pool);
+		pmu->rpc_pool = NULL;
+		return err;
+	}
+
+	nvgpu_spinlock_init(&pmu->rpc_pool_lock);
+	pmu->rpc_pool_used = 0;
+
+	return 0;
+}
+
+void nvgpu_pmu_rpc_pool_deinit(struct nvgpu_pmu *pmu)
+{
+	struct gk20a *g = gk20a_from_pmu(pmu);
+
+	if (pmu->rpc_pool == NULL) {
+		return;
+	}
+
+	WARN_ON(pmu->rpc_pool_used != 0U);
+	nvgpu_cond_destroy(&pmu->rpc_cond);
+	nvgpu_kfree(g, pmu->rpc_pool);
+	pmu->rpc_pool = NULL;
+}
+
+/*
+ * Get a payload with room for size_buf bytes of RPC after it. Small RPCs are
+ * served from the pool; anything larger, or a request made while the pool is
+ * exhausted, falls back to the heap.
+ */
+static struct rpc_handler_payload *pmu_rpc_payload_alloc(
+	struct nvgpu_pmu *pmu, u16 size_buf)
+{
+	struct gk20a *g = gk20a_from_pmu(pmu);
+	struct rpc_handler_payload *rpc_payload = NULL;
+	u32 i;
+
+	if (size_buf <= PMU_RPC_POOL_BUF_SIZE && pmu->rpc_pool != NULL) {
+		nvgpu_spinlock_acquire(&pmu->rpc_pool_lock);
+		for (i = 0; i < PMU_RPC_POOL_SLOTS; i++) {
+			if ((pmu->rpc_pool_used & BIT32(i)) == 0U) {
+				pmu->rpc_pool_used |= BIT32(i);
+				rpc_payload = &pmu->rpc_pool[i].payload;
+				break;
+			}
+		}
+		nvgpu_spinlock_release(&pmu->rpc_pool_lock);
+	}
+
+	if (rpc_payload != NULL) {
+		memset(rpc_payload, 0, sizeof(*rpc_payload));
+		rpc_payload->rpc_buff = pmu->rpc_pool[i].buf;
+		rpc_payload->from_pool = true;
+		return rpc_payload;
+	}
+
+	rpc_payload = nvgpu_kzalloc(g,
+		sizeof(struct rpc_handler_payload) + size_buf);
+	if (rpc_payload != NULL) {
+		rpc_payload->rpc_buff = (u8 *)rpc_payload +
+			sizeof(struct rpc_handler_payload);
+	}
+
+	return rpc_payload;
+}
+
+static void pmu_rpc_payload_free(struct nvgpu_pmu *pmu,
+	struct rpc_handler_payload *rpc_payload)
+{
+	struct gk20a *g = gk20a_from_pmu(pmu);
+	u32 i;
+
+	if (!rpc_payload->from_pool) {
+		nvgpu_kfree(g, rpc_payload);
+		return;
+	}
+
+	i = (u32)(((struct pmu_rpc_pool_slot *)rpc_payload) - pmu->rpc_pool);
+
+	nvgpu_spinlock_acquire(&pmu->rpc_pool_lock);
+	WARN_ON((pmu->rpc_pool_used & BIT32(i)) == 0U);
+	pmu->rpc_pool_used &= ~BIT32(i);
+	nvgpu_spinlock_release(&pmu->rpc_pool_lock);
+}
+
+/*
+ * Wait for the default RPC handler to mark rpc_payload complete. The handler
+ * runs from the PMU ISR and wakes rpc_cond; the ISR is also polled here so
+ * that RPCs issued before PMU interrupts are enabled still complete.
+ */
+static int pmu_rpc_wait_complete(struct nvgpu_pmu *pmu,
+	struct rpc_handler_payload *rpc_payload, u32 timeout_ms)
+{
+	struct gk20a *g = gk20a_from_pmu(pmu);
+	struct nvgpu_timeout timeout;
+
+	nvgpu_timeout_init(g, &timeout, timeout_ms, NVGPU_TIMER_CPU_TIMER);
+
+	do {
+		if (g->ops.pmu.pmu_is_interrupted(pmu)) {
+			g->ops.pmu.pmu_isr(g);
+		}
+
+		NVGPU_COND_WAIT(&pmu->rpc_cond,
+			NV_ACCESS_ONCE(rpc_payload->complete), 1U);
+
+		if (NV_ACCESS_ONCE(rpc_payload->complete)) {
+			nvgpu_smp_rmb();
+			return 0;
+		}
+	} while (nvgpu_timeout_expired(&timeout) == 0);
+
+	return -ETIMEDOUT;
+}
+
 static void pmu_rpc_handler(struct gk20a *g, struct pmu_msg *msg,
 		void *param, u32 handle, u32 status)
 {
@@ -765,6 +927,7 @@ static void pmu_rpc_handler(struct gk20a *g, struct pmu_msg *msg,
 	struct rpc_handler_payload *rpc_payload =
 		(struct rpc_handler_payload *)param;
 	struct nv_pmu_rpc_struct_perfmon_query *rpc_param;
+	bool free_payload;
 
 	memset(&rpc, 0, sizeof(struct nv_pmu_rpc_header));
 	memcpy(&rpc, rpc_payload->rpc_buff,	sizeof(struct nv_pmu_rpc_header));
@@ -861,110 +1024,182 @@ static void pmu_rpc_handler(struct gk20a *g, struct pmu_msg *msg,
 	}
 
 exit:
-	rpc_payload->complete = true;
+	/*
+	 * is_mem_free_set can be flipped by a waiter that timed out, so check
+	 * it and publish completion under the pool lock.
+	 */
+	nvgpu_spinlock_acquire(&pmu->rpc_pool_lock);
+	free_payload = rpc_payload->is_mem_free_set;
+	if (!free_payload) {
+		/* Make the response visible before the waiter sees it */
+		nvgpu_smp_wmb();
+		rpc_payload->complete = true;
+	}
+	nvgpu_spinlock_release(&pmu->rpc_pool_lock);
 
-	/* free allocated memory */
-	if (rpc_payload->is_mem_free_set) {
-		nvgpu_kfree(g, rpc_payload);
+	if (free_payload) {
+		pmu_rpc_payload_free(pmu, rpc_payload);
+	} else {
+		nvgpu_cond_broadcast(&pmu->rpc_cond);
 	}
 }
 
+/*
+ * Post an RPC whose payload is already set up. On failure the payload is
+ * released here.
+ */
+static int pmu_rpc_post(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
+	u16 size_rpc, u16 size_scratch, pmu_callback callback,
+	struct rpc_handler_payload *rpc_payload)
+{
+	struct gk20a *g = pmu->g;
+	struct pmu_cmd cmd;
+	struct pmu_payload payload;
+	u32 seq = 0;
+	int status;
+
+	memset(&cmd, 0, sizeof(struct pmu_cmd));
+	memset(&payload, 0, sizeof(struct pmu_payload));
+
+	cmd.hdr.unit_id = rpc->unit_id;
+	cmd.hdr.size = PMU_CMD_HDR_SIZE + sizeof(struct nv_pmu_rpc_cmd);
+	cmd.cmd.rpc.cmd_type = NV_PMU_RPC_CMD_ID;
+	cmd.cmd.rpc.flags = rpc->flags;
+
+	memcpy(rpc_payload->rpc_buff, rpc, size_rpc);
+	payload.rpc.prpc = rpc_payload->rpc_buff;
+	payload.rpc.size_rpc = size_rpc;
+	payload.rpc.size_scratch = size_scratch;
+
+	status = nvgpu_pmu_cmd_post(g, &cmd, NULL, &payload,
+			PMU_COMMAND_QUEUE_LPQ, callback,
+			rpc_payload, &seq, ~0);
+	if (status) {
+		nvgpu_err(g, "Failed to execute RPC status=0x%x, func=0x%x",
+				status, rpc->function);
+		pmu_rpc_payload_free(pmu, rpc_payload);
+	}
+
+	return status;
+}
+
 int nvgpu_pmu_rpc_execute(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
 	u16 size_rpc, u16 size_scratch, pmu_callback caller_cb,
 	void *caller_cb_param, bool is_copy_back)
 {
 	struct gk20a *g = pmu->g;
-	struct pmu_cmd cmd;
-	struct pmu_payload payload;
 	struct rpc_handler_payload *rpc_payload = NULL;
-	pmu_callback callback = NULL;
-	void *rpc_buff = NULL;
-	u32 seq = 0;
 	int status = 0;
 
+	if (is_copy_back) {
+		WARN_ON(caller_cb != NULL);
+		status = nvgpu_pmu_rpc_execute_async(pmu, rpc, size_rpc,
+				size_scratch, &rpc_payload);
+		if (status == 0) {
+			status = nvgpu_pmu_rpc_wait(pmu, rpc_payload, rpc,
+					size_rpc);
+		}
+		return status;
+	}
+
 	if (!pmu->pmu_ready) {
 		nvgpu_warn(g, "PMU is not ready to process RPC");
-		status = EINVAL;
-		goto exit;
+		return -EINVAL;
 	}
 
 	if (caller_cb == NULL) {
-		rpc_payload = nvgpu_kzalloc(g,
-			sizeof(struct rpc_handler_payload) + size_rpc);
+		rpc_payload = pmu_rpc_payload_alloc(pmu, size_rpc);
 		if (rpc_payload == NULL) {
-			status = ENOMEM;
-			goto exit;
+			return -ENOMEM;
 		}
-
-		rpc_payload->rpc_buff = (u8 *)rpc_payload +
-			sizeof(struct rpc_handler_payload);
-		rpc_payload->is_mem_free_set =
-			is_copy_back ? false : true;
+		rpc_payload->is_mem_free_set = true;
 
 		/* assign default RPC handler*/
-		callback = pmu_rpc_handler;
+		caller_cb = pmu_rpc_handler;
 	} else {
 		if (caller_cb_param == NULL) {
 			nvgpu_err(g, "Invalid cb param addr");
-			status = EINVAL;
-			goto exit;
+			return -EINVAL;
 		}
-		rpc_payload = nvgpu_kzalloc(g,
-			sizeof(struct rpc_handler_payload));
+		rpc_payload = pmu_rpc_payload_alloc(pmu, 0);
 		if (rpc_payload == NULL) {
-			status = ENOMEM;
-			goto exit;
+			return -ENOMEM;
 		}
 		rpc_payload->rpc_buff = caller_cb_param;
 		rpc_payload->is_mem_free_set = true;
-		callback = caller_cb;
-		WARN_ON(is_copy_back);
 	}
 
-	rpc_buff = rpc_payload->rpc_buff;
-	memset(&cmd, 0, sizeof(struct pmu_cmd));
-	memset(&payload, 0, sizeof(struct pmu_payload));
+	return pmu_rpc_post(pmu, rpc, size_rpc, size_scratch, caller_cb,
+			rpc_payload);
+}
 
-	cmd.hdr.unit_id = rpc->unit_id;
-	cmd.hdr.size = PMU_CMD_HDR_SIZE + sizeof(struct nv_pmu_rpc_cmd);
-	cmd.cmd.rpc.cmd_type = NV_PMU_RPC_CMD_ID;
-	cmd.cmd.rpc.flags = rpc->flags;
+/*
+ * Post an RPC and return without waiting for it. Any number of RPCs may be
+ * outstanding at once; each must be completed with nvgpu_pmu_rpc_wait(),
+ * which also copies the PMU's response back.
+ */
+int nvgpu_pmu_rpc_execute_async(struct nvgpu_pmu *pmu,
+	struct nv_pmu_rpc_header *rpc, u16 size_rpc, u16 size_scratch,
+	struct rpc_handler_payload **handle)
+{
+	struct gk20a *g = pmu->g;
+	struct rpc_handler_payload *rpc_payload;
+	int status;
 
-	memcpy(rpc_buff, rpc, size_rpc);
-	payload.rpc.prpc = rpc_buff;
-	payload.rpc.size_rpc = size_rpc;
-	payload.rpc.size_scratch = size_scratch;
+	if (!pmu->pmu_ready) {
+		nvgpu_warn(g, "PMU is not ready to process RPC");
+		return -EINVAL;
+	}
 
-	status = nvgpu_pmu_cmd_post(g, &cmd, NULL, &payload,
-			PMU_COMMAND_QUEUE_LPQ, callback,
-			rpc_payload, &seq, ~0);
-	if (status) {
-		nvgpu_err(g, "Failed to execute RPC status=0x%x, func=0x%x",
-				status, rpc->function);
-		goto exit;
+	rpc_payload = pmu_rpc_payload_alloc(pmu, size_rpc);
+	if (rpc_payload == NULL) {
+		return -ENOMEM;
 	}
+	rpc_payload->is_mem_free_set = false;
 
-	/*
-	 * Option act like blocking call, which waits till RPC request
-	 * executes on PMU & copy back processed data to rpc_buff
-	 * to read data back in nvgpu
-	 */
-	if (is_copy_back) {
-		/* wait till RPC execute in PMU & ACK */
-		pmu_wait_message_cond(pmu, gk20a_get_gr_idle_timeout(g),
-			&rpc_payload->complete, true);
-		/* copy back data to caller */
-		memcpy(rpc, rpc_buff, size_rpc);
-		/* free allocated memory */
-		nvgpu_kfree(g, rpc_payload);
+	status = pmu_rpc_post(pmu, rpc, size_rpc, size_scratch,
+			pmu_rpc_handler, rpc_payload);
+	if (status == 0) {
+		*handle = rpc_payload;
 	}
 
-exit:
-	if (status) {
-		if (rpc_payload) {
-			nvgpu_kfree(g, rpc_payload);
+	return status;
+}
+
+int nvgpu_pmu_rpc_wait(struct nvgpu_pmu *pmu,
+	struct rpc_handler_payload *handle, struct nv_pmu_rpc_header *rpc,
+	u16 size_rpc)
+{
+	struct gk20a *g = pmu->g;
+	bool completed;
+	int status;
+
+	status = pmu_rpc_wait_complete(pmu, handle,
+			gk20a_get_gr_idle_timeout(g));
+	if (status != 0) {
+		nvgpu_err(g, "RPC func=0x%x timed out", rpc->function);
+
+		/*
+		 * The PMU may still answer; unless it just did, hand the
+		 * payload over to the handler rather than free memory it
+		 * will write to.
+		 */
+		nvgpu_spinlock_acquire(&pmu->rpc_pool_lock);
+		completed = handle->complete;
+		if (!completed) {
+			handle->is_mem_free_set = true;
 		}
+		nvgpu_spinlock_release(&pmu->rpc_pool_lock);
+
+		if (completed) {
+			pmu_rpc_payload_free(pmu, handle);
+		}
+		return status;
 	}
 
-	return status;
+	/* copy back data to caller */
+	memcpy(rpc, handle->rpc_buff, size_rpc);
+	pmu_rpc_payload_free(pmu, handle);
+
+	return 0;
 }
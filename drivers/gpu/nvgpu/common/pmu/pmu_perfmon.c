@@ -24,6 +24,7 @@
 #include <nvgpu/pmu.h>
 #include <nvgpu/log.h>
 #include <nvgpu/bug.h>
+#include <nvgpu/timers.h>
 #include <nvgpu/pmuif/nvgpu_gpmu_cmdif.h>
 #include <nvgpu/gk20a.h>
 
@@ -233,9 +234,115 @@ int nvgpu_pmu_load_update(struct gk20a *g)
 	pmu->load_shadow = load / 10U;
 	pmu->load_avg = (((9U*pmu->load_avg) + pmu->load_shadow) / 10U);
 
+	nvgpu_pmu_load_ring_add(&pmu->load_ring, nvgpu_current_time_ns(),
+		load);
+
 	return 0;
 }
 
+void nvgpu_pmu_load_ring_init(struct nvgpu_pmu_load_ring *ring)
+{
+	nvgpu_spinlock_init(&ring->lock);
+	ring->head = 0U;
+}
+
+void nvgpu_pmu_load_ring_reset(struct nvgpu_pmu_load_ring *ring)
+{
+	nvgpu_spinlock_acquire(&ring->lock);
+	ring->head = 0U;
+	nvgpu_spinlock_release(&ring->lock);
+}
+
+void nvgpu_pmu_load_ring_add(struct nvgpu_pmu_load_ring *ring,
+		s64 timestamp_ns, u32 load)
+{
+	struct nvgpu_pmu_load_sample *sample;
+	s64 last_ns;
+
+	nvgpu_spinlock_acquire(&ring->lock);
+	if (ring->head != 0U) {
+		last_ns = ring->samples[(ring->head - 1U) %
+				PMU_LOAD_SAMPLES_NUM].timestamp_ns;
+		timestamp_ns = max(timestamp_ns, last_ns);
+	}
+	sample = &ring->samples[ring->head % PMU_LOAD_SAMPLES_NUM];
+	sample->timestamp_ns = timestamp_ns;
+	sample->load = min(load, PMU_BUSY_CYCLES_NORM_MAX);
+	ring->head++;
+	nvgpu_spinlock_release(&ring->lock);
+}
+
+/*
+ * Copy out up to max_samples of the most recent samples, oldest first.
+ * Returns the number of samples copied.
+ */
+u32 nvgpu_pmu_load_ring_read(struct nvgpu_pmu_load_ring *ring,
+		struct nvgpu_pmu_load_sample *samples, u32 max_samples)
+{
+	u32 count, first, i;
+
+	nvgpu_spinlock_acquire(&ring->lock);
+	count = min(ring->head, PMU_LOAD_SAMPLES_NUM);
+	count = min(count, max_samples);
+	first = ring->head - count;
+	for (i = 0U; i < count; i++) {
+		samples[i] = ring->samples[(first + i) % PMU_LOAD_SAMPLES_NUM];
+	}
+	nvgpu_spinlock_release(&ring->lock);
+
+	return count;
+}
+
+/*
+ * Time weighted load over the window_ns leading up to the newest sample.
+ * Each sample covers the time since the sample before it.
+ */
+int nvgpu_pmu_load_ring_window(struct nvgpu_pmu_load_ring *ring,
+		s64 window_ns, u32 *load)
+{
+	struct nvgpu_pmu_load_sample *cur, *prev;
+	s64 start_ns, seg_start;
+	u64 busy = 0ULL, total = 0ULL;
+	u32 count, i;
+	int err = 0;
+
+	nvgpu_spinlock_acquire(&ring->lock);
+	count = min(ring->head, PMU_LOAD_SAMPLES_NUM);
+	if (count == 0U) {
+		err = -ENODATA;
+		goto done;
+	}
+
+	cur = &ring->samples[(ring->head - 1U) % PMU_LOAD_SAMPLES_NUM];
+	start_ns = cur->timestamp_ns - window_ns;
+	*load = cur->load;
+
+	for (i = 1U; i < count; i++) {
+		prev = &ring->samples[(ring->head - 1U - i) %
+				PMU_LOAD_SAMPLES_NUM];
+		if (cur->timestamp_ns <= start_ns) {
+			break;
+		}
+		seg_start = max(prev->timestamp_ns, start_ns);
+		busy += (u64)cur->load * (u64)(cur->timestamp_ns - seg_start);
+		total += (u64)(cur->timestamp_ns - seg_start);
+		cur = prev;
+	}
+
+	if (total != 0ULL) {
+		*load = (u32)(busy / total);
+	}
+
+done:
+	nvgpu_spinlock_release(&ring->lock);
+	return err;
+}
+
+int nvgpu_pmu_load_window(struct gk20a *g, s64 window_ns, u32 *load)
+{
+	return nvgpu_pmu_load_ring_window(&g->pmu.load_ring, window_ns, load);
+}
+
 int nvgpu_pmu_busy_cycles_norm(struct gk20a *g, u32 *norm)
 {
 	u64 busy_cycles, total_cycles;
@@ -273,6 +380,10 @@ int nvgpu_pmu_busy_cycles_norm(struct gk20a *g, u32 *norm)
 			      / total_cycles);
 	}
 
+	/* the counters were just reset, so this covers the last period */
+	nvgpu_pmu_load_ring_add(&g->pmu.load_ring, nvgpu_current_time_ns(),
+		*norm);
+
 exit:
 	gk20a_idle_nosuspend(g);
 
@@ -1,7 +1,7 @@
 /*
  * GK20A Cycle stats snapshots support (subsystem for gr_gk20a).
  *
- * Copyright (c) 2015-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -263,6 +263,34 @@ css_gr_search_client(struct nvgpu_list_node *clients, u32 perfmon)
 	return NULL;
 }
 
+/*
+ * HW entries arrive interleaved from every attached client, so resolve the
+ * owner through a per-perfmon table instead of walking the client list each
+ * time the stream switches perfmons.
+ */
+static struct gk20a_cs_snapshot_client *
+css_gr_lookup_client(struct gk20a_cs_snapshot *css, u32 perfmon)
+{
+	struct gk20a_cs_snapshot_client *client;
+
+	if (perfmon >= CSS_MAX_PERFMON_IDS)
+		return NULL;
+
+	client = css->perfmon_clients[perfmon];
+	if (!client) {
+		client = css_gr_search_client(&css->clients, perfmon);
+		css->perfmon_clients[perfmon] = client;
+	}
+
+	return client;
+}
+
+/*
+ * Each client's gk20a_cs_snapshot_fifo already is a ring with put/get
+ * indices in a dmabuf mapped by userspace. The copy below can not be
+ * avoided: the HW streams all perfmons into one shared buffer, and
+ * handing that buffer out would expose other contexts' counters.
+ */
 static int css_gr_flush_snapshots(struct channel_gk20a *ch)
 {
 	struct gk20a *g = ch->g;
@@ -327,12 +355,9 @@ static int css_gr_flush_snapshots(struct channel_gk20a *ch)
 			cur = NULL;
 		}
 
-		/* now we have to select a new current client         */
-		/* the client selection rate depends from experiment  */
-		/* activity but on Android usually happened 1-2 times */
+		/* now we have to select a new current client */
 		if (!cur) {
-			cur = css_gr_search_client(&css->clients,
-							src->perfmon_id);
+			cur = css_gr_lookup_client(css, src->perfmon_id);
 			if (cur) {
 				/* found - setup all required data */
 				dst = cur->snapshot;
@@ -441,10 +466,16 @@ static int css_gr_free_client_data(struct gk20a *g,
 				struct gk20a_cs_snapshot_client *client)
 {
 	int ret = 0;
+	u32 i;
 
 	if (client->list.next && client->list.prev)
 		nvgpu_list_del(&client->list);
 
+	for (i = 0; i < CSS_MAX_PERFMON_IDS; i++) {
+		if (data->perfmon_clients[i] == client)
+			data->perfmon_clients[i] = NULL;
+	}
+
 	if (client->perfmon_start && client->perfmon_count
 					&& g->ops.css.release_perfmon_ids) {
 		if (client->perfmon_count != g->ops.css.release_perfmon_ids(data,
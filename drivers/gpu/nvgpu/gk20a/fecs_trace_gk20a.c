@@ -24,7 +24,7 @@
 #include <nvgpu/dma.h>
 #include <nvgpu/enabled.h>
 #include <nvgpu/bug.h>
-#include <nvgpu/hashtable.h>
+#include <nvgpu/atomic.h>
 #include <nvgpu/circ_buf.h>
 #include <nvgpu/thread.h>
 #include <nvgpu/barrier.h>
@@ -46,16 +46,32 @@
 #include <nvgpu/hw/gk20a/hw_ctxsw_prog_gk20a.h>
 #include <nvgpu/hw/gk20a/hw_gr_gk20a.h>
 
-struct gk20a_fecs_trace_hash_ent {
-	u32 context_ptr;
-	pid_t pid;
-	struct hlist_node node;
-};
+/*
+ * context_ptr -> pid map. Each slot packs context_ptr in the upper 32 bits
+ * and the pid plus two state bits in the lower 32 bits, so the poll thread
+ * can read it without taking a lock. A slot is live only with the VALID bit
+ * set and a tombstone only with the DELETED bit set; any context_ptr and
+ * pid value can be stored. Updates are serialized by pid_map_lock.
+ */
+#define PID_MAP_VALID		BIT64(31)
+#define PID_MAP_DELETED		BIT64(30)
+#define PID_MAP_PID_MASK	(BIT32(30) - 1U)
+#define PID_MAP_EMPTY		0L
+#define PID_MAP_TOMBSTONE	((long)PID_MAP_DELETED)
+#define PID_MAP_ENT(ctx, pid)	((long)((((u64)(ctx)) << 32) |		\
+				PID_MAP_VALID | ((u32)(pid) & PID_MAP_PID_MASK)))
+#define PID_MAP_LIVE(ent)	((((u64)(ent)) & PID_MAP_VALID) != 0ULL)
+#define PID_MAP_CTX(ent)	((u32)(((u64)(ent)) >> 32))
+#define PID_MAP_PID(ent)	((pid_t)((u32)(ent) & PID_MAP_PID_MASK))
+
+/* rebuild the map once this many slots are tombstones */
+#define PID_MAP_MAX_DELETED	(GK20A_FECS_TRACE_PID_MAP_SIZE / 4U)
 
 struct gk20a_fecs_trace {
 
-	DECLARE_HASHTABLE(pid_hash_table, GK20A_FECS_TRACE_HASH_BITS);
-	struct nvgpu_mutex hash_lock;
+	nvgpu_atomic64_t pid_map[GK20A_FECS_TRACE_PID_MAP_SIZE];
+	u32 pid_map_deleted;
+	struct nvgpu_mutex pid_map_lock;
 	struct nvgpu_mutex poll_lock;
 	struct nvgpu_thread poll_task;
 	bool init;
@@ -129,109 +145,211 @@ static int gk20a_fecs_trace_set_read_index(struct gk20a *g, int index)
 			(gk20a_writel(g, gr_fecs_mailbox1_r(), index), 0));
 }
 
+static inline u32 gk20a_fecs_trace_pid_map_slot(u32 context_ptr, u32 i)
+{
+	return (context_ptr + i) & (GK20A_FECS_TRACE_PID_MAP_SIZE - 1);
+}
+
 void gk20a_fecs_trace_hash_dump(struct gk20a *g)
 {
-	u32 bkt;
-	struct gk20a_fecs_trace_hash_ent *ent;
+	u32 i;
+	long ent;
 	struct gk20a_fecs_trace *trace = g->fecs_trace;
 
-	nvgpu_log(g, gpu_dbg_ctxsw, "dumping hash table");
-
-	nvgpu_mutex_acquire(&trace->hash_lock);
-	hash_for_each(trace->pid_hash_table, bkt, ent, node)
-	{
-		nvgpu_log(g, gpu_dbg_ctxsw, " ent=%p bkt=%x context_ptr=%x pid=%d",
-			ent, bkt, ent->context_ptr, ent->pid);
+	nvgpu_log(g, gpu_dbg_ctxsw, "dumping pid map");
 
+	for (i = 0; i < GK20A_FECS_TRACE_PID_MAP_SIZE; i++) {
+		ent = nvgpu_atomic64_read(&trace->pid_map[i]);
+		if (!PID_MAP_LIVE(ent))
+			continue;
+		nvgpu_log(g, gpu_dbg_ctxsw, " slot=%x context_ptr=%x pid=%d",
+			i, PID_MAP_CTX(ent), PID_MAP_PID(ent));
 	}
-	nvgpu_mutex_release(&trace->hash_lock);
 }
 
 static int gk20a_fecs_trace_hash_add(struct gk20a *g, u32 context_ptr, pid_t pid)
 {
-	struct gk20a_fecs_trace_hash_ent *he;
 	struct gk20a_fecs_trace *trace = g->fecs_trace;
+	nvgpu_atomic64_t *free_slot = NULL;
+	nvgpu_atomic64_t *slot;
+	long ent;
+	u32 i;
 
 	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_ctxsw,
-		"adding hash entry context_ptr=%x -> pid=%d", context_ptr, pid);
+		"adding pid map entry context_ptr=%x -> pid=%d",
+		context_ptr, pid);
+
+	nvgpu_mutex_acquire(&trace->pid_map_lock);
+	for (i = 0; i < GK20A_FECS_TRACE_PID_MAP_SIZE; i++) {
+		slot = &trace->pid_map[gk20a_fecs_trace_pid_map_slot(
+				context_ptr, i)];
+		ent = nvgpu_atomic64_read(slot);
+		if (PID_MAP_LIVE(ent) && PID_MAP_CTX(ent) == context_ptr) {
+			/* rebind of a known context, refresh in place */
+			free_slot = slot;
+			break;
+		}
+		if (ent == PID_MAP_TOMBSTONE && free_slot == NULL)
+			free_slot = slot;
+		if (ent == PID_MAP_EMPTY) {
+			if (free_slot == NULL)
+				free_slot = slot;
+			break;
+		}
+	}
+	if (free_slot != NULL) {
+		if (nvgpu_atomic64_read(free_slot) == PID_MAP_TOMBSTONE)
+			trace->pid_map_deleted--;
+		nvgpu_atomic64_set(free_slot, PID_MAP_ENT(context_ptr, pid));
+	}
+	nvgpu_mutex_release(&trace->pid_map_lock);
 
-	he = nvgpu_kzalloc(g, sizeof(*he));
-	if (unlikely(!he)) {
+	if (unlikely(free_slot == NULL)) {
 		nvgpu_warn(g,
-			"can't alloc new hash entry for context_ptr=%x pid=%d",
+			"pid map full, dropping context_ptr=%x pid=%d",
 			context_ptr, pid);
 		return -ENOMEM;
 	}
-
-	he->context_ptr = context_ptr;
-	he->pid = pid;
-	nvgpu_mutex_acquire(&trace->hash_lock);
-	hash_add(trace->pid_hash_table, &he->node, context_ptr);
-	nvgpu_mutex_release(&trace->hash_lock);
 	return 0;
 }
 
+/*
+ * Called with pid_map_lock held after slot @idx was turned into a tombstone.
+ * If no probe sequence continues past it, it and the run of tombstones
+ * before it can go back to empty.
+ */
+static void gk20a_fecs_trace_pid_map_trim(struct gk20a_fecs_trace *trace,
+					  u32 idx)
+{
+	u32 i;
+
+	if (nvgpu_atomic64_read(&trace->pid_map[
+			gk20a_fecs_trace_pid_map_slot(idx, 1U)]) !=
+			PID_MAP_EMPTY)
+		return;
+
+	for (i = 0; i < GK20A_FECS_TRACE_PID_MAP_SIZE; i++) {
+		nvgpu_atomic64_t *slot = &trace->pid_map[
+			gk20a_fecs_trace_pid_map_slot(idx,
+				GK20A_FECS_TRACE_PID_MAP_SIZE - i)];
+
+		if (nvgpu_atomic64_read(slot) != PID_MAP_TOMBSTONE)
+			break;
+		nvgpu_atomic64_set(slot, PID_MAP_EMPTY);
+		trace->pid_map_deleted--;
+	}
+}
+
+/*
+ * Rebuild the map without tombstones. Entries move between slots, so the
+ * poll thread, the only lockless reader, is kept out meanwhile.
+ */
+static void gk20a_fecs_trace_pid_map_rehash(struct gk20a *g)
+{
+	struct gk20a_fecs_trace *trace = g->fecs_trace;
+	long *ents;
+	u32 i, j, idx;
+
+	ents = nvgpu_kmalloc(g, sizeof(*ents) * GK20A_FECS_TRACE_PID_MAP_SIZE);
+	if (ents == NULL)
+		return;
+
+	nvgpu_mutex_acquire(&trace->poll_lock);
+	nvgpu_mutex_acquire(&trace->pid_map_lock);
+
+	for (i = 0; i < GK20A_FECS_TRACE_PID_MAP_SIZE; i++) {
+		ents[i] = nvgpu_atomic64_read(&trace->pid_map[i]);
+		nvgpu_atomic64_set(&trace->pid_map[i], PID_MAP_EMPTY);
+	}
+	trace->pid_map_deleted = 0;
+
+	for (i = 0; i < GK20A_FECS_TRACE_PID_MAP_SIZE; i++) {
+		if (!PID_MAP_LIVE(ents[i]))
+			continue;
+		for (j = 0; j < GK20A_FECS_TRACE_PID_MAP_SIZE; j++) {
+			idx = gk20a_fecs_trace_pid_map_slot(
+				PID_MAP_CTX(ents[i]), j);
+			if (nvgpu_atomic64_read(&trace->pid_map[idx]) ==
+					PID_MAP_EMPTY) {
+				nvgpu_atomic64_set(&trace->pid_map[idx],
+					ents[i]);
+				break;
+			}
+		}
+	}
+
+	nvgpu_mutex_release(&trace->pid_map_lock);
+	nvgpu_mutex_release(&trace->poll_lock);
+
+	nvgpu_kfree(g, ents);
+}
+
 static void gk20a_fecs_trace_hash_del(struct gk20a *g, u32 context_ptr)
 {
-	struct hlist_node *tmp;
-	struct gk20a_fecs_trace_hash_ent *ent;
 	struct gk20a_fecs_trace *trace = g->fecs_trace;
+	nvgpu_atomic64_t *slot;
+	bool rehash;
+	long ent;
+	u32 i, idx;
 
 	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_ctxsw,
-		"freeing hash entry context_ptr=%x", context_ptr);
-
-	nvgpu_mutex_acquire(&trace->hash_lock);
-	hash_for_each_possible_safe(trace->pid_hash_table, ent, tmp, node,
-		context_ptr) {
-		if (ent->context_ptr == context_ptr) {
-			hash_del(&ent->node);
-			nvgpu_log(g, gpu_dbg_ctxsw,
-				"freed hash entry=%p context_ptr=%x", ent,
-				ent->context_ptr);
-			nvgpu_kfree(g, ent);
+		"freeing pid map entry context_ptr=%x", context_ptr);
+
+	nvgpu_mutex_acquire(&trace->pid_map_lock);
+	for (i = 0; i < GK20A_FECS_TRACE_PID_MAP_SIZE; i++) {
+		idx = gk20a_fecs_trace_pid_map_slot(context_ptr, i);
+		slot = &trace->pid_map[idx];
+		ent = nvgpu_atomic64_read(slot);
+		if (ent == PID_MAP_EMPTY)
+			break;
+		if (PID_MAP_LIVE(ent) && PID_MAP_CTX(ent) == context_ptr) {
+			nvgpu_atomic64_set(slot, PID_MAP_TOMBSTONE);
+			trace->pid_map_deleted++;
+			gk20a_fecs_trace_pid_map_trim(trace, idx);
 			break;
 		}
 	}
-	nvgpu_mutex_release(&trace->hash_lock);
+	rehash = trace->pid_map_deleted >= PID_MAP_MAX_DELETED;
+	nvgpu_mutex_release(&trace->pid_map_lock);
+
+	if (rehash)
+		gk20a_fecs_trace_pid_map_rehash(g);
 }
 
 static void gk20a_fecs_trace_free_hash_table(struct gk20a *g)
 {
-	u32 bkt;
-	struct hlist_node *tmp;
-	struct gk20a_fecs_trace_hash_ent *ent;
 	struct gk20a_fecs_trace *trace = g->fecs_trace;
+	u32 i;
 
 	nvgpu_log(g, gpu_dbg_fn | gpu_dbg_ctxsw, "trace=%p", trace);
 
-	nvgpu_mutex_acquire(&trace->hash_lock);
-	hash_for_each_safe(trace->pid_hash_table, bkt, tmp, ent, node) {
-		hash_del(&ent->node);
-		nvgpu_kfree(g, ent);
-	}
-	nvgpu_mutex_release(&trace->hash_lock);
-
+	nvgpu_mutex_acquire(&trace->pid_map_lock);
+	for (i = 0; i < GK20A_FECS_TRACE_PID_MAP_SIZE; i++)
+		nvgpu_atomic64_set(&trace->pid_map[i], PID_MAP_EMPTY);
+	trace->pid_map_deleted = 0;
+	nvgpu_mutex_release(&trace->pid_map_lock);
 }
 
 static pid_t gk20a_fecs_trace_find_pid(struct gk20a *g, u32 context_ptr)
 {
-	struct gk20a_fecs_trace_hash_ent *ent;
 	struct gk20a_fecs_trace *trace = g->fecs_trace;
-	pid_t pid = 0;
+	long ent;
+	u32 i;
 
-	nvgpu_mutex_acquire(&trace->hash_lock);
-	hash_for_each_possible(trace->pid_hash_table, ent, node, context_ptr) {
-		if (ent->context_ptr == context_ptr) {
+	for (i = 0; i < GK20A_FECS_TRACE_PID_MAP_SIZE; i++) {
+		ent = nvgpu_atomic64_read(&trace->pid_map[
+			gk20a_fecs_trace_pid_map_slot(context_ptr, i)]);
+		if (ent == PID_MAP_EMPTY)
+			break;
+		if (PID_MAP_LIVE(ent) && PID_MAP_CTX(ent) == context_ptr) {
 			nvgpu_log(g, gpu_dbg_ctxsw,
 				"found context_ptr=%x -> pid=%d",
-				ent->context_ptr, ent->pid);
-			pid = ent->pid;
-			break;
+				context_ptr, PID_MAP_PID(ent));
+			return PID_MAP_PID(ent);
 		}
 	}
-	nvgpu_mutex_release(&trace->hash_lock);
 
-	return pid;
+	return 0;
 }
 
 /*
@@ -325,22 +443,23 @@ static int gk20a_fecs_trace_ring_read(struct gk20a *g, int index)
 		count++;
 	}
 
-	gk20a_ctxsw_trace_wake_up(g, vmid);
 	return count;
 }
 
-int gk20a_fecs_trace_poll(struct gk20a *g)
+/*
+ * Consumes all pending FECS records. The caller must keep the GPU powered.
+ * Returns the number of records consumed, or a negative error code.
+ */
+int gk20a_fecs_trace_drain(struct gk20a *g)
 {
 	struct gk20a_fecs_trace *trace = g->fecs_trace;
 
 	int read = 0;
 	int write = 0;
 	int cnt;
-	int err;
-
-	err = gk20a_busy(g);
-	if (unlikely(err))
-		return err;
+	int records = 0;
+	int total = 0;
+	int err = 0;
 
 	nvgpu_mutex_acquire(&trace->poll_lock);
 	write = gk20a_fecs_trace_get_write_index(g);
@@ -369,11 +488,14 @@ int gk20a_fecs_trace_poll(struct gk20a *g)
 		read = read & (~(BIT32(NVGPU_FECS_TRACE_FEATURE_CONTROL_BIT)));
 	}
 
+	records = CIRC_CNT(write, read, GK20A_FECS_TRACE_NUM_RECORDS);
+
 	while (read != write) {
 		cnt = gk20a_fecs_trace_ring_read(g, read);
 		if (cnt > 0) {
 			nvgpu_log(g, gpu_dbg_ctxsw,
 				"number of trace entries added: %d", cnt);
+			total += cnt;
 		}
 
 		/* Get to next record. */
@@ -393,25 +515,66 @@ int gk20a_fecs_trace_poll(struct gk20a *g)
 	nvgpu_wmb();
 	gk20a_fecs_trace_set_read_index(g, read);
 
+	/* wake readers once for the whole drain rather than per record */
+	if (total > 0)
+		gk20a_ctxsw_trace_wake_up(g, 0);
+
 done:
 	nvgpu_mutex_release(&trace->poll_lock);
+	return (err != 0) ? err : records;
+}
+
+int gk20a_fecs_trace_poll(struct gk20a *g)
+{
+	int err;
+
+	err = gk20a_busy(g);
+	if (unlikely(err))
+		return err;
+
+	err = gk20a_fecs_trace_drain(g);
 	gk20a_idle(g);
-	return err;
+
+	return (err < 0) ? err : 0;
 }
 
 static int gk20a_fecs_trace_periodic_polling(void *arg)
 {
 	struct gk20a *g = (struct gk20a *)arg;
 	struct gk20a_fecs_trace *trace = g->fecs_trace;
+	u64 period_us = GK20A_FECS_TRACE_FRAME_PERIOD_US;
+	int records;
 
 	pr_info("%s: running\n", __func__);
 
 	while (!nvgpu_thread_should_stop(&trace->poll_task)) {
 
-		nvgpu_usleep_range(GK20A_FECS_TRACE_FRAME_PERIOD_US,
-				   GK20A_FECS_TRACE_FRAME_PERIOD_US * 2);
+		nvgpu_usleep_range(period_us, period_us * 2);
 
-		gk20a_fecs_trace_poll(g);
+		/*
+		 * Don't resume a railgated GPU just to find the ring empty.
+		 * FECS can't produce records while powered off, and the
+		 * records left at power off are drained by
+		 * gk20a_prepare_poweroff().
+		 */
+		gk20a_busy_noresume(g);
+		if (g->power_on) {
+			records = gk20a_fecs_trace_drain(g);
+		} else {
+			records = 0;
+		}
+		gk20a_idle_nosuspend(g);
+
+		/* back off while idle, catch up quickly as the ring fills */
+		if (records <= 0) {
+			period_us = min(period_us * 2ULL,
+					GK20A_FECS_TRACE_POLL_MAX_US);
+		} else if (records >= GK20A_FECS_TRACE_NUM_RECORDS / 4) {
+			period_us = GK20A_FECS_TRACE_POLL_MIN_US;
+		} else {
+			period_us = max(period_us / 2ULL,
+					GK20A_FECS_TRACE_POLL_MIN_US);
+		}
 	}
 
 	return 0;
@@ -438,16 +601,16 @@ int gk20a_fecs_trace_init(struct gk20a *g)
 	err = nvgpu_mutex_init(&trace->poll_lock);
 	if (err)
 		goto clean;
-	err = nvgpu_mutex_init(&trace->hash_lock);
+	err = nvgpu_mutex_init(&trace->pid_map_lock);
 	if (err)
 		goto clean_poll_lock;
 
 	err = nvgpu_mutex_init(&trace->enable_lock);
 	if (err)
-		goto clean_hash_lock;
+		goto clean_pid_map_lock;
 
 	BUG_ON(!is_power_of_2(GK20A_FECS_TRACE_NUM_RECORDS));
-	hash_init(trace->pid_hash_table);
+	BUG_ON(!is_power_of_2(GK20A_FECS_TRACE_PID_MAP_SIZE));
 
 	__nvgpu_set_enabled(g, NVGPU_SUPPORT_FECS_CTXSW_TRACE, true);
 
@@ -456,8 +619,8 @@ int gk20a_fecs_trace_init(struct gk20a *g)
 
 	return 0;
 
-clean_hash_lock:
-	nvgpu_mutex_destroy(&trace->hash_lock);
+clean_pid_map_lock:
+	nvgpu_mutex_destroy(&trace->pid_map_lock);
 
 clean_poll_lock:
 	nvgpu_mutex_destroy(&trace->poll_lock);
@@ -600,7 +763,7 @@ int gk20a_fecs_trace_deinit(struct gk20a *g)
 	}
 	gk20a_fecs_trace_free_hash_table(g);
 
-	nvgpu_mutex_destroy(&g->fecs_trace->hash_lock);
+	nvgpu_mutex_destroy(&g->fecs_trace->pid_map_lock);
 	nvgpu_mutex_destroy(&g->fecs_trace->poll_lock);
 	nvgpu_mutex_destroy(&g->fecs_trace->enable_lock);
 
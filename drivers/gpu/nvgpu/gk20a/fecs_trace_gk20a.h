@@ -28,6 +28,7 @@ struct channel_gk20a;
 struct nvgpu_gpu_ctxsw_trace_filter;
 
 int gk20a_fecs_trace_poll(struct gk20a *g);
+int gk20a_fecs_trace_drain(struct gk20a *g);
 int gk20a_fecs_trace_init(struct gk20a *g);
 int gk20a_fecs_trace_bind_channel(struct gk20a *g,
 		struct channel_gk20a *ch);
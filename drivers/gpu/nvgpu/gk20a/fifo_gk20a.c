@@ -3484,10 +3484,10 @@ u32 *gk20a_runlist_construct_locked(struct fifo_gk20a *f,
 		}
 
 		/* add TSG entry */
-		nvgpu_log_info(g, "add TSG %d to runlist", tsg->tsgid);
 		f->g->ops.fifo.get_tsg_runlist_entry(tsg, runlist_entry);
-		nvgpu_log_info(g, "tsg runlist count %d runlist [0] %x [1] %x\n",
-				count, runlist_entry[0], runlist_entry[1]);
+		nvgpu_log_bin(g, gpu_dbg_info,
+			"add TSG %llu count %llu runlist [0] %llx [1] %llx",
+			tsg->tsgid, count, runlist_entry[0], runlist_entry[1]);
 		runlist_entry += runlist_entry_words;
 		count++;
 		(*entries_left)--;
@@ -3506,12 +3506,11 @@ u32 *gk20a_runlist_construct_locked(struct fifo_gk20a *f,
 				return NULL;
 			}
 
-			nvgpu_log_info(g, "add channel %d to runlist",
-				ch->chid);
 			f->g->ops.fifo.get_ch_runlist_entry(ch, runlist_entry);
-			nvgpu_log_info(g,
-				"run list count %d runlist [0] %x [1] %x\n",
-				count, runlist_entry[0], runlist_entry[1]);
+			nvgpu_log_bin(g, gpu_dbg_info,
+				"add channel %llu count %llu runlist [0] %llx [1] %llx",
+				ch->chid, count, runlist_entry[0],
+				runlist_entry[1]);
 			count++;
 			runlist_entry += runlist_entry_words;
 			(*entries_left)--;
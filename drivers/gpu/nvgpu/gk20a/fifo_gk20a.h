@@ -1,7 +1,7 @@
 /*
  * GK20A graphics fifo (gr host)
  *
- * Copyright (c) 2011-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2011-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -176,6 +176,12 @@ struct fifo_gk20a {
 		struct nvgpu_mutex lock;
 	} profile;
 #endif
+	/* submit activity, sampled by the devfreq submit boost */
+	struct {
+		nvgpu_atomic64_t submits;
+		nvgpu_atomic_t jobs;
+		nvgpu_atomic_t waits;
+	} activity;
 	struct nvgpu_mem userd;
 	u32 userd_entry_size;
 
@@ -39,12 +39,14 @@
 #include <nvgpu/therm.h>
 #include <nvgpu/mc.h>
 #include <nvgpu/channel_sync.h>
+#include <nvgpu/init_sched.h>
 
 #include <trace/events/gk20a.h>
 
 #include "gk20a.h"
 
 #include "dbg_gpu_gk20a.h"
+#include "fecs_trace_gk20a.h"
 #include "pstate/pstate.h"
 
 void __nvgpu_check_gpu_state(struct gk20a *g)
@@ -88,6 +90,14 @@ int gk20a_prepare_poweroff(struct gk20a *g)
 		}
 	}
 
+#ifdef CONFIG_GK20A_CTXSW_TRACE
+	/* the FECS ring indices live in mailboxes that don't survive reset */
+	if (g->ops.fecs_trace.is_enabled != NULL &&
+	    g->ops.fecs_trace.is_enabled(g)) {
+		(void) gk20a_fecs_trace_drain(g);
+	}
+#endif
+
 	/* disable elpg before gr or fifo suspend */
 	if (g->ops.pmu.is_pmu_supported(g)) {
 		ret |= nvgpu_pmu_destroy(g);
@@ -119,8 +129,153 @@ int gk20a_prepare_poweroff(struct gk20a *g)
 	return ret;
 }
 
+static int gk20a_init_acr_stage(struct gk20a *g)
+{
+	return g->acr.bootstrap_hs_acr(g, &g->acr, &g->acr.acr);
+}
+
+/*
+ * With a firmware-defined netlist, loading and parsing it is pure SW: the
+ * HW major revision is only read for the dynamic netlist slots. Sim reads
+ * the netlist through the sim registers, so it is left in
+ * gk20a_init_gr_prepare() as well.
+ */
+static bool gk20a_netlist_load_is_sw_only(struct gk20a *g)
+{
+	return !g->gr.ctx_vars.valid &&
+		!nvgpu_is_enabled(g, NVGPU_IS_FMODEL) &&
+		g->ops.gr_ctx.is_fw_defined();
+}
+
+static int gk20a_init_netlist_stage(struct gk20a *g)
+{
+	return gr_gk20a_init_ctx_vars(g, &g->gr);
+}
+
+/*
+ * Memory subsystem bring-up. Every HW stage here reprograms FB/MMU state
+ * the next one relies on (the NVLINK init also rewrites the FB NISO and MMU
+ * control registers and switches MM to physical SG tables), so they keep
+ * the legacy order and run on the calling thread. The netlist only fills
+ * in gr.ctx_vars, which nothing touches before the GR stages, so on first
+ * poweron it is loaded on a worker meanwhile.
+ */
+static int gk20a_init_mem_stages(struct gk20a *g,
+		struct nvgpu_init_sched *sched)
+{
+	int netlist, nvlink, fbpa, unlock, fifo_hw, ltc, mm, fifo;
+
+	netlist = nvgpu_init_sched_add(sched, "netlist",
+			gk20a_netlist_load_is_sw_only(g) ?
+				gk20a_init_netlist_stage : NULL,
+			0U, NVGPU_INIT_STAGE_PARALLEL);
+	if (netlist < 0) {
+		return netlist;
+	}
+	nvlink = nvgpu_init_sched_add(sched, "nvlink",
+			nvgpu_is_enabled(g, NVGPU_SUPPORT_NVLINK) ?
+				g->ops.nvlink.init : NULL,
+			0U, 0U);
+	if (nvlink < 0) {
+		return nvlink;
+	}
+	fbpa = nvgpu_init_sched_add(sched, "fbpa", g->ops.fb.init_fbpa,
+			NVGPU_INIT_STAGE_DEP(nvlink), 0U);
+	if (fbpa < 0) {
+		return fbpa;
+	}
+	unlock = nvgpu_init_sched_add(sched, "mem_unlock",
+			g->ops.fb.mem_unlock, NVGPU_INIT_STAGE_DEP(fbpa), 0U);
+	if (unlock < 0) {
+		return unlock;
+	}
+	fifo_hw = nvgpu_init_sched_add(sched, "fifo_hw",
+			g->ops.fifo.reset_enable_hw,
+			NVGPU_INIT_STAGE_DEP(unlock), 0U);
+	if (fifo_hw < 0) {
+		return fifo_hw;
+	}
+	ltc = nvgpu_init_sched_add(sched, "ltc", nvgpu_init_ltc_support,
+			NVGPU_INIT_STAGE_DEP(fifo_hw), 0U);
+	if (ltc < 0) {
+		return ltc;
+	}
+	mm = nvgpu_init_sched_add(sched, "mm", nvgpu_init_mm_support,
+			NVGPU_INIT_STAGE_DEP(ltc), 0U);
+	if (mm < 0) {
+		return mm;
+	}
+	fifo = nvgpu_init_sched_add(sched, "fifo", gk20a_init_fifo_support,
+			NVGPU_INIT_STAGE_DEP(mm), 0U);
+	if (fifo < 0) {
+		return fifo;
+	}
+
+	return nvgpu_init_sched_run(sched);
+}
+
+/*
+ * Falcon bring-up: ACR, SEC2, PMU and FECS/GPCCS. All of them need the
+ * ucode blob and run one after the other. The pstate VBIOS parsing keeps
+ * its legacy slot between prepare_ucode and the HS ACR boot.
+ */
+static int gk20a_init_falcon_stages(struct gk20a *g,
+		struct nvgpu_init_sched *sched)
+{
+	bool pmu = g->ops.pmu.is_pmu_supported(g);
+	bool secure = nvgpu_is_enabled(g, NVGPU_SEC_PRIVSECURITY);
+	int gr_hw, ucode, pstate, acr, sec2, pmu_boot, gr;
+
+	gr_hw = nvgpu_init_sched_add(sched, "gr_hw", gk20a_enable_gr_hw,
+			0U, 0U);
+	if (gr_hw < 0) {
+		return gr_hw;
+	}
+	ucode = nvgpu_init_sched_add(sched, "pmu_ucode",
+			pmu ? g->ops.pmu.prepare_ucode : NULL,
+			NVGPU_INIT_STAGE_DEP(gr_hw), 0U);
+	if (ucode < 0) {
+		return ucode;
+	}
+	pstate = nvgpu_init_sched_add(sched, "pstate",
+			nvgpu_is_enabled(g, NVGPU_PMU_PSTATE) ?
+				gk20a_init_pstate_support : NULL,
+			NVGPU_INIT_STAGE_DEP(ucode), 0U);
+	if (pstate < 0) {
+		return pstate;
+	}
+	acr = nvgpu_init_sched_add(sched, "acr",
+			(secure && g->acr.bootstrap_hs_acr != NULL) ?
+				gk20a_init_acr_stage : NULL,
+			NVGPU_INIT_STAGE_DEP(pstate), 0U);
+	if (acr < 0) {
+		return acr;
+	}
+	sec2 = nvgpu_init_sched_add(sched, "sec2",
+			nvgpu_is_enabled(g, NVGPU_SUPPORT_SEC2_RTOS) ?
+				nvgpu_init_sec2_support : NULL,
+			NVGPU_INIT_STAGE_DEP(acr), 0U);
+	if (sec2 < 0) {
+		return sec2;
+	}
+	pmu_boot = nvgpu_init_sched_add(sched, "pmu",
+			pmu ? nvgpu_init_pmu_support : NULL,
+			NVGPU_INIT_STAGE_DEP(sec2), 0U);
+	if (pmu_boot < 0) {
+		return pmu_boot;
+	}
+	gr = nvgpu_init_sched_add(sched, "gr", gk20a_init_gr_support,
+			NVGPU_INIT_STAGE_DEP(pmu_boot), 0U);
+	if (gr < 0) {
+		return gr;
+	}
+
+	return nvgpu_init_sched_run(sched);
+}
+
 int gk20a_finalize_poweron(struct gk20a *g)
 {
+	struct nvgpu_init_sched *sched = &g->poweron_sched;
 	int err = 0;
 #if defined(CONFIG_TEGRA_GK20A_NVHOST)
 	u32 nr_pages;
@@ -136,6 +291,8 @@ int gk20a_finalize_poweron(struct gk20a *g)
 
 	g->power_on = true;
 
+	nvgpu_init_sched_init(sched, g);
+
 	/*
 	 * Before probing the GPU make sure the GPU's state is cleared. This is
 	 * relevant for rebind operations.
@@ -214,52 +371,8 @@ int gk20a_finalize_poweron(struct gk20a *g)
 		}
 	}
 
-	if (nvgpu_is_enabled(g, NVGPU_SUPPORT_NVLINK)) {
-		err = g->ops.nvlink.init(g);
-		if (err) {
-			nvgpu_err(g, "failed to init nvlink");
-			goto done;
-		}
-	}
-
-	if (g->ops.fb.init_fbpa) {
-		err = g->ops.fb.init_fbpa(g);
-		if (err) {
-			nvgpu_err(g, "failed to init fbpa");
-			goto done;
-		}
-	}
-
-	if (g->ops.fb.mem_unlock) {
-		err = g->ops.fb.mem_unlock(g);
-		if (err) {
-			nvgpu_err(g, "failed to unlock memory");
-			goto done;
-		}
-	}
-
-	err = g->ops.fifo.reset_enable_hw(g);
-
-	if (err) {
-		nvgpu_err(g, "failed to reset gk20a fifo");
-		goto done;
-	}
-
-	err = nvgpu_init_ltc_support(g);
-	if (err) {
-		nvgpu_err(g, "failed to init ltc");
-		goto done;
-	}
-
-	err = nvgpu_init_mm_support(g);
-	if (err) {
-		nvgpu_err(g, "failed to init gk20a mm");
-		goto done;
-	}
-
-	err = gk20a_init_fifo_support(g);
+	err = gk20a_init_mem_stages(g, sched);
 	if (err) {
-		nvgpu_err(g, "failed to init gk20a fifo");
 		goto done;
 	}
 
@@ -293,64 +406,8 @@ int gk20a_finalize_poweron(struct gk20a *g)
 			g->ops.gr.powergate_tpc(g);
 	}
 
-	err = gk20a_enable_gr_hw(g);
+	err = gk20a_init_falcon_stages(g, sched);
 	if (err) {
-		nvgpu_err(g, "failed to enable gr");
-		nvgpu_mutex_release(&g->tpc_pg_lock);
-		goto done;
-	}
-
-	if (g->ops.pmu.is_pmu_supported(g)) {
-		if (g->ops.pmu.prepare_ucode) {
-			err = g->ops.pmu.prepare_ucode(g);
-		}
-		if (err) {
-			nvgpu_err(g, "failed to init pmu ucode");
-			nvgpu_mutex_release(&g->tpc_pg_lock);
-			goto done;
-		}
-	}
-
-	if (nvgpu_is_enabled(g, NVGPU_PMU_PSTATE)) {
-		err = gk20a_init_pstate_support(g);
-		if (err) {
-			nvgpu_err(g, "failed to init pstates");
-			nvgpu_mutex_release(&g->tpc_pg_lock);
-			goto done;
-		}
-	}
-
-	if (g->acr.bootstrap_hs_acr != NULL &&
-		nvgpu_is_enabled(g, NVGPU_SEC_PRIVSECURITY)) {
-		err = g->acr.bootstrap_hs_acr(g, &g->acr, &g->acr.acr);
-		if (err != 0) {
-			nvgpu_err(g, "ACR bootstrap failed");
-			nvgpu_mutex_release(&g->tpc_pg_lock);
-			goto done;
-		}
-	}
-
-	if (nvgpu_is_enabled(g, NVGPU_SUPPORT_SEC2_RTOS)) {
-		err = nvgpu_init_sec2_support(g);
-		if (err != 0) {
-			nvgpu_err(g, "failed to init sec2");
-			nvgpu_mutex_release(&g->tpc_pg_lock);
-			goto done;
-		}
-	}
-
-	if (g->ops.pmu.is_pmu_supported(g)) {
-		err = nvgpu_init_pmu_support(g);
-		if (err) {
-			nvgpu_err(g, "failed to init gk20a pmu");
-			nvgpu_mutex_release(&g->tpc_pg_lock);
-			goto done;
-		}
-	}
-
-	err = gk20a_init_gr_support(g);
-	if (err) {
-		nvgpu_err(g, "failed to init gk20a gr");
 		nvgpu_mutex_release(&g->tpc_pg_lock);
 		goto done;
 	}
@@ -431,6 +488,8 @@ int gk20a_finalize_poweron(struct gk20a *g)
 	}
 
 done:
+	nvgpu_init_sched_report(sched);
+
 	if (err) {
 		g->power_on = false;
 	}
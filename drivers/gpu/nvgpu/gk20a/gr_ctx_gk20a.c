@@ -1,7 +1,7 @@
 /*
  * GK20A Graphics Context
  *
- * Copyright (c) 2011-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2011-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -34,10 +34,19 @@
 
 #include <nvgpu/hw/gk20a/hw_gr_gk20a.h>
 
+/*
+ * With a resident netlist image (ctx_vars.netlist_fw set) the lists point
+ * straight into the firmware blob instead of getting their own copies.
+ */
 static int gr_gk20a_alloc_load_netlist_u32(struct gk20a *g, u32 *src, u32 len,
 			struct u32_list_gk20a *u32_list)
 {
 	u32_list->count = (len + sizeof(u32) - 1) / sizeof(u32);
+	if (g->gr.ctx_vars.netlist_fw != NULL) {
+		u32_list->l = src;
+		return 0;
+	}
+
 	if (!alloc_u32_list_gk20a(g, u32_list)) {
 		return -ENOMEM;
 	}
@@ -51,6 +60,11 @@ static int gr_gk20a_alloc_load_netlist_av(struct gk20a *g, u32 *src, u32 len,
 			struct av_list_gk20a *av_list)
 {
 	av_list->count = len / sizeof(struct av_gk20a);
+	if (g->gr.ctx_vars.netlist_fw != NULL) {
+		av_list->l = (struct av_gk20a *)src;
+		return 0;
+	}
+
 	if (!alloc_av_list_gk20a(g, av_list)) {
 		return -ENOMEM;
 	}
@@ -64,6 +78,11 @@ static int gr_gk20a_alloc_load_netlist_av64(struct gk20a *g, u32 *src, u32 len,
 			struct av64_list_gk20a *av64_list)
 {
 	av64_list->count = len / sizeof(struct av64_gk20a);
+	if (g->gr.ctx_vars.netlist_fw != NULL) {
+		av64_list->l = (struct av64_gk20a *)src;
+		return 0;
+	}
+
 	if (!alloc_av64_list_gk20a(g, av64_list)) {
 		return -ENOMEM;
 	}
@@ -77,6 +96,11 @@ static int gr_gk20a_alloc_load_netlist_aiv(struct gk20a *g, u32 *src, u32 len,
 			struct aiv_list_gk20a *aiv_list)
 {
 	aiv_list->count = len / sizeof(struct aiv_gk20a);
+	if (g->gr.ctx_vars.netlist_fw != NULL) {
+		aiv_list->l = (struct aiv_gk20a *)src;
+		return 0;
+	}
+
 	if (!alloc_aiv_list_gk20a(g, aiv_list)) {
 		return -ENOMEM;
 	}
@@ -86,6 +110,122 @@ static int gr_gk20a_alloc_load_netlist_aiv(struct gk20a *g, u32 *src, u32 len,
 	return 0;
 }
 
+/*
+ * Check the region table of a netlist image against the blob size once,
+ * before any region is parsed. Returns -EINVAL for a truncated or corrupt
+ * image. On success *zero_copy tells whether every region is u32 aligned
+ * in both offset and size, i.e. whether the lists can reference the blob
+ * directly.
+ */
+static int gr_gk20a_netlist_validate(struct gk20a *g,
+			struct nvgpu_firmware *netlist_fw, bool *zero_copy)
+{
+	struct netlist_image *netlist =
+		(struct netlist_image *)netlist_fw->data;
+	size_t size = netlist_fw->size;
+	u64 end;
+	u32 i;
+
+	*zero_copy = ((uintptr_t)netlist_fw->data % sizeof(u32)) == 0U;
+
+	if (size < sizeof(struct netlist_image_header)) {
+		nvgpu_err(g, "netlist image too small: %zu", size);
+		return -EINVAL;
+	}
+
+	end = sizeof(struct netlist_image_header) +
+		(u64)netlist->header.regions * sizeof(struct netlist_region);
+	if (end > size) {
+		nvgpu_err(g, "netlist region table truncated: %u regions",
+			netlist->header.regions);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < netlist->header.regions; i++) {
+		struct netlist_region *region = &netlist->regions[i];
+
+		end = (u64)region->data_offset + region->data_size;
+		if (end > size) {
+			nvgpu_err(g, "netlist region %u (id %u) out of bounds",
+				i, region->region_id);
+			return -EINVAL;
+		}
+
+		/*
+		 * u32 lists round a partial trailing word up, which only the
+		 * zero filled copy can back; referencing the blob would read
+		 * past the region.
+		 */
+		if ((region->data_offset % sizeof(u32)) != 0U ||
+		    (region->data_size % sizeof(u32)) != 0U) {
+			*zero_copy = false;
+		}
+	}
+
+	return 0;
+}
+
+void gr_gk20a_free_ctx_vars(struct gk20a *g, struct gr_gk20a *gr)
+{
+	gr->ctx_vars.valid = false;
+
+	if (gr->ctx_vars.netlist_fw != NULL) {
+		/* lists point into the image; drop them with it */
+		nvgpu_release_firmware(g, gr->ctx_vars.netlist_fw);
+		gr->ctx_vars.netlist_fw = NULL;
+		(void) memset(&gr->ctx_vars.ucode, 0,
+			sizeof(gr->ctx_vars.ucode));
+		(void) memset(&gr->ctx_vars.sw_bundle_init, 0,
+			sizeof(gr->ctx_vars.sw_bundle_init));
+		(void) memset(&gr->ctx_vars.sw_method_init, 0,
+			sizeof(gr->ctx_vars.sw_method_init));
+		(void) memset(&gr->ctx_vars.sw_ctx_load, 0,
+			sizeof(gr->ctx_vars.sw_ctx_load));
+		(void) memset(&gr->ctx_vars.sw_non_ctx_load, 0,
+			sizeof(gr->ctx_vars.sw_non_ctx_load));
+		(void) memset(&gr->ctx_vars.sw_veid_bundle_init, 0,
+			sizeof(gr->ctx_vars.sw_veid_bundle_init));
+		(void) memset(&gr->ctx_vars.sw_bundle64_init, 0,
+			sizeof(gr->ctx_vars.sw_bundle64_init));
+		(void) memset(&gr->ctx_vars.ctxsw_regs, 0,
+			sizeof(gr->ctx_vars.ctxsw_regs));
+		return;
+	}
+
+	nvgpu_kfree(g, gr->ctx_vars.ucode.fecs.inst.l);
+	nvgpu_kfree(g, gr->ctx_vars.ucode.fecs.data.l);
+	nvgpu_kfree(g, gr->ctx_vars.ucode.gpccs.inst.l);
+	nvgpu_kfree(g, gr->ctx_vars.ucode.gpccs.data.l);
+	nvgpu_kfree(g, gr->ctx_vars.sw_bundle_init.l);
+	nvgpu_kfree(g, gr->ctx_vars.sw_method_init.l);
+	nvgpu_kfree(g, gr->ctx_vars.sw_ctx_load.l);
+	nvgpu_kfree(g, gr->ctx_vars.sw_non_ctx_load.l);
+	nvgpu_kfree(g, gr->ctx_vars.sw_veid_bundle_init.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.sys.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.gpc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.tpc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.zcull_gpc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.ppc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_sys.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_gpc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_tpc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_ppc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.perf_sys.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.fbp.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.perf_gpc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.fbp_router.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.gpc_router.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_ltc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_fbpa.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.perf_sys_router.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.perf_pma.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_rop.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_ucgpc.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.etpc.l);
+	nvgpu_kfree(g, gr->ctx_vars.sw_bundle64_init.l);
+	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_cau.l);
+}
+
 static int gr_gk20a_init_ctx_vars_fw(struct gk20a *g, struct gr_gk20a *gr)
 {
 	struct nvgpu_firmware *netlist_fw;
@@ -93,6 +233,7 @@ static int gr_gk20a_init_ctx_vars_fw(struct gk20a *g, struct gr_gk20a *gr)
 	char name[MAX_NETLIST_NAME];
 	u32 i, major_v = ~0, major_v_hw, netlist_num;
 	int net, max, err = -ENOENT;
+	bool zero_copy = false;
 
 	nvgpu_log_fn(g, " ");
 
@@ -121,6 +262,18 @@ static int gr_gk20a_init_ctx_vars_fw(struct gk20a *g, struct gr_gk20a *gr)
 			continue;
 		}
 
+		err = gr_gk20a_netlist_validate(g, netlist_fw, &zero_copy);
+		if (err != 0) {
+			nvgpu_release_firmware(g, netlist_fw);
+			err = -ENOENT;
+			continue;
+		}
+
+		if (zero_copy) {
+			/* keep the image resident, lists reference it */
+			g->gr.ctx_vars.netlist_fw = netlist_fw;
+		}
+
 		netlist = (struct netlist_image *)netlist_fw->data;
 
 		for (i = 0; i < netlist->header.regions; i++) {
@@ -424,45 +577,18 @@ static int gr_gk20a_init_ctx_vars_fw(struct gk20a *g, struct gr_gk20a *gr)
 		g->gr.ctx_vars.valid = true;
 		g->gr.netlist = net;
 
-		nvgpu_release_firmware(g, netlist_fw);
+		if (!zero_copy) {
+			nvgpu_release_firmware(g, netlist_fw);
+		}
 		nvgpu_log_fn(g, "done");
 		goto done;
 
 clean_up:
-		g->gr.ctx_vars.valid = false;
-		nvgpu_kfree(g, g->gr.ctx_vars.ucode.fecs.inst.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ucode.fecs.data.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ucode.gpccs.inst.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ucode.gpccs.data.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.sw_bundle_init.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.sw_method_init.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.sw_ctx_load.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.sw_non_ctx_load.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.sw_veid_bundle_init.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.sys.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.gpc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.tpc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.zcull_gpc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.ppc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.pm_sys.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.pm_gpc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.pm_tpc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.pm_ppc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.perf_sys.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.fbp.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.perf_gpc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.fbp_router.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.gpc_router.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.pm_ltc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.pm_fbpa.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.perf_sys_router.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.perf_pma.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.pm_rop.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.pm_ucgpc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.etpc.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.sw_bundle64_init.l);
-		nvgpu_kfree(g, g->gr.ctx_vars.ctxsw_regs.pm_cau.l);
-		nvgpu_release_firmware(g, netlist_fw);
+		zero_copy = g->gr.ctx_vars.netlist_fw != NULL;
+		gr_gk20a_free_ctx_vars(g, &g->gr);
+		if (!zero_copy) {
+			nvgpu_release_firmware(g, netlist_fw);
+		}
 		err = -ENOENT;
 	}
 
@@ -1462,6 +1462,51 @@ error:
 	return err;
 }
 
+static void gr_gk20a_load_av_list(struct gk20a *g, struct av_list_gk20a *avl)
+{
+	if (avl->count == 0U) {
+		return;
+	}
+	nvgpu_writel_stream(g, &avl->l[0].addr, avl->count,
+		sizeof(struct av_gk20a) / sizeof(u32),
+		offsetof(struct av_gk20a, value) / sizeof(u32));
+}
+
+static void gr_gk20a_load_aiv_list(struct gk20a *g,
+				   struct aiv_list_gk20a *aivl)
+{
+	if (aivl->count == 0U) {
+		return;
+	}
+	nvgpu_writel_stream(g, &aivl->l[0].addr, aivl->count,
+		sizeof(struct aiv_gk20a) / sizeof(u32),
+		offsetof(struct aiv_gk20a, value) / sizeof(u32));
+}
+
+/*
+ * The shadow data register is latched by the index write trigger, so the
+ * pair has to stay ordered, but it only needs a barrier once at the end.
+ */
+static void gr_gk20a_load_method_init(struct gk20a *g,
+				      struct av_list_gk20a *sw_method_init)
+{
+	u32 last_method_data = 0;
+	u32 i;
+
+	for (i = 0; i < sw_method_init->count; i++) {
+		if ((i == 0U) ||
+		    (sw_method_init->l[i].value != last_method_data)) {
+			nvgpu_writel_relaxed(g, gr_pri_mme_shadow_raw_data_r(),
+				sw_method_init->l[i].value);
+			last_method_data = sw_method_init->l[i].value;
+		}
+		nvgpu_writel_relaxed(g, gr_pri_mme_shadow_raw_index_r(),
+			gr_pri_mme_shadow_raw_index_write_trigger_f() |
+			sw_method_init->l[i].addr);
+	}
+	nvgpu_wmb();
+}
+
 /* init global golden image from a fresh gr_ctx in channel ctx.
    save a copy in local_golden_image in ctx_vars */
 static int gr_gk20a_init_golden_ctx_image(struct gk20a *g,
@@ -1477,9 +1522,6 @@ static int gr_gk20a_init_golden_ctx_image(struct gk20a *g,
 	struct nvgpu_mem *gold_mem = &gr->global_ctx_buffer[GOLDEN_CTX].mem;
 	struct nvgpu_mem *gr_mem;
 	u32 err = 0;
-	struct aiv_list_gk20a *sw_ctx_load = &g->gr.ctx_vars.sw_ctx_load;
-	struct av_list_gk20a *sw_method_init = &g->gr.ctx_vars.sw_method_init;
-	u32 last_method_data = 0;
 
 	nvgpu_log_fn(g, " ");
 
@@ -1578,10 +1620,7 @@ static int gr_gk20a_init_golden_ctx_image(struct gk20a *g,
 				 GR_IDLE_CHECK_DEFAULT);
 
 	/* load ctx init */
-	for (i = 0; i < sw_ctx_load->count; i++) {
-		gk20a_writel(g, sw_ctx_load->l[i].addr,
-			     sw_ctx_load->l[i].value);
-	}
+	gr_gk20a_load_aiv_list(g, &g->gr.ctx_vars.sw_ctx_load);
 
 	if (g->ops.gr.init_preemption_state) {
 		g->ops.gr.init_preemption_state(g);
@@ -1637,24 +1676,7 @@ restore_fe_go_idle:
 	}
 
 	/* load method init */
-	if (sw_method_init->count) {
-		gk20a_writel(g, gr_pri_mme_shadow_raw_data_r(),
-			     sw_method_init->l[0].value);
-		gk20a_writel(g, gr_pri_mme_shadow_raw_index_r(),
-			     gr_pri_mme_shadow_raw_index_write_trigger_f() |
-			     sw_method_init->l[0].addr);
-		last_method_data = sw_method_init->l[0].value;
-	}
-	for (i = 1; i < sw_method_init->count; i++) {
-		if (sw_method_init->l[i].value != last_method_data) {
-			gk20a_writel(g, gr_pri_mme_shadow_raw_data_r(),
-				sw_method_init->l[i].value);
-			last_method_data = sw_method_init->l[i].value;
-		}
-		gk20a_writel(g, gr_pri_mme_shadow_raw_index_r(),
-			gr_pri_mme_shadow_raw_index_write_trigger_f() |
-			sw_method_init->l[i].addr);
-	}
+	gr_gk20a_load_method_init(g, &g->gr.ctx_vars.sw_method_init);
 
 	err = gr_gk20a_wait_idle(g, gk20a_get_gr_idle_timeout(g),
 				 GR_IDLE_CHECK_DEFAULT);
@@ -3258,34 +3280,7 @@ static void gk20a_remove_gr_support(struct gr_gk20a *gr)
 	gr->map_tiles = NULL;
 	gr->fbp_rop_l2_en_mask = NULL;
 
-	gr->ctx_vars.valid = false;
-	nvgpu_kfree(g, gr->ctx_vars.ucode.fecs.inst.l);
-	nvgpu_kfree(g, gr->ctx_vars.ucode.fecs.data.l);
-	nvgpu_kfree(g, gr->ctx_vars.ucode.gpccs.inst.l);
-	nvgpu_kfree(g, gr->ctx_vars.ucode.gpccs.data.l);
-	nvgpu_kfree(g, gr->ctx_vars.sw_bundle_init.l);
-	nvgpu_kfree(g, gr->ctx_vars.sw_veid_bundle_init.l);
-	nvgpu_kfree(g, gr->ctx_vars.sw_method_init.l);
-	nvgpu_kfree(g, gr->ctx_vars.sw_ctx_load.l);
-	nvgpu_kfree(g, gr->ctx_vars.sw_non_ctx_load.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.sys.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.gpc.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.tpc.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.zcull_gpc.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.ppc.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_sys.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_gpc.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_tpc.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_ppc.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.perf_sys.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.fbp.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.perf_gpc.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.fbp_router.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.gpc_router.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_ltc.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_fbpa.l);
-	nvgpu_kfree(g, gr->ctx_vars.sw_bundle64_init.l);
-	nvgpu_kfree(g, gr->ctx_vars.ctxsw_regs.pm_cau.l);
+	gr_gk20a_free_ctx_vars(g, gr);
 
 	nvgpu_vfree(g, gr->ctx_vars.local_golden_image);
 	gr->ctx_vars.local_golden_image = NULL;
@@ -3952,12 +3947,32 @@ clean_up:
 	}
 }
 
+static u32 gr_gk20a_zbc_color_hash(struct zbc_entry *zbc_val)
+{
+	u32 hash = zbc_val->format;
+	u32 i;
+
+	for (i = 0; i < GK20A_ZBC_COLOR_VALUE_SIZE; i++) {
+		hash = hash * 31U + zbc_val->color_ds[i];
+		hash = hash * 31U + zbc_val->color_l2[i];
+	}
+
+	return (hash ^ (hash >> 16)) & (GK20A_ZBC_HASH_SIZE - 1U);
+}
+
+static u32 gr_gk20a_zbc_depth_hash(struct zbc_entry *zbc_val)
+{
+	u32 hash = zbc_val->depth * 31U + zbc_val->format;
+
+	return (hash ^ (hash >> 16)) & (GK20A_ZBC_HASH_SIZE - 1U);
+}
+
 int gr_gk20a_add_zbc(struct gk20a *g, struct gr_gk20a *gr,
 		     struct zbc_entry *zbc_val)
 {
 	struct zbc_color_table *c_tbl;
 	struct zbc_depth_table *d_tbl;
-	u32 i;
+	u32 i, hash, index;
 	int ret = -ENOSPC;
 	bool added = false;
 	u32 entries;
@@ -3969,9 +3984,11 @@ int gr_gk20a_add_zbc(struct gk20a *g, struct gr_gk20a *gr,
 	switch (zbc_val->type) {
 	case GK20A_ZBC_TYPE_COLOR:
 		/* search existing tables */
-		for (i = 0; i < gr->max_used_color_index; i++) {
+		hash = gr_gk20a_zbc_color_hash(zbc_val);
+		for (i = gr->zbc_col_hash[hash]; i != 0U;
+				i = gr->zbc_col_hash_next[i - 1U]) {
 
-			c_tbl = &gr->zbc_col_tbl[i];
+			c_tbl = &gr->zbc_col_tbl[i - 1U];
 
 			if ((c_tbl->ref_cnt != 0U) &&
 			    (c_tbl->format == zbc_val->format) &&
@@ -3990,23 +4007,27 @@ int gr_gk20a_add_zbc(struct gk20a *g, struct gr_gk20a *gr,
 		if (!added &&
 		    gr->max_used_color_index < GK20A_ZBC_TABLE_SIZE) {
 
-			c_tbl =
-			    &gr->zbc_col_tbl[gr->max_used_color_index];
+			index = gr->max_used_color_index;
+			c_tbl = &gr->zbc_col_tbl[index];
 			WARN_ON(c_tbl->ref_cnt != 0);
 
-			ret = g->ops.gr.add_zbc_color(g, gr,
-				zbc_val, gr->max_used_color_index);
+			ret = g->ops.gr.add_zbc_color(g, gr, zbc_val, index);
 
 			if (ret == 0) {
+				gr->zbc_col_hash_next[index] =
+					gr->zbc_col_hash[hash];
+				gr->zbc_col_hash[hash] = index + 1U;
 				gr->max_used_color_index++;
 			}
 		}
 		break;
 	case GK20A_ZBC_TYPE_DEPTH:
 		/* search existing tables */
-		for (i = 0; i < gr->max_used_depth_index; i++) {
+		hash = gr_gk20a_zbc_depth_hash(zbc_val);
+		for (i = gr->zbc_dep_hash[hash]; i != 0U;
+				i = gr->zbc_dep_hash_next[i - 1U]) {
 
-			d_tbl = &gr->zbc_dep_tbl[i];
+			d_tbl = &gr->zbc_dep_tbl[i - 1U];
 
 			if ((d_tbl->ref_cnt != 0U) &&
 			    (d_tbl->depth == zbc_val->depth) &&
@@ -4021,14 +4042,16 @@ int gr_gk20a_add_zbc(struct gk20a *g, struct gr_gk20a *gr,
 		if (!added &&
 		    gr->max_used_depth_index < GK20A_ZBC_TABLE_SIZE) {
 
-			d_tbl =
-			    &gr->zbc_dep_tbl[gr->max_used_depth_index];
+			index = gr->max_used_depth_index;
+			d_tbl = &gr->zbc_dep_tbl[index];
 			WARN_ON(d_tbl->ref_cnt != 0);
 
-			ret = g->ops.gr.add_zbc_depth(g, gr,
-				zbc_val, gr->max_used_depth_index);
+			ret = g->ops.gr.add_zbc_depth(g, gr, zbc_val, index);
 
 			if (ret == 0) {
+				gr->zbc_dep_hash_next[index] =
+					gr->zbc_dep_hash[hash];
+				gr->zbc_dep_hash[hash] = index + 1U;
 				gr->max_used_depth_index++;
 			}
 		}
@@ -4559,11 +4582,8 @@ void gr_gk20a_fecs_host_int_enable(struct gk20a *g)
 static int gk20a_init_gr_setup_hw(struct gk20a *g)
 {
 	struct gr_gk20a *gr = &g->gr;
-	struct aiv_list_gk20a *sw_ctx_load = &g->gr.ctx_vars.sw_ctx_load;
-	struct av_list_gk20a *sw_method_init = &g->gr.ctx_vars.sw_method_init;
 	u32 data;
-	u32 last_method_data = 0;
-	u32 i, err;
+	u32 err;
 
 	nvgpu_log_fn(g, " ");
 
@@ -4630,10 +4650,7 @@ static int gk20a_init_gr_setup_hw(struct gk20a *g)
 	}
 
 	/* load ctx init */
-	for (i = 0; i < sw_ctx_load->count; i++) {
-		gk20a_writel(g, sw_ctx_load->l[i].addr,
-			     sw_ctx_load->l[i].value);
-	}
+	gr_gk20a_load_aiv_list(g, &g->gr.ctx_vars.sw_ctx_load);
 
 	err = gr_gk20a_wait_idle(g, gk20a_get_gr_idle_timeout(g),
 				 GR_IDLE_CHECK_DEFAULT);
@@ -4678,24 +4695,7 @@ restore_fe_go_idle:
 	}
 
 	/* load method init */
-	if (sw_method_init->count) {
-		gk20a_writel(g, gr_pri_mme_shadow_raw_data_r(),
-			     sw_method_init->l[0].value);
-		gk20a_writel(g, gr_pri_mme_shadow_raw_index_r(),
-			     gr_pri_mme_shadow_raw_index_write_trigger_f() |
-			     sw_method_init->l[0].addr);
-		last_method_data = sw_method_init->l[0].value;
-	}
-	for (i = 1; i < sw_method_init->count; i++) {
-		if (sw_method_init->l[i].value != last_method_data) {
-			gk20a_writel(g, gr_pri_mme_shadow_raw_data_r(),
-				sw_method_init->l[i].value);
-			last_method_data = sw_method_init->l[i].value;
-		}
-		gk20a_writel(g, gr_pri_mme_shadow_raw_index_r(),
-			gr_pri_mme_shadow_raw_index_write_trigger_f() |
-			sw_method_init->l[i].addr);
-	}
+	gr_gk20a_load_method_init(g, &g->gr.ctx_vars.sw_method_init);
 
 	err = gr_gk20a_wait_idle(g, gk20a_get_gr_idle_timeout(g),
 				 GR_IDLE_CHECK_DEFAULT);
@@ -4792,8 +4792,7 @@ out:
 
 static int gk20a_init_gr_reset_enable_hw(struct gk20a *g)
 {
-	struct av_list_gk20a *sw_non_ctx_load = &g->gr.ctx_vars.sw_non_ctx_load;
-	u32 i, err = 0;
+	u32 err = 0;
 
 	nvgpu_log_fn(g, " ");
 
@@ -4802,10 +4801,7 @@ static int gk20a_init_gr_reset_enable_hw(struct gk20a *g)
 	gk20a_writel(g, gr_intr_en_r(), ~0);
 
 	/* load non_ctx init */
-	for (i = 0; i < sw_non_ctx_load->count; i++) {
-		gk20a_writel(g, sw_non_ctx_load->l[i].addr,
-			sw_non_ctx_load->l[i].value);
-	}
+	gr_gk20a_load_av_list(g, &g->gr.ctx_vars.sw_non_ctx_load);
 
 	err = gr_gk20a_wait_mem_scrubbing(g);
 	if (err != 0U) {
@@ -5830,6 +5826,7 @@ static int gk20a_gr_handle_tpc_exception(struct gk20a *g, u32 gpc, u32 tpc,
 	if (gr_gpc0_tpc0_tpccs_tpc_exception_sm_v(tpc_exception) ==
 			gr_gpc0_tpc0_tpccs_tpc_exception_sm_pending_v()) {
 		u32 esr_sm_sel, sm;
+		unsigned long pending_sms;
 
 		nvgpu_log(g, gpu_dbg_intr | gpu_dbg_gpu_dbg,
 				"GPC%d TPC%d: SM exception pending", gpc, tpc);
@@ -5841,12 +5838,8 @@ static int gk20a_gr_handle_tpc_exception(struct gk20a *g, u32 gpc, u32 tpc,
 
 		g->ops.gr.get_esr_sm_sel(g, gpc, tpc, &esr_sm_sel);
 
-		for (sm = 0; sm < sm_per_tpc; sm++) {
-
-			if ((esr_sm_sel & BIT32(sm)) == 0U) {
-				continue;
-			}
-
+		pending_sms = esr_sm_sel;
+		for_each_set_bit(sm, &pending_sms, sm_per_tpc) {
 			nvgpu_log(g, gpu_dbg_intr | gpu_dbg_gpu_dbg,
 				"GPC%d TPC%d: SM%d exception pending",
 				 gpc, tpc, sm);
@@ -5889,14 +5882,17 @@ static int gk20a_gr_handle_gpc_exception(struct gk20a *g, bool *post_event,
 	struct gr_gk20a *gr = &g->gr;
 	u32 exception1 = gk20a_readl(g, gr_exception1_r());
 	u32 gpc_exception;
+	unsigned long pending_gpcs, pending_tpcs;
 
 	nvgpu_log(g, gpu_dbg_intr | gpu_dbg_gpu_dbg, " ");
 
-	for (gpc = 0; gpc < gr->gpc_count; gpc++) {
-		if ((exception1 & (1 << gpc)) == 0) {
-			continue;
-		}
-
+	/*
+	 * exception1 aggregates the per-GPC exception state and each GPC's
+	 * gpc_exception aggregates its TPCs, so walk only the units that are
+	 * flagged instead of probing every GPC/TPC.
+	 */
+	pending_gpcs = exception1;
+	for_each_set_bit(gpc, &pending_gpcs, gr->gpc_count) {
 		nvgpu_log(g, gpu_dbg_intr | gpu_dbg_gpu_dbg,
 				"GPC%d exception pending", gpc);
 
@@ -5906,12 +5902,8 @@ static int gk20a_gr_handle_gpc_exception(struct gk20a *g, bool *post_event,
 				+ gpc_offset);
 
 		/* check if any tpc has an exception */
-		for (tpc = 0; tpc < gr->gpc_tpc_count[gpc]; tpc++) {
-			if ((gr_gpc0_gpccs_gpc_exception_tpc_v(gpc_exception) &
-				(1 << tpc)) == 0) {
-				continue;
-			}
-
+		pending_tpcs = gr_gpc0_gpccs_gpc_exception_tpc_v(gpc_exception);
+		for_each_set_bit(tpc, &pending_tpcs, gr->gpc_tpc_count[gpc]) {
 			nvgpu_log(g, gpu_dbg_intr | gpu_dbg_gpu_dbg,
 				  "GPC%d: TPC%d exception pending", gpc, tpc);
 
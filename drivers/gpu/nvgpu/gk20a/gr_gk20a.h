@@ -319,6 +319,8 @@ struct gr_gk20a {
 		} ctxsw_regs;
 		u32 regs_base_index;
 		bool valid;
+		/* resident netlist image backing the lists above, if any */
+		struct nvgpu_firmware *netlist_fw;
 
 		u32 preempt_image_size;
 		bool force_preemption_gfxp;
@@ -410,6 +412,16 @@ struct gr_gk20a {
 	u32 max_used_depth_index;
 	u32 max_used_s_index;
 
+	/*
+	 * Hash chains over the used color/depth entries. Heads and links hold
+	 * table index + 1 so that zero terminates a chain.
+	 */
+#define GK20A_ZBC_HASH_SIZE		16U /* must be power of 2 */
+	u8 zbc_col_hash[GK20A_ZBC_HASH_SIZE];
+	u8 zbc_col_hash_next[GK20A_ZBC_TABLE_SIZE];
+	u8 zbc_dep_hash[GK20A_ZBC_HASH_SIZE];
+	u8 zbc_dep_hash_next[GK20A_ZBC_TABLE_SIZE];
+
 #define GR_CHANNEL_MAP_TLB_SIZE		2 /* must of power of 2 */
 	struct gr_channel_map_tlb_entry chid_tlb[GR_CHANNEL_MAP_TLB_SIZE];
 	u32 channel_tlb_flush_index;
@@ -147,8 +147,9 @@ int exec_regops_gk20a(struct dbg_session_gk20a *dbg_s,
 		case REGOP(READ_32):
 			ops[i].value_hi = 0;
 			ops[i].value_lo = gk20a_readl(g, ops[i].offset);
-			nvgpu_log(g, gpu_dbg_gpu_dbg, "read_32 0x%08x from 0x%08x",
-				   ops[i].value_lo, ops[i].offset);
+			nvgpu_log_bin(g, gpu_dbg_gpu_dbg,
+				"read_32 0x%08llx from 0x%08llx",
+				ops[i].value_lo, ops[i].offset, 0, 0);
 
 			break;
 
@@ -157,9 +158,10 @@ int exec_regops_gk20a(struct dbg_session_gk20a *dbg_s,
 			ops[i].value_hi =
 				gk20a_readl(g, ops[i].offset + 4);
 
-			nvgpu_log(g, gpu_dbg_gpu_dbg, "read_64 0x%08x:%08x from 0x%08x",
-				   ops[i].value_hi, ops[i].value_lo,
-				   ops[i].offset);
+			nvgpu_log_bin(g, gpu_dbg_gpu_dbg,
+				"read_64 0x%08llx:%08llx from 0x%08llx",
+				ops[i].value_hi, ops[i].value_lo,
+				ops[i].offset, 0);
 		break;
 
 		case REGOP(WRITE_32):
@@ -196,13 +198,15 @@ int exec_regops_gk20a(struct dbg_session_gk20a *dbg_s,
 
 			/* now update first 32bits */
 			gk20a_writel(g, ops[i].offset, data32_lo);
-			nvgpu_log(g, gpu_dbg_gpu_dbg, "Wrote 0x%08x to 0x%08x ",
-				   data32_lo, ops[i].offset);
+			nvgpu_log_bin(g, gpu_dbg_gpu_dbg,
+				"Wrote 0x%08llx to 0x%08llx",
+				data32_lo, ops[i].offset, 0, 0);
 			/* if desired, update second 32bits */
 			if (ops[i].op == REGOP(WRITE_64)) {
 				gk20a_writel(g, ops[i].offset + 4, data32_hi);
-				nvgpu_log(g, gpu_dbg_gpu_dbg, "Wrote 0x%08x to 0x%08x ",
-					   data32_hi, ops[i].offset + 4);
+				nvgpu_log_bin(g, gpu_dbg_gpu_dbg,
+					"Wrote 0x%08llx to 0x%08llx",
+					data32_hi, ops[i].offset + 4U, 0, 0);
 
 			}
 
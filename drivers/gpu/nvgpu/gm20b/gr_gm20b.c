@@ -1332,11 +1332,9 @@ int gm20b_gr_record_sm_error_state(struct gk20a *g, u32 gpc, u32 tpc, u32 sm,
 	u32 tpc_in_gpc_stride = nvgpu_get_litter_value(g,
 					       GPU_LIT_TPC_IN_GPC_STRIDE);
 	u32 offset = gpc_stride * gpc + tpc_in_gpc_stride * tpc;
-	struct nvgpu_tsg_sm_error_state *sm_error_states = NULL;
+	struct nvgpu_tsg_sm_error_state sm_error_state;
 	struct tsg_gk20a *tsg = NULL;
 
-	nvgpu_mutex_acquire(&g->dbg_sessions_lock);
-
 	sm_id = gr_gpc0_tpc0_sm_cfg_sm_id_v(gk20a_readl(g,
 			gr_gpc0_tpc0_sm_cfg_r() + offset));
 
@@ -1346,13 +1344,17 @@ int gm20b_gr_record_sm_error_state(struct gk20a *g, u32 gpc, u32 tpc, u32 sm,
 
 	if (tsg == NULL) {
 		nvgpu_err(g, "no valid tsg");
-		goto record_fail;
+		return sm_id;
 	}
 
-	sm_error_states = tsg->sm_error_states + sm_id;
-	gm20b_gr_read_sm_error_state(g, offset, sm_error_states);
+	/*
+	 * Capture the ESRs before taking dbg_sessions_lock so the stall ISR
+	 * holds the lock only for the copy into the TSG.
+	 */
+	gm20b_gr_read_sm_error_state(g, offset, &sm_error_state);
 
-record_fail:
+	nvgpu_mutex_acquire(&g->dbg_sessions_lock);
+	gk20a_tsg_update_sm_error_state_locked(tsg, sm_id, &sm_error_state);
 	nvgpu_mutex_release(&g->dbg_sessions_lock);
 
 	return sm_id;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -144,6 +144,7 @@ int gp106_init_clk_arbiter(struct gk20a *g)
 	nvgpu_spinlock_init(&arb->sessions_lock);
 	nvgpu_spinlock_init(&arb->users_lock);
 	nvgpu_spinlock_init(&arb->requests_lock);
+	nvgpu_spinlock_init(&arb->pending_lock);
 
 	arb->mclk_f_points = nvgpu_kcalloc(g, MAX_F_POINTS, sizeof(u16));
 	if (!arb->mclk_f_points) {
@@ -157,6 +158,16 @@ int gp106_init_clk_arbiter(struct gk20a *g)
 		goto init_fail;
 	}
 
+	arb->vf_lookup = nvgpu_kzalloc(g, sizeof(*arb->vf_lookup));
+	if (!arb->vf_lookup) {
+		err = -ENOMEM;
+		goto init_fail;
+	}
+
+	err = nvgpu_clk_arb_agg_init(g, &arb->agg);
+	if (err < 0)
+		goto init_fail;
+
 	for (index = 0; index < 2; index++) {
 		table = &arb->vf_table_pool[index];
 		table->gpc2clk_num_points = MAX_F_POINTS;
@@ -212,6 +223,7 @@ int gp106_init_clk_arbiter(struct gk20a *g)
 	nvgpu_init_list_node(&arb->users);
 	nvgpu_init_list_node(&arb->sessions);
 	nvgpu_init_list_node(&arb->requests);
+	nvgpu_init_list_node(&arb->pending);
 
 	nvgpu_cond_init(&arb->request_wq);
 
@@ -252,6 +264,8 @@ int gp106_init_clk_arbiter(struct gk20a *g)
 	return arb->status;
 
 init_fail:
+	nvgpu_clk_arb_agg_deinit(g, &arb->agg);
+	nvgpu_kfree(g, arb->vf_lookup);
 	nvgpu_kfree(g, arb->gpc2clk_f_points);
 	nvgpu_kfree(g, arb->mclk_f_points);
 
@@ -446,17 +460,26 @@ static int nvgpu_clk_arb_change_vf_point(struct gk20a *g, u16 gpc2clk_target,
 	return 0;
 }
 
+static void gp106_clk_arb_record_targets(struct nvgpu_clk_arb *arb,
+		u16 gpc2clk, u16 mclk, bool not_possible)
+{
+	arb->last.gpc2clk = gpc2clk;
+	arb->last.mclk = mclk;
+	arb->last_not_possible = not_possible;
+	arb->last_vf_table_gen = arb->vf_table_gen;
+	arb->last_valid = true;
+}
+
 void gp106_clk_arb_run_arbiter_cb(struct nvgpu_clk_arb *arb)
 {
-	struct nvgpu_clk_session *session;
 	struct nvgpu_clk_dev *dev;
 	struct nvgpu_clk_dev *tmp;
-	struct nvgpu_clk_arb_target *target, *actual;
+	struct nvgpu_clk_arb_target *actual;
 	struct gk20a *g = arb->g;
 
 	u32 pstate = VF_POINT_INVALID_PSTATE;
 	u32 voltuv, voltuv_sram;
-	bool mclk_set, gpc2clk_set;
+	bool not_possible;
 	u32 nuvmin, nuvmin_sram;
 
 	u32 alarms_notified = 0;
@@ -484,59 +507,7 @@ void gp106_clk_arb_run_arbiter_cb(struct nvgpu_clk_arb *arb)
 #endif
 
 	/* Only one arbiter should be running */
-	gpc2clk_target = 0;
-	mclk_target = 0;
-
-	nvgpu_spinlock_acquire(&arb->sessions_lock);
-	nvgpu_list_for_each_entry(session, &arb->sessions,
-			nvgpu_clk_session, link) {
-		if (!session->zombie) {
-			mclk_set = false;
-			gpc2clk_set = false;
-			target = (session->target == &session->target_pool[0] ?
-					&session->target_pool[1] :
-					&session->target_pool[0]);
-			nvgpu_spinlock_acquire(&session->session_lock);
-			if (!nvgpu_list_empty(&session->targets)) {
-				/* Copy over state */
-				target->mclk = session->target->mclk;
-				target->gpc2clk = session->target->gpc2clk;
-				/* Query the latest committed request */
-				nvgpu_list_for_each_entry_safe(dev, tmp,
-				 &session->targets, nvgpu_clk_dev, node) {
-					if (!mclk_set && dev->mclk_target_mhz) {
-						target->mclk =
-							dev->mclk_target_mhz;
-						mclk_set = true;
-					}
-					if (!gpc2clk_set &&
-						dev->gpc2clk_target_mhz) {
-						target->gpc2clk =
-							dev->gpc2clk_target_mhz;
-						gpc2clk_set = true;
-					}
-					nvgpu_ref_get(&dev->refcount);
-					nvgpu_list_del(&dev->node);
-					nvgpu_spinlock_acquire(
-						&arb->requests_lock);
-					nvgpu_list_add(
-						&dev->node, &arb->requests);
-					nvgpu_spinlock_release(&arb->requests_lock);
-				}
-				session->target = target;
-			}
-			nvgpu_spinlock_release(
-				&session->session_lock);
-
-			mclk_target = mclk_target > session->target->mclk ?
-				mclk_target : session->target->mclk;
-
-			gpc2clk_target =
-				gpc2clk_target > session->target->gpc2clk ?
-				gpc2clk_target : session->target->gpc2clk;
-		}
-	}
-	nvgpu_spinlock_release(&arb->sessions_lock);
+	nvgpu_clk_arb_aggregate_targets(arb, &gpc2clk_target, &mclk_target);
 
 	gpc2clk_target = (gpc2clk_target > 0) ? gpc2clk_target :
 			arb->gpc2clk_default_mhz;
@@ -562,6 +533,22 @@ void gp106_clk_arb_run_arbiter_cb(struct nvgpu_clk_arb *arb)
 	gpc2clk_session_target = gpc2clk_target;
 	mclk_session_target = mclk_target;
 
+	/*
+	 * Nothing to do if the aggregate and the VF table are the ones the
+	 * clocks were last programmed for; only the requests need completing.
+	 */
+	if (arb->last_valid &&
+		(arb->last_vf_table_gen == arb->vf_table_gen) &&
+		(arb->last.gpc2clk == gpc2clk_session_target) &&
+		(arb->last.mclk == mclk_session_target)) {
+		clk_arb_dbg(g, "aggregate unchanged");
+		if (arb->last_not_possible)
+			nvgpu_clk_arb_set_global_alarm(g,
+				EVENT(ALARM_TARGET_VF_NOT_POSSIBLE));
+		goto exit_arb;
+	}
+	arb->last_valid = false;
+
 	/* Query the table for the closest vf point to program */
 	pstate = nvgpu_clk_arb_find_vf_point(arb, &gpc2clk_target,
 		&sys2clk_target, &xbar2clk_target, &mclk_target, &voltuv,
@@ -574,14 +561,17 @@ void gp106_clk_arb_run_arbiter_cb(struct nvgpu_clk_arb *arb)
 		goto exit_arb;
 	}
 
-	if ((gpc2clk_target < gpc2clk_session_target) ||
-			(mclk_target < mclk_session_target))
+	not_possible = (gpc2clk_target < gpc2clk_session_target) ||
+			(mclk_target < mclk_session_target);
+	if (not_possible)
 		nvgpu_clk_arb_set_global_alarm(g,
 			EVENT(ALARM_TARGET_VF_NOT_POSSIBLE));
 
 	if ((arb->actual->gpc2clk == gpc2clk_target) &&
 		(arb->actual->mclk == mclk_target) &&
 		(arb->voltuv_actual == voltuv)) {
+		gp106_clk_arb_record_targets(arb, gpc2clk_session_target,
+			mclk_session_target, not_possible);
 		goto exit_arb;
 	}
 
@@ -673,6 +663,9 @@ void gp106_clk_arb_run_arbiter_cb(struct nvgpu_clk_arb *arb)
 	nvgpu_smp_wmb();
 	nvgpu_atomic_inc(&arb->req_nr);
 
+	gp106_clk_arb_record_targets(arb, gpc2clk_session_target,
+		mclk_session_target, not_possible);
+
 	/* Unlock pstate change for PG */
 	nvgpu_mutex_release(&arb->pstate_lock);
 
@@ -755,6 +748,8 @@ void gp106_clk_arb_cleanup(struct nvgpu_clk_arb *arb)
 	struct gk20a *g = arb->g;
 	int index;
 
+	nvgpu_clk_arb_agg_deinit(g, &arb->agg);
+	nvgpu_kfree(g, arb->vf_lookup);
 	nvgpu_kfree(g, arb->gpc2clk_f_points);
 	nvgpu_kfree(g, arb->mclk_f_points);
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -146,6 +146,7 @@ int gp10b_init_clk_arbiter(struct gk20a *g)
 	nvgpu_spinlock_init(&arb->sessions_lock);
 	nvgpu_spinlock_init(&arb->users_lock);
 	nvgpu_spinlock_init(&arb->requests_lock);
+	nvgpu_spinlock_init(&arb->pending_lock);
 
 	arb->gpc2clk_f_points = nvgpu_kcalloc(g, MAX_F_POINTS, sizeof(u16));
 	if (arb->gpc2clk_f_points == NULL) {
@@ -153,6 +154,11 @@ int gp10b_init_clk_arbiter(struct gk20a *g)
 		goto init_fail;
 	}
 
+	err = nvgpu_clk_arb_agg_init(g, &arb->agg);
+	if (err < 0) {
+		goto init_fail;
+	}
+
 	for (index = 0; index < 2; index++) {
 		table = &arb->vf_table_pool[index];
 		table->gpc2clk_num_points = MAX_F_POINTS;
@@ -200,6 +206,7 @@ int gp10b_init_clk_arbiter(struct gk20a *g)
 	nvgpu_init_list_node(&arb->users);
 	nvgpu_init_list_node(&arb->sessions);
 	nvgpu_init_list_node(&arb->requests);
+	nvgpu_init_list_node(&arb->pending);
 
 	err = nvgpu_cond_init(&arb->request_wq);
 	if (err < 0) {
@@ -233,6 +240,7 @@ int gp10b_init_clk_arbiter(struct gk20a *g)
 	return arb->status;
 
 init_fail:
+	nvgpu_clk_arb_agg_deinit(g, &arb->agg);
 	nvgpu_kfree(g, arb->gpc2clk_f_points);
 
 	for (index = 0; index < 2; index++) {
@@ -249,62 +257,20 @@ mutex_fail:
 
 void gp10b_clk_arb_run_arbiter_cb(struct nvgpu_clk_arb *arb)
 {
-	struct nvgpu_clk_session *session;
 	struct nvgpu_clk_dev *dev;
 	struct nvgpu_clk_dev *tmp;
-	struct nvgpu_clk_arb_target *target, *actual;
+	struct nvgpu_clk_arb_target *actual;
 	struct gk20a *g = arb->g;
 
-	bool gpc2clk_set;
-
 	int status = 0;
 	unsigned long rounded_rate = 0;
 
-	u16 gpc2clk_target, gpc2clk_session_target;
+	u16 gpc2clk_target, gpc2clk_session_target, mclk_target;
 
 	clk_arb_dbg(g, " ");
 
 	/* Only one arbiter should be running */
-	gpc2clk_target = 0;
-
-	nvgpu_spinlock_acquire(&arb->sessions_lock);
-	nvgpu_list_for_each_entry(session, &arb->sessions,
-			nvgpu_clk_session, link) {
-		if (session->zombie) {
-			continue;
-		}
-		gpc2clk_set = false;
-		target = (session->target == &session->target_pool[0] ?
-				&session->target_pool[1] :
-				&session->target_pool[0]);
-		nvgpu_spinlock_acquire(&session->session_lock);
-		if (nvgpu_list_empty(&session->targets) == 0) {
-			/* Copy over state */
-			target->gpc2clk = session->target->gpc2clk;
-			/* Query the latest committed request */
-			nvgpu_list_for_each_entry_safe(dev, tmp, &session->targets,
-						nvgpu_clk_dev, node) {
-				if (!gpc2clk_set &&
-					dev->gpc2clk_target_mhz != (u16)0) {
-					target->gpc2clk =
-						dev->gpc2clk_target_mhz;
-					gpc2clk_set = true;
-				}
-				nvgpu_ref_get(&dev->refcount);
-				nvgpu_list_del(&dev->node);
-				nvgpu_spinlock_acquire(&arb->requests_lock);
-				nvgpu_list_add(&dev->node, &arb->requests);
-				nvgpu_spinlock_release(&arb->requests_lock);
-			}
-			session->target = target;
-		}
-		nvgpu_spinlock_release(&session->session_lock);
-
-		gpc2clk_target =
-			gpc2clk_target > session->target->gpc2clk ?
-			gpc2clk_target : session->target->gpc2clk;
-	}
-	nvgpu_spinlock_release(&arb->sessions_lock);
+	nvgpu_clk_arb_aggregate_targets(arb, &gpc2clk_target, &mclk_target);
 
 	gpc2clk_target = (gpc2clk_target > (u16)0) ? gpc2clk_target :
 			arb->gpc2clk_default_mhz;
@@ -406,6 +372,7 @@ void gp10b_clk_arb_cleanup(struct nvgpu_clk_arb *arb)
 	struct gk20a *g = arb->g;
 	int index;
 
+	nvgpu_clk_arb_agg_deinit(g, &arb->agg);
 	nvgpu_kfree(g, arb->gpc2clk_f_points);
 
 	for (index = 0; index < 2; index++) {
@@ -462,7 +462,8 @@ static u32 gv100_nvlink_minion_load(struct gk20a *g)
 		return 0;
 
 	/* get mem unlock ucode binary */
-	nvgpu_minion_fw = nvgpu_request_firmware(g, "minion.bin", 0);
+	nvgpu_minion_fw = nvgpu_request_firmware(g, "minion.bin",
+			NVGPU_REQUEST_FIRMWARE_CACHE);
 	if (!nvgpu_minion_fw) {
 		nvgpu_err(g, "minion ucode get fail");
 		err = -ENOENT;
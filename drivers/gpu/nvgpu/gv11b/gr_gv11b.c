@@ -3309,11 +3309,9 @@ int gv11b_gr_record_sm_error_state(struct gk20a *g, u32 gpc, u32 tpc, u32 sm,
 	int sm_id;
 	u32 offset, sm_per_tpc, tpc_id;
 	u32 gpc_offset, gpc_tpc_offset;
-	struct nvgpu_tsg_sm_error_state *sm_error_states = NULL;
+	struct nvgpu_tsg_sm_error_state sm_error_state;
 	struct tsg_gk20a *tsg = NULL;
 
-	nvgpu_mutex_acquire(&g->dbg_sessions_lock);
-
 	sm_per_tpc = nvgpu_get_litter_value(g, GPU_LIT_NUM_SM_PER_TPC);
 	gpc_offset = gk20a_gr_gpc_offset(g, gpc);
 	gpc_tpc_offset = gpc_offset + gk20a_gr_tpc_offset(g, tpc);
@@ -3329,13 +3327,13 @@ int gv11b_gr_record_sm_error_state(struct gk20a *g, u32 gpc, u32 tpc, u32 sm,
 
 	if (tsg == NULL) {
 		nvgpu_err(g, "no valid tsg");
-		goto record_fail;
+		return sm_id;
 	}
 
-	sm_error_states = tsg->sm_error_states + sm_id;
-	gv11b_gr_read_sm_error_state(g, offset, sm_error_states);
+	gv11b_gr_read_sm_error_state(g, offset, &sm_error_state);
 
-record_fail:
+	nvgpu_mutex_acquire(&g->dbg_sessions_lock);
+	gk20a_tsg_update_sm_error_state_locked(tsg, sm_id, &sm_error_state);
 	nvgpu_mutex_release(&g->dbg_sessions_lock);
 
 	return sm_id;
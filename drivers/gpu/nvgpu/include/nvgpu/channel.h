@@ -37,6 +37,7 @@ struct gk20a_fence;
 struct fifo_profile_gk20a;
 struct nvgpu_channel_sync;
 struct nvgpu_gpfifo_userdata;
+struct gk20a_debug_output;
 
 /* Flags to be passed to nvgpu_channel_setup_bind() */
 #define NVGPU_SETUP_BIND_FLAGS_SUPPORT_VPR		(1U << 0U)
@@ -219,6 +220,34 @@ struct channel_gk20a_ref_action {
 };
 #endif
 
+/*
+ * Always-on per-channel history of job lifecycle events. Writers claim a slot
+ * with one atomic increment and fill it without locking; a slot may be torn
+ * if the ring wraps under a concurrent reader, which is acceptable for a
+ * debug history. Timestamps come from nvgpu_hr_timestamp().
+ */
+#define NVGPU_CHANNEL_TRACE_ENTRIES	32U
+
+enum nvgpu_channel_trace_event_type {
+	NVGPU_CHANNEL_TRACE_SUBMIT = 1,
+	NVGPU_CHANNEL_TRACE_JOB_ADD,
+	NVGPU_CHANNEL_TRACE_FENCE_DONE,
+	NVGPU_CHANNEL_TRACE_CLEANUP,
+	NVGPU_CHANNEL_TRACE_TIMEOUT,
+};
+
+struct nvgpu_channel_trace_event {
+	u64 timestamp;
+	u32 type;
+	u32 arg0;
+	u64 arg1;
+};
+
+struct nvgpu_channel_trace {
+	nvgpu_atomic_t put;
+	struct nvgpu_channel_trace_event ents[NVGPU_CHANNEL_TRACE_ENTRIES];
+};
+
 /* this is the priv element of struct nvhost_channel */
 struct channel_gk20a {
 	struct gk20a *g; /* set only when channel is active */
@@ -273,6 +302,7 @@ struct channel_gk20a {
 
 	/* kernel watchdog to kill stuck jobs */
 	struct channel_gk20a_timeout timeout;
+	struct nvgpu_channel_trace trace;
 
 	/* for job cleanup handling in the background worker */
 	struct nvgpu_list_node worker_item;
@@ -475,4 +505,20 @@ static inline void trace_write_pushbuffers(struct channel_gk20a *c, u32 count)
 void gk20a_channel_set_timedout(struct channel_gk20a *ch);
 bool gk20a_channel_check_timedout(struct channel_gk20a *ch);
 
+static inline void nvgpu_channel_trace_record(struct channel_gk20a *ch,
+		u32 type, u32 arg0, u64 arg1)
+{
+	u32 idx = (u32)nvgpu_atomic_inc_return(&ch->trace.put) - 1U;
+	struct nvgpu_channel_trace_event *ev =
+		&ch->trace.ents[idx & (NVGPU_CHANNEL_TRACE_ENTRIES - 1U)];
+
+	ev->timestamp = nvgpu_hr_timestamp();
+	ev->type = type;
+	ev->arg0 = arg0;
+	ev->arg1 = arg1;
+}
+
+void nvgpu_channel_trace_dump(struct channel_gk20a *ch,
+		struct gk20a_debug_output *o);
+
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -45,6 +45,7 @@ struct gk20a;
 #define DEFAULT_EVENT_NUMBER 32
 
 struct nvgpu_clk_dev;
+struct clk_vf_lookup;
 struct nvgpu_clk_arb_target;
 struct nvgpu_clk_notification_queue;
 struct nvgpu_clk_session;
@@ -178,15 +179,32 @@ struct nvgpu_clk_arb_work_item {
 	struct nvgpu_list_node worker_item;
 };
 
+/*
+ * Max tree over the session targets. Each session owns one leaf; every inner
+ * node holds the max of its children, so the root is the aggregate target.
+ */
+struct nvgpu_clk_arb_agg {
+	struct nvgpu_spinlock lock;
+	u32 nr_slots;
+	unsigned long *slots;
+	u16 *gpc2clk;
+	u16 *mclk;
+};
+
 struct nvgpu_clk_arb {
 	struct nvgpu_spinlock sessions_lock;
 	struct nvgpu_spinlock users_lock;
 	struct nvgpu_spinlock requests_lock;
+	struct nvgpu_spinlock pending_lock;
 
 	struct nvgpu_mutex pstate_lock;
 	struct nvgpu_list_node users;
 	struct nvgpu_list_node sessions;
 	struct nvgpu_list_node requests;
+	/* sessions with requests not yet seen by the arbiter */
+	struct nvgpu_list_node pending;
+
+	struct nvgpu_clk_arb_agg agg;
 
 	struct gk20a *g;
 	int status;
@@ -209,6 +227,16 @@ struct nvgpu_clk_arb {
 	struct nvgpu_clk_vf_table *current_vf_table;
 	struct nvgpu_clk_vf_table vf_table_pool[2];
 	u32 vf_table_index;
+	u32 vf_table_gen;
+
+	/* Aggregate of the last successful arbitration */
+	bool last_valid;
+	bool last_not_possible;
+	u32 last_vf_table_gen;
+	struct nvgpu_clk_arb_target last;
+
+	/* VF curves behind the table, refreshed on each table update */
+	struct clk_vf_lookup *vf_lookup;
 
 	u16 *mclk_f_points;
 	nvgpu_atomic_t req_nr;
@@ -252,6 +280,8 @@ struct nvgpu_clk_session {
 	struct nvgpu_ref refcount;
 	struct nvgpu_list_node link;
 	struct nvgpu_list_node targets;
+	struct nvgpu_list_node pending;
+	u32 slot;
 
 	struct nvgpu_spinlock session_lock;
 	struct nvgpu_clk_arb_target target_pool[2];
@@ -265,6 +295,13 @@ nvgpu_clk_session_from_link(struct nvgpu_list_node *node)
 	   ((uintptr_t)node - offsetof(struct nvgpu_clk_session, link));
 };
 
+static inline struct nvgpu_clk_session *
+nvgpu_clk_session_from_pending(struct nvgpu_list_node *node)
+{
+	return (struct nvgpu_clk_session *)
+	   ((uintptr_t)node - offsetof(struct nvgpu_clk_session, pending));
+};
+
 static inline struct nvgpu_clk_dev *
 nvgpu_clk_dev_from_node(struct nvgpu_list_node *node)
 {
@@ -340,6 +377,22 @@ int nvgpu_clk_arb_install_request_fd(struct gk20a *g,
 
 void nvgpu_clk_arb_schedule_vf_table_update(struct gk20a *g);
 
+void nvgpu_clk_arb_session_post(struct nvgpu_clk_arb *arb,
+	struct nvgpu_clk_session *session);
+
+void nvgpu_clk_arb_aggregate_targets(struct nvgpu_clk_arb *arb,
+	u16 *gpc2clk_target, u16 *mclk_target);
+
+int nvgpu_clk_arb_agg_init(struct gk20a *g, struct nvgpu_clk_arb_agg *agg);
+void nvgpu_clk_arb_agg_deinit(struct gk20a *g, struct nvgpu_clk_arb_agg *agg);
+int nvgpu_clk_arb_agg_alloc_slot(struct gk20a *g,
+	struct nvgpu_clk_arb_agg *agg, u32 *slot);
+void nvgpu_clk_arb_agg_free_slot(struct nvgpu_clk_arb_agg *agg, u32 slot);
+bool nvgpu_clk_arb_agg_set(struct nvgpu_clk_arb_agg *agg, u32 slot,
+	u16 gpc2clk, u16 mclk);
+void nvgpu_clk_arb_agg_max(struct nvgpu_clk_arb_agg *agg,
+	u16 *gpc2clk, u16 *mclk);
+
 int nvgpu_clk_arb_get_current_pstate(struct gk20a *g);
 
 void nvgpu_clk_arb_pstate_change_lock(struct gk20a *g, bool lock);
@@ -30,8 +30,11 @@ struct gk20a;
  * increasing this constant should help (it drives Linux' internal buffer size).
  */
 #define GK20A_FECS_TRACE_NUM_RECORDS		(1 << 10)
-#define GK20A_FECS_TRACE_HASH_BITS		8 /* 2^8 */
+#define GK20A_FECS_TRACE_PID_MAP_SIZE		(1 << 10)
 #define GK20A_FECS_TRACE_FRAME_PERIOD_US	(1000000ULL/60ULL)
+/* bounds for the adaptive poll period */
+#define GK20A_FECS_TRACE_POLL_MIN_US		(GK20A_FECS_TRACE_FRAME_PERIOD_US / 4ULL)
+#define GK20A_FECS_TRACE_POLL_MAX_US		(GK20A_FECS_TRACE_FRAME_PERIOD_US * 4ULL)
 #define GK20A_FECS_TRACE_PTIMER_SHIFT		5
 
 struct gk20a_fecs_trace_record {
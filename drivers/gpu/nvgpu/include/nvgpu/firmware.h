@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -24,17 +24,52 @@
 #define NVGPU_FIRMWARE_H
 
 #include <nvgpu/types.h>
+#include <nvgpu/lock.h>
+#include <nvgpu/list.h>
 
 struct gk20a;
 
 #define NVGPU_REQUEST_FIRMWARE_NO_WARN		(1UL << 0)
 #define NVGPU_REQUEST_FIRMWARE_NO_SOC		(1UL << 1)
+#define NVGPU_REQUEST_FIRMWARE_CACHE		(1UL << 2)
+
+#define NVGPU_FIRMWARE_CACHE_NAME_LEN		64U
 
 struct nvgpu_firmware {
 	u8 *data;
 	size_t size;
 };
 
+/*
+ * One image kept by the firmware cache. @hash is computed when the image is
+ * inserted and checked on every hit, so a scribbled cache copy is reloaded
+ * from the filesystem rather than handed to a falcon.
+ */
+struct nvgpu_firmware_cache_entry {
+	struct nvgpu_list_node list;
+	char name[NVGPU_FIRMWARE_CACHE_NAME_LEN];
+	u32 chip;
+	u32 hash;
+	u8 *data;
+	size_t size;
+};
+
+static inline struct nvgpu_firmware_cache_entry *
+nvgpu_firmware_cache_entry_from_list(struct nvgpu_list_node *node)
+{
+	return (struct nvgpu_firmware_cache_entry *)
+		((uintptr_t)node -
+		 offsetof(struct nvgpu_firmware_cache_entry, list));
+};
+
+struct nvgpu_firmware_cache {
+	struct nvgpu_mutex lock;
+	struct nvgpu_list_node entries;
+	size_t bytes;
+	u32 hits;
+	u32 misses;
+};
+
 /**
  * nvgpu_request_firmware - load a firmware blob from filesystem.
  *
@@ -48,6 +83,11 @@ struct nvgpu_firmware {
  * 		NVGPU_REQUEST_FIRMWARE_NO_SOC: Do not attempt loading from
  * 		path <SOC_NAME>.
  *
+ * 		NVGPU_REQUEST_FIRMWARE_CACHE: Serve the image from the
+ * 		firmware cache when possible and add it to the cache after
+ * 		a filesystem load. Meant for images that are loaded on every
+ * 		poweron.
+ *
  * nvgpu_request_firmware() will load firmware from:
  *
  * <system firmware load path>/<GPU name>/<fw_name>
@@ -71,4 +111,69 @@ struct nvgpu_firmware *nvgpu_request_firmware(struct gk20a *g,
  */
 void nvgpu_release_firmware(struct gk20a *g, struct nvgpu_firmware *fw);
 
+/**
+ * nvgpu_firmware_cache_init - initialize the per-GPU firmware cache
+ *
+ * @g		The GPU driver struct
+ */
+void nvgpu_firmware_cache_init(struct gk20a *g);
+
+/**
+ * nvgpu_firmware_cache_get - look up a cached firmware image
+ *
+ * @g		The GPU driver struct
+ * @fw_name	The base name of the firmware file
+ *
+ * Returns a private copy of the cached image that the caller may modify and
+ * must free with nvgpu_release_firmware(), or NULL on a miss. An entry whose
+ * hash no longer matches its contents is dropped and reported as a miss.
+ */
+struct nvgpu_firmware *nvgpu_firmware_cache_get(struct gk20a *g,
+						const char *fw_name);
+
+/**
+ * nvgpu_firmware_cache_put - add a firmware image to the cache
+ *
+ * @g		The GPU driver struct
+ * @fw_name	The base name of the firmware file
+ * @fw		The image, as returned from the filesystem load
+ *
+ * The cache takes its own copy of @fw, so this must be called before the
+ * caller patches the image. An existing entry for @fw_name is replaced.
+ */
+int nvgpu_firmware_cache_put(struct gk20a *g, const char *fw_name,
+			     const struct nvgpu_firmware *fw);
+
+/**
+ * nvgpu_firmware_cache_shrink - drop cached images under memory pressure
+ *
+ * @g		The GPU driver struct
+ * @nr_bytes	The number of bytes to try to free
+ * @freed	Returns the number of bytes actually freed
+ *
+ * Drops the oldest entries until at least @nr_bytes have been freed or the
+ * cache is empty. Never blocks, so it is safe to call from reclaim: returns
+ * -EBUSY without freeing anything if the cache lock is held.
+ */
+int nvgpu_firmware_cache_shrink(struct gk20a *g, size_t nr_bytes,
+				size_t *freed);
+
+/**
+ * nvgpu_firmware_cache_release - drop every cached firmware image
+ *
+ * @g		The GPU driver struct
+ *
+ * Returns the number of bytes freed.
+ */
+size_t nvgpu_firmware_cache_release(struct gk20a *g);
+
+/**
+ * nvgpu_firmware_cache_deinit - release the cache and its resources
+ *
+ * @g		The GPU driver struct
+ *
+ * Called at driver removal, once nothing can use the cache any more.
+ */
+void nvgpu_firmware_cache_deinit(struct gk20a *g);
+
 #endif /* NVGPU_FIRMWARE_H */
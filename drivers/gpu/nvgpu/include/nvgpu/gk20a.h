@@ -40,6 +40,7 @@ struct nvgpu_clk_pll_debug_data;
 struct nvgpu_nvhost_dev;
 struct nvgpu_cpu_time_correlation_sample;
 struct nvgpu_mem_sgt;
+struct nvgpu_log_ring;
 struct nvgpu_warpstate;
 struct nvgpu_clk_session;
 struct nvgpu_clk_arb;
@@ -72,6 +73,8 @@ struct nvgpu_setup_bind_args;
 #include <nvgpu/tsg.h>
 #include <nvgpu/sec2.h>
 #include <nvgpu/sched.h>
+#include <nvgpu/init_sched.h>
+#include <nvgpu/firmware.h>
 
 #include "gk20a/clk_gk20a.h"
 #include "gk20a/ce2_gk20a.h"
@@ -1451,9 +1454,18 @@ struct gk20a {
 
 	u64 log_mask;
 	u32 log_trace;
+	/* categories recorded by nvgpu_log_bin() */
+	u64 log_ring_mask;
+	struct nvgpu_log_ring *log_ring;
 
 	struct nvgpu_mutex tpc_pg_lock;
 
+	/* stage timings of the last poweron */
+	struct nvgpu_init_sched poweron_sched;
+
+	/* firmware images kept across railgate cycles */
+	struct nvgpu_firmware_cache fw_cache;
+
 	struct nvgpu_gpu_params params;
 
 	/*
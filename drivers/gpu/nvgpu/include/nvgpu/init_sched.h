@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NVGPU_INIT_SCHED_H
+#define NVGPU_INIT_SCHED_H
+
+#include <nvgpu/types.h>
+#include <nvgpu/bitops.h>
+#include <nvgpu/thread.h>
+#include <nvgpu/cond.h>
+
+struct gk20a;
+
+/*
+ * Small dependency driven scheduler for the poweron sequence. Stages are
+ * added in order with a mask of the stages they depend on; stages flagged
+ * NVGPU_INIT_STAGE_PARALLEL are run on their own thread as soon as their
+ * dependencies are done, everything else runs on the calling thread.
+ */
+#define NVGPU_INIT_SCHED_MAX_STAGES	32U
+
+#define NVGPU_INIT_STAGE_PARALLEL	BIT32(0)
+
+#define NVGPU_INIT_STAGE_DEP(idx)	BIT32(idx)
+
+struct nvgpu_init_sched;
+
+struct nvgpu_init_stage {
+	const char *name;
+	int (*fn)(struct gk20a *g);
+	u32 deps;
+	u32 flags;
+
+	struct nvgpu_init_sched *sched;
+	struct nvgpu_thread worker;
+	bool on_worker;
+	bool finished;
+	int err;
+	s64 start_ns;
+	s64 end_ns;
+};
+
+struct nvgpu_init_sched {
+	struct gk20a *g;
+	struct nvgpu_init_stage stages[NVGPU_INIT_SCHED_MAX_STAGES];
+	u32 nr_stages;
+	/* stages of the batch being run by nvgpu_init_sched_run() */
+	u32 first_pending;
+	u32 done;
+	/* broadcast by workers when their stage finishes */
+	struct nvgpu_cond wq;
+	s64 start_ns;
+};
+
+void nvgpu_init_sched_init(struct nvgpu_init_sched *sched, struct gk20a *g);
+
+/*
+ * Returns the index of the new stage, to be used with NVGPU_INIT_STAGE_DEP()
+ * by later stages, -ENOSPC if the table is full or -EINVAL for a dependency
+ * on a stage not added yet. A NULL @fn marks a stage that does not apply
+ * to this chip; it completes immediately and is left out of the report.
+ */
+int nvgpu_init_sched_add(struct nvgpu_init_sched *sched, const char *name,
+		int (*fn)(struct gk20a *g), u32 deps, u32 flags);
+
+/*
+ * Run all stages added since the previous call. On error no new stages are
+ * started, stages already running are waited for and the first error is
+ * returned.
+ */
+int nvgpu_init_sched_run(struct nvgpu_init_sched *sched);
+
+void nvgpu_init_sched_report(struct nvgpu_init_sched *sched);
+
+#endif /* NVGPU_INIT_SCHED_H */
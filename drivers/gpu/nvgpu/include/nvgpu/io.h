@@ -41,6 +41,8 @@ u32 nvgpu_readl(struct gk20a *g, u32 r);
 u32 __nvgpu_readl(struct gk20a *g, u32 r);
 void nvgpu_writel_check(struct gk20a *g, u32 r, u32 v);
 void nvgpu_writel_loop(struct gk20a *g, u32 r, u32 v);
+void nvgpu_writel_stream(struct gk20a *g, const u32 *stream, u32 count,
+		u32 stride, u32 value_idx);
 void nvgpu_bar1_writel(struct gk20a *g, u32 b, u32 v);
 u32 nvgpu_bar1_readl(struct gk20a *g, u32 b);
 bool nvgpu_io_exists(struct gk20a *g);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2017-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -27,6 +27,7 @@
 #include <nvgpu/bitops.h>
 
 struct gk20a;
+struct gk20a_debug_output;
 
 enum nvgpu_log_type {
 	NVGPU_ERROR,
@@ -82,6 +83,19 @@ void __nvgpu_log_dbg(struct gk20a *g, u64 log_mask,
 #define	gpu_dbg_clk_arb		BIT(26) /* Clk arbiter debugging. */
 #define	gpu_dbg_mem		BIT(31) /* memory accesses; very verbose. */
 
+/*
+ * Debug categories that are compiled in. Calls to nvgpu_log() and
+ * nvgpu_log_bin() whose mask falls outside of this are removed by the
+ * compiler, arguments included. Builds may override it, e.g. to drop
+ * gpu_dbg_reg and gpu_dbg_mem from production kernels.
+ */
+#ifndef NVGPU_LOG_COMPILED_MASK
+#define NVGPU_LOG_COMPILED_MASK		(~0ULL)
+#endif
+
+#define nvgpu_log_compiled(log_mask)					\
+	((((u64)(log_mask)) & (u64)(NVGPU_LOG_COMPILED_MASK)) != 0ULL)
+
 /**
  * nvgpu_log_mask_enabled - Check if logging is enabled
  *
@@ -107,7 +121,51 @@ int nvgpu_log_mask_enabled(struct gk20a *g, u64 log_mask);
  * Print a message if the log_mask matches the enabled debugging.
  */
 #define nvgpu_log(g, log_mask, fmt, arg...)				\
-	__nvgpu_log_dbg(g, (u32)log_mask, __func__, __LINE__, fmt, ##arg)
+	do {								\
+		if (nvgpu_log_compiled(log_mask) &&			\
+		    unlikely(nvgpu_log_mask_enabled(g, log_mask) != 0))	\
+			__nvgpu_log_dbg(g, (u32)log_mask, __func__,	\
+					__LINE__, fmt, ##arg);		\
+	} while (0)
+
+/*
+ * Binary log ring. Records are stored unformatted (format pointer plus up to
+ * four 64-bit arguments) and only formatted when the ring is dumped, so
+ * verbose categories can be left on without the cost of printing. @fmt must
+ * be a string literal and must only use 64-bit conversions (%llx, %llu,
+ * %lld). Recording is ratelimited; records over the limit are counted as
+ * dropped. A category that is also enabled in the regular log mask is
+ * printed as with nvgpu_log().
+ */
+#define NVGPU_LOG_RING_ENTRIES		1024U
+#define NVGPU_LOG_RING_WINDOW_MS	10
+#define NVGPU_LOG_RING_WINDOW_LIMIT	256U
+
+int nvgpu_log_ring_init(struct gk20a *g);
+void nvgpu_log_ring_deinit(struct gk20a *g);
+void nvgpu_log_ring_stats(struct gk20a *g, u32 *records, u32 *dropped);
+int nvgpu_log_ring_decode(struct gk20a *g, u32 seq, char *buf, size_t size);
+void nvgpu_log_ring_dump(struct gk20a *g, struct gk20a_debug_output *o);
+void __nvgpu_log_ring(struct gk20a *g, u64 log_mask,
+		      const char *func_name, int line, const char *fmt,
+		      u64 a0, u64 a1, u64 a2, u64 a3);
+
+void __nvgpu_log_ring_dbg(struct gk20a *g, u64 log_mask,
+			  const char *func_name, int line, const char *fmt,
+			  u64 a0, u64 a1, u64 a2, u64 a3);
+
+#define nvgpu_log_bin(g, log_mask, fmt, a0, a1, a2, a3)		\
+	do {								\
+		if (!nvgpu_log_compiled(log_mask))			\
+			break;						\
+		__nvgpu_log_ring(g, (u64)(log_mask), __func__,		\
+			__LINE__, fmt, (u64)(a0), (u64)(a1),		\
+			(u64)(a2), (u64)(a3));				\
+		if (unlikely(nvgpu_log_mask_enabled(g, log_mask) != 0))	\
+			__nvgpu_log_ring_dbg(g, (u64)(log_mask),	\
+				__func__, __LINE__, fmt, (u64)(a0),	\
+				(u64)(a1), (u64)(a2), (u64)(a3));	\
+	} while (0)
 
 /**
  * nvgpu_err - Print an error
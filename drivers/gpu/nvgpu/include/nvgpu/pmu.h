@@ -98,9 +98,6 @@
 #define GK20A_PMU_UCODE_NB_MAX_DATE_LENGTH  64U
 
 #define PMU_MAX_NUM_SEQUENCES		(256U)
-#define PMU_SEQ_BIT_SHIFT		(5U)
-#define PMU_SEQ_TBL_SIZE	\
-		(PMU_MAX_NUM_SEQUENCES >> PMU_SEQ_BIT_SHIFT)
 
 #define PMU_INVALID_SEQ_DESC		(~0)
 
@@ -147,6 +144,9 @@ enum {
 /* pmu load const defines */
 #define PMU_BUSY_CYCLES_NORM_MAX		(1000U)
 
+/* perfmon load samples kept for windowed utilization */
+#define PMU_LOAD_SAMPLES_NUM			256U
+
 /* RPC */
 #define PMU_RPC_EXECUTE(_stat, _pmu, _unit, _func, _prpc, _size)\
 	do {                                                 \
@@ -192,10 +192,23 @@ enum {
 typedef void (*pmu_callback)(struct gk20a *, struct pmu_msg *, void *, u32,
 	u32);
 
+/*
+ * RPC payloads up to this size come from a preallocated pool instead of
+ * being allocated per call.
+ */
+#define PMU_RPC_POOL_SLOTS		16U
+#define PMU_RPC_POOL_BUF_SIZE		256U
+
 struct rpc_handler_payload {
 	void *rpc_buff;
 	bool is_mem_free_set;
 	bool complete;
+	bool from_pool;
+};
+
+struct pmu_rpc_pool_slot {
+	struct rpc_handler_payload payload;
+	u8 buf[PMU_RPC_POOL_BUF_SIZE];
 };
 
 struct pmu_rpc_desc {
@@ -297,6 +310,15 @@ struct pmu_sequence {
 	u8 *out_payload;
 	pmu_callback callback;
 	void *cb_params;
+	u8 unit_id;
+	s64 post_time_ns;
+};
+
+/* Per PMU unit command round trip stats */
+struct pmu_ipc_unit_stats {
+	u64 completed;
+	u64 total_ns;
+	u64 max_ns;
 };
 
 struct nvgpu_pg_init {
@@ -306,6 +328,19 @@ struct nvgpu_pg_init {
 	struct nvgpu_thread state_task;
 };
 
+struct nvgpu_pmu_load_sample {
+	s64 timestamp_ns;
+	/* 0..PMU_BUSY_CYCLES_NORM_MAX, busy since the previous sample */
+	u32 load;
+};
+
+struct nvgpu_pmu_load_ring {
+	struct nvgpu_spinlock lock;
+	/* number of samples ever added, the next slot is head % NUM */
+	u32 head;
+	struct nvgpu_pmu_load_sample samples[PMU_LOAD_SAMPLES_NUM];
+};
+
 struct nvgpu_pmu {
 	struct gk20a *g;
 	struct nvgpu_falcon *flcn;
@@ -330,7 +365,11 @@ struct nvgpu_pmu {
 	struct nvgpu_falcon_queue queue[PMU_QUEUE_COUNT];
 
 	struct pmu_sequence *seq;
-	unsigned long pmu_seq_tbl[PMU_SEQ_TBL_SIZE];
+	/* Stack of free sequence ids, protected by pmu_seq_lock */
+	u8 seq_free_stack[PMU_MAX_NUM_SEQUENCES];
+	u32 seq_free_cnt;
+	u32 seq_inflight_peak;
+	struct pmu_ipc_unit_stats ipc_stats[PMU_UNIT_END];
 	u32 next_seq_desc;
 
 	struct pmu_mutex *mutex;
@@ -339,6 +378,12 @@ struct nvgpu_pmu {
 	struct nvgpu_mutex pmu_copy_lock;
 	struct nvgpu_mutex pmu_seq_lock;
 
+	/* RPC payload pool, and waitqueue signalled on each RPC completion */
+	struct pmu_rpc_pool_slot *rpc_pool;
+	u32 rpc_pool_used;
+	struct nvgpu_spinlock rpc_pool_lock;
+	struct nvgpu_cond rpc_cond;
+
 	struct nvgpu_allocator dmem;
 
 	u32 *ucode_image;
@@ -379,6 +424,7 @@ struct nvgpu_pmu {
 	u32 load_shadow;
 	u32 load_avg;
 	u32 load;
+	struct nvgpu_pmu_load_ring load_ring;
 
 	struct nvgpu_mutex isr_mutex;
 	bool isr_enabled;
@@ -426,6 +472,7 @@ struct pg_init_sequence_list {
 
 /* PMU IPC Methods */
 void nvgpu_pmu_seq_init(struct nvgpu_pmu *pmu);
+u32 nvgpu_pmu_seq_inflight(struct nvgpu_pmu *pmu);
 
 int nvgpu_pmu_mutex_acquire(struct nvgpu_pmu *pmu, u32 id, u32 *token);
 int nvgpu_pmu_mutex_release(struct nvgpu_pmu *pmu, u32 id, u32 *token);
@@ -457,6 +504,15 @@ int nvgpu_pmu_busy_cycles_norm(struct gk20a *g, u32 *norm);
 void nvgpu_pmu_reset_load_counters(struct gk20a *g);
 void nvgpu_pmu_get_load_counters(struct gk20a *g, u32 *busy_cycles,
 		u32 *total_cycles);
+void nvgpu_pmu_load_ring_init(struct nvgpu_pmu_load_ring *ring);
+void nvgpu_pmu_load_ring_reset(struct nvgpu_pmu_load_ring *ring);
+void nvgpu_pmu_load_ring_add(struct nvgpu_pmu_load_ring *ring,
+		s64 timestamp_ns, u32 load);
+u32 nvgpu_pmu_load_ring_read(struct nvgpu_pmu_load_ring *ring,
+		struct nvgpu_pmu_load_sample *samples, u32 max_samples);
+int nvgpu_pmu_load_ring_window(struct nvgpu_pmu_load_ring *ring,
+		s64 window_ns, u32 *load);
+int nvgpu_pmu_load_window(struct gk20a *g, s64 window_ns, u32 *load);
 
 int nvgpu_pmu_handle_therm_event(struct nvgpu_pmu *pmu,
 			struct nv_pmu_therm_msg *msg);
@@ -518,6 +574,14 @@ bool nvgpu_find_hex_in_string(char *strings, struct gk20a *g, u32 *hex_pos);
 int nvgpu_pmu_rpc_execute(struct nvgpu_pmu *pmu, struct nv_pmu_rpc_header *rpc,
 	u16 size_rpc, u16 size_scratch, pmu_callback callback, void *cb_param,
 	bool is_copy_back);
+int nvgpu_pmu_rpc_execute_async(struct nvgpu_pmu *pmu,
+	struct nv_pmu_rpc_header *rpc, u16 size_rpc, u16 size_scratch,
+	struct rpc_handler_payload **handle);
+int nvgpu_pmu_rpc_wait(struct nvgpu_pmu *pmu,
+	struct rpc_handler_payload *handle, struct nv_pmu_rpc_header *rpc,
+	u16 size_rpc);
+int nvgpu_pmu_rpc_pool_init(struct nvgpu_pmu *pmu);
+void nvgpu_pmu_rpc_pool_deinit(struct nvgpu_pmu *pmu);
 
 /* PMU wait*/
 int pmu_wait_message_cond(struct nvgpu_pmu *pmu, u32 timeout_ms,
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2017-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -84,12 +84,10 @@ static inline int __nvgpu_atomic_dec_return(nvgpu_atomic_t *v)
 	return v->v;
 }
 
+/* Like the kernel's: returns the value found, which is @old on success. */
 static inline int __nvgpu_atomic_cmpxchg(nvgpu_atomic_t *v, int old, int new)
 {
-	if (v->v == old)
-		v->v = new;
-
-	return v->v;
+	return __atomic_cmpxchg(&v->v, old, new);
 }
 
 static inline int __nvgpu_atomic_xchg(nvgpu_atomic_t *v, int new)
@@ -170,11 +168,7 @@ static inline long __nvgpu_atomic64_dec_return(nvgpu_atomic64_t *v)
 static inline long __nvgpu_atomic64_cmpxchg(nvgpu_atomic64_t *v,
 					long old, long new)
 {
-
-	if (v->v == old)
-		v->v = new;
-
-	return v->v;
+	return __atomic_cmpxchg(&v->v, old, new);
 }
 
 static inline void __nvgpu_atomic64_sub(long x, nvgpu_atomic64_t *v)
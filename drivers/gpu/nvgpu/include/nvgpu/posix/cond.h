@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -23,12 +23,24 @@
 #ifndef __NVGPU_POSIX_COND_H__
 #define __NVGPU_POSIX_COND_H__
 
-#include <nvgpu/bug.h>
+#include <pthread.h>
+#include <time.h>
 
+#include <nvgpu/types.h>
+
+/*
+ * Condition variables map onto a pthread condvar and the mutex protecting
+ * it. The waker only needs to update the condition before signalling: the
+ * waiter re-checks it with the mutex held, so a wakeup can not be lost.
+ */
 struct nvgpu_cond {
-	/* Place holder until this can be properly implemented. */
+	bool initialized;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
 };
 
+void __nvgpu_cond_timeout(struct timespec *ts, long timeout_ms);
+
 /**
  * NVGPU_COND_WAIT - Wait for a condition to be true
  *
@@ -39,8 +51,27 @@ struct nvgpu_cond {
  * Wait for a condition to become true. Returns -ETIMEOUT if
  * the wait timed out with condition false.
  */
-#define NVGPU_COND_WAIT(c, condition, timeout_ms)	\
-	({BUG(); 1; })
+#define NVGPU_COND_WAIT(c, condition, timeout_ms)			\
+({									\
+	int ret = 0;							\
+	long _timeout_ms = (timeout_ms);				\
+	struct timespec _ts;						\
+	if (_timeout_ms > 0) {						\
+		__nvgpu_cond_timeout(&_ts, _timeout_ms);		\
+	}								\
+	pthread_mutex_lock(&(c)->mutex);				\
+	while (!(condition)) {						\
+		if (_timeout_ms <= 0) {					\
+			pthread_cond_wait(&(c)->cond, &(c)->mutex);	\
+		} else if (pthread_cond_timedwait(&(c)->cond,		\
+				&(c)->mutex, &_ts) == ETIMEDOUT) {	\
+			ret = (condition) ? 0 : -ETIMEDOUT;		\
+			break;						\
+		}							\
+	}								\
+	pthread_mutex_unlock(&(c)->mutex);				\
+	ret;								\
+})
 
 /**
  * NVGPU_COND_WAIT_INTERRUPTIBLE - Wait for a condition to be true
@@ -51,9 +82,10 @@ struct nvgpu_cond {
  *
  * Wait for a condition to become true. Returns -ETIMEOUT if
  * the wait timed out with condition false or -ERESTARTSYS on
- * signal.
+ * signal. There are no signals to deliver here, so this is the same as
+ * NVGPU_COND_WAIT().
  */
 #define NVGPU_COND_WAIT_INTERRUPTIBLE(c, condition, timeout_ms) \
-	({BUG(); 1; })
+	NVGPU_COND_WAIT(c, condition, timeout_ms)
 
 #endif
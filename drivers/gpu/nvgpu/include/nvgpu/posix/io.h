@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -72,14 +72,6 @@ struct nvgpu_posix_io_reg_space {
 	u32 base;
 	u32 size;
 	u32 *data;
-	struct nvgpu_list_node link;
-};
-
-static inline struct nvgpu_posix_io_reg_space *
-nvgpu_posix_io_reg_space_from_link(struct nvgpu_list_node *node)
-{
-	return (struct nvgpu_posix_io_reg_space *)
-	   ((uintptr_t)node - offsetof(struct nvgpu_posix_io_reg_space, link));
 };
 
 void nvgpu_posix_io_init_reg_space(struct gk20a *g);
@@ -92,23 +84,25 @@ void nvgpu_posix_io_delete_reg_space(struct gk20a *g, u32 base);
 void nvgpu_posix_io_writel_reg_space(struct gk20a *g, u32 addr, u32 data);
 u32 nvgpu_posix_io_readl_reg_space(struct gk20a *g, u32 addr);
 
-struct nvgpu_posix_io_reg_access {
-	struct nvgpu_reg_access access;
-	struct nvgpu_list_node link;
-};
-
-static inline struct nvgpu_posix_io_reg_access *
-nvgpu_posix_io_reg_access_from_link(struct nvgpu_list_node *node)
-{
-	return (struct nvgpu_posix_io_reg_access *)
-	   ((uintptr_t)node - offsetof(struct nvgpu_posix_io_reg_access, link));
-};
-
 void nvgpu_posix_io_start_recorder(struct gk20a *g);
 void nvgpu_posix_io_reset_recorder(struct gk20a *g);
+void nvgpu_posix_io_set_recorder_filter(struct gk20a *g, u32 base, u32 size);
+u32 nvgpu_posix_io_get_recorded_count(struct gk20a *g);
 void nvgpu_posix_io_record_access(struct gk20a *g,
 	struct nvgpu_reg_access *access);
 bool nvgpu_posix_io_check_sequence(struct gk20a *g,
 	struct nvgpu_reg_access *sequence, u32 size, bool strict);
 
+/*
+ * Recordings can be saved to and compared against text files with one
+ * "<addr> <value>" pair (both hex) per line. Blank lines and lines starting
+ * with '#' are ignored, so register traces from different driver versions
+ * can be kept around and diffed.
+ */
+int nvgpu_posix_io_export_recording(struct gk20a *g, const char *path);
+int nvgpu_posix_io_import_sequence(struct gk20a *g, const char *path,
+	struct nvgpu_reg_access **sequence, u32 *size);
+bool nvgpu_posix_io_check_sequence_file(struct gk20a *g, const char *path,
+	bool strict);
+
 #endif
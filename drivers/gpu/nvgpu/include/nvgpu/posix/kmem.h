@@ -33,4 +33,24 @@ void *__nvgpu_vzalloc(struct gk20a *g, unsigned long size, void *ip);
 void __nvgpu_kfree(struct gk20a *g, void *addr);
 void __nvgpu_vfree(struct gk20a *g, void *addr);
 
+struct nvgpu_kmem_cache;
+
+/*
+ * Usage stats for the POSIX kmem_cache implementation. Handy for unit tests and
+ * benchmarks that want to see how an allocation heavy path uses a cache.
+ */
+struct nvgpu_posix_kmem_cache_stats {
+	size_t obj_size;
+	u32 objs_per_chunk;
+
+	u64 nr_chunks;
+	u64 nr_allocs;
+	u64 nr_frees;
+	u64 objs_active;
+	u64 objs_peak;
+};
+
+void nvgpu_posix_kmem_cache_get_stats(struct nvgpu_kmem_cache *cache,
+				struct nvgpu_posix_kmem_cache_stats *stats);
+
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2017-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -46,7 +46,8 @@ static inline void __nvgpu_posix_lock_acquire(struct __nvgpu_posix_lock *lock)
 static inline int __nvgpu_posix_lock_try_acquire(
 	struct __nvgpu_posix_lock *lock)
 {
-	return pthread_mutex_trylock(&lock->mutex);
+	/* match mutex_trylock(): non-zero when the lock was taken */
+	return pthread_mutex_trylock(&lock->mutex) == 0;
 }
 
 static inline void __nvgpu_posix_lock_release(struct __nvgpu_posix_lock *lock)
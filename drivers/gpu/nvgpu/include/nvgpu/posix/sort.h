@@ -23,13 +23,14 @@
 #ifndef __NVGPU_POSIX_SORT_H__
 #define __NVGPU_POSIX_SORT_H__
 
-#include <nvgpu/bug.h>
+#include <nvgpu/types.h>
 
-static void sort(void *base, size_t num, size_t size,
-		 int (*cmp)(const void *, const void *),
-		 void (*swap)(void *, void *, int))
-{
-	__bug("sort() not implemented yet!");
-}
+/*
+ * Same contract as the kernel's sort(): an unstable, in-place sort of @num
+ * elements of @size bytes. If @swap is NULL a built in swap is used.
+ */
+void sort(void *base, size_t num, size_t size,
+	  int (*cmp)(const void *, const void *),
+	  void (*swap)(void *, void *, int));
 
 #endif
@@ -62,6 +62,19 @@ struct gk20a_ctxsw_trace {
 	struct gk20a_ctxsw_dev devs[GK20A_CTXSW_TRACE_NUM_DEVS];
 };
 
+/*
+ * The ring header and entries can be mmap'ed by the consumer. Ordering:
+ *
+ * - The producer (gk20a_ctxsw_trace_write) stores the entry, issues a write
+ *   barrier, then publishes write_idx.
+ * - A consumer loads write_idx, issues a read barrier, then reads entries
+ *   up to (but excluding) write_idx.
+ * - A consumer finishes reading entries and issues a full barrier before
+ *   storing read_idx; the producer never writes to [read_idx, write_idx).
+ *
+ * read() follows the same protocol, so both consumer modes can be mixed as
+ * long as only one of them advances read_idx at a time.
+ */
 static inline int ring_is_empty(struct nvgpu_ctxsw_ring_header *hdr)
 {
 	return (hdr->write_idx == hdr->read_idx);
@@ -77,17 +90,6 @@ static inline int ring_len(struct nvgpu_ctxsw_ring_header *hdr)
 	return (hdr->write_idx - hdr->read_idx) % hdr->num_ents;
 }
 
-static void nvgpu_set_ctxsw_trace_entry(struct nvgpu_ctxsw_trace_entry *entry_dst,
-        struct nvgpu_gpu_ctxsw_trace_entry *entry_src)
-{
-	entry_dst->tag = entry_src->tag;
-	entry_dst->vmid = entry_src->vmid;
-	entry_dst->seqno = entry_src->seqno;
-	entry_dst->context_id = entry_src->context_id;
-	entry_dst->pid = entry_src->pid;
-	entry_dst->timestamp = entry_src->timestamp;
-}
-
 ssize_t gk20a_ctxsw_dev_read(struct file *filp, char __user *buf, size_t size,
 	loff_t *off)
 {
@@ -96,10 +98,17 @@ ssize_t gk20a_ctxsw_dev_read(struct file *filp, char __user *buf, size_t size,
 	struct nvgpu_ctxsw_ring_header *hdr = dev->hdr;
 	struct nvgpu_ctxsw_trace_entry __user *entry =
 		(struct nvgpu_ctxsw_trace_entry *) buf;
-	struct nvgpu_ctxsw_trace_entry user_entry;
 	size_t copied = 0;
+	u32 want = size / sizeof(*entry);
+	u32 read_idx;
+	u32 write_idx;
+	u32 n;
 	int err;
 
+	/* entries are copied to userspace as-is */
+	BUILD_BUG_ON(sizeof(struct nvgpu_ctxsw_trace_entry) !=
+		sizeof(struct nvgpu_gpu_ctxsw_trace_entry));
+
 	nvgpu_log(g, gpu_dbg_fn|gpu_dbg_ctxsw,
 		"filp=%p buf=%p size=%zu", filp, buf, size);
 
@@ -115,30 +124,48 @@ ssize_t gk20a_ctxsw_dev_read(struct file *filp, char __user *buf, size_t size,
 		nvgpu_mutex_acquire(&dev->write_lock);
 	}
 
-	while (size >= sizeof(struct nvgpu_gpu_ctxsw_trace_entry)) {
-		if (ring_is_empty(hdr))
-			break;
+	write_idx = hdr->write_idx;
+	read_idx = hdr->read_idx;
+	nvgpu_smp_rmb();
+
+	/* the header is mapped by userspace; don't trust it for sizing */
+	if (write_idx >= dev->num_ents || read_idx >= dev->num_ents) {
+		nvgpu_err(g, "read_idx=%u write_idx=%u out of range [0..%u]",
+			read_idx, write_idx, dev->num_ents);
+		nvgpu_mutex_release(&dev->write_lock);
+		return -EINVAL;
+	}
+
+	/* at most two copies: up to the end of the ring, then from 0 */
+	while (want > 0 && read_idx != write_idx) {
+		if (read_idx < write_idx)
+			n = write_idx - read_idx;
+		else
+			n = dev->num_ents - read_idx;
+		n = min(n, want);
 
-		nvgpu_set_ctxsw_trace_entry(&user_entry, &dev->ents[hdr->read_idx]);
-		if (copy_to_user(entry, &user_entry,
-			sizeof(*entry))) {
+		if (copy_to_user(entry, &dev->ents[read_idx],
+				n * sizeof(*entry))) {
 			nvgpu_mutex_release(&dev->write_lock);
 			return -EFAULT;
 		}
 
-		hdr->read_idx++;
-		if (hdr->read_idx >= hdr->num_ents)
-			hdr->read_idx = 0;
+		read_idx += n;
+		if (read_idx >= dev->num_ents)
+			read_idx = 0;
 
-		entry++;
-		copied += sizeof(*entry);
-		size -= sizeof(*entry);
+		entry += n;
+		copied += n * sizeof(*entry);
+		want -= n;
 	}
 
-	nvgpu_log(g, gpu_dbg_ctxsw, "copied=%zu read_idx=%d", copied,
-		hdr->read_idx);
+	nvgpu_smp_mb();
+	hdr->read_idx = read_idx;
+
+	nvgpu_log(g, gpu_dbg_ctxsw, "copied=%zu read_idx=%u", copied,
+		read_idx);
 
-	*off = hdr->read_idx;
+	*off = read_idx;
 	nvgpu_mutex_release(&dev->write_lock);
 
 	return copied;
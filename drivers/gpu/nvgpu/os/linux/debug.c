@@ -145,6 +145,66 @@ static int gk20a_debug_show(struct seq_file *s, void *unused)
 	return 0;
 }
 
+static int gk20a_log_ring_show(struct seq_file *s, void *unused)
+{
+	struct device *dev = s->private;
+	struct gk20a_debug_output o = {
+		.fn = gk20a_debug_write_to_seqfile,
+		.ctx = s,
+	};
+
+	nvgpu_log_ring_dump(gk20a_get_platform(dev)->g, &o);
+	return 0;
+}
+
+static int gk20a_poweron_timing_show(struct seq_file *s, void *unused)
+{
+	struct device *dev = s->private;
+	struct gk20a *g = gk20a_get_platform(dev)->g;
+	struct nvgpu_init_sched *sched = &g->poweron_sched;
+	struct nvgpu_init_stage *stage;
+	u32 i;
+
+	seq_puts(s, "stage        where    start(us)  took(us)\n");
+	for (i = 0; i < sched->nr_stages; i++) {
+		stage = &sched->stages[i];
+		if (!stage->fn || !stage->finished)
+			continue;
+
+		seq_printf(s, "%-12s %-6s %11lld %9lld%s\n", stage->name,
+			stage->on_worker ? "worker" : "inline",
+			div_s64(stage->start_ns - sched->start_ns, 1000),
+			div_s64(stage->end_ns - stage->start_ns, 1000),
+			stage->err ? " failed" : "");
+	}
+
+	return 0;
+}
+
+static int gk20a_poweron_timing_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, gk20a_poweron_timing_show, inode->i_private);
+}
+
+static const struct file_operations gk20a_poweron_timing_fops = {
+	.open		= gk20a_poweron_timing_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int gk20a_log_ring_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, gk20a_log_ring_show, inode->i_private);
+}
+
+static const struct file_operations gk20a_log_ring_fops = {
+	.open		= gk20a_log_ring_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int gk20a_gr_debug_open(struct inode *inode, struct file *file)
 {
 	return single_open(file, gk20a_gr_debug_show, inode->i_private);
@@ -349,6 +409,8 @@ void gk20a_debug_init(struct gk20a *g, const char *debugfs_symlink)
 		dev, &gk20a_debug_fops);
 	debugfs_create_file("gr_status", S_IRUGO, l->debugfs,
 		dev, &gk20a_gr_debug_fops);
+	debugfs_create_file("poweron_timing", S_IRUGO, l->debugfs,
+		dev, &gk20a_poweron_timing_fops);
 	debugfs_create_u32("trace_cmdbuf", S_IRUGO|S_IWUSR,
 		l->debugfs, &gk20a_debug_trace_cmdbuf);
 
@@ -364,6 +426,13 @@ void gk20a_debug_init(struct gk20a *g, const char *debugfs_symlink)
 	debugfs_create_u32("log_trace", S_IRUGO|S_IWUSR,
 		l->debugfs, &g->log_trace);
 
+	if (nvgpu_log_ring_init(g) == 0) {
+		debugfs_create_u64("log_ring_mask", S_IRUGO|S_IWUSR,
+			l->debugfs, &g->log_ring_mask);
+		debugfs_create_file("log_ring", S_IRUGO, l->debugfs,
+			dev, &gk20a_log_ring_fops);
+	}
+
 	l->debugfs_ltc_enabled =
 			debugfs_create_bool("ltc_enabled", S_IRUGO|S_IWUSR,
 				 l->debugfs,
@@ -454,4 +523,6 @@ void gk20a_debug_deinit(struct gk20a *g)
 
 	debugfs_remove_recursive(l->debugfs);
 	debugfs_remove(l->debugfs_alias);
+
+	nvgpu_log_ring_deinit(g);
 }
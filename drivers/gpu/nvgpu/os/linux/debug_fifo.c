@@ -21,6 +21,7 @@
 #include <nvgpu/sort.h>
 #include <nvgpu/timers.h>
 #include <nvgpu/channel.h>
+#include <nvgpu/debug.h>
 
 void __gk20a_fifo_profile_free(struct nvgpu_ref *ref);
 
@@ -135,6 +136,49 @@ static const struct file_operations gk20a_fifo_sched_debugfs_fops = {
 	.release = seq_release
 };
 
+static void gk20a_fifo_channel_trace_write(void *ctx, const char *str,
+					   size_t len)
+{
+	seq_write((struct seq_file *)ctx, str, len);
+}
+
+static int gk20a_fifo_channel_trace_show(struct seq_file *s, void *unused)
+{
+	struct gk20a *g = s->private;
+	struct fifo_gk20a *f = &g->fifo;
+	struct gk20a_debug_output o = {
+		.fn = gk20a_fifo_channel_trace_write,
+		.ctx = s,
+	};
+	struct channel_gk20a *ch;
+	u32 chid;
+
+	for (chid = 0; chid < f->num_channels; chid++) {
+		ch = gk20a_channel_from_id(g, chid);
+		if (ch == NULL)
+			continue;
+
+		nvgpu_channel_trace_dump(ch, &o);
+		gk20a_channel_put(ch);
+	}
+
+	return 0;
+}
+
+static int gk20a_fifo_channel_trace_open(struct inode *inode,
+	struct file *file)
+{
+	return single_open(file, gk20a_fifo_channel_trace_show,
+			inode->i_private);
+}
+
+static const struct file_operations gk20a_fifo_channel_trace_debugfs_fops = {
+	.open = gk20a_fifo_channel_trace_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int gk20a_fifo_profile_enable(void *data, u64 val)
 {
 	struct gk20a *g = (struct gk20a *) data;
@@ -307,6 +351,9 @@ void gk20a_fifo_debugfs_init(struct gk20a *g)
 	debugfs_create_file("sched", 0600, fifo_root, g,
 		&gk20a_fifo_sched_debugfs_fops);
 
+	debugfs_create_file("channel_trace", 0400, fifo_root, g,
+		&gk20a_fifo_channel_trace_debugfs_fops);
+
 	profile_root = debugfs_create_dir("profile", fifo_root);
 	if (IS_ERR_OR_NULL(profile_root))
 		return;
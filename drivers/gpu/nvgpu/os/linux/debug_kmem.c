@@ -85,12 +85,15 @@ static void print_hr_bytes(struct seq_file *s, const char *msg, u64 bytes)
  * print_histogram - Build a histogram of the memory usage.
  *
  * @tracker The tracking to pull data from.
+ * @stats   Aggregated stats for @tracker.
  * @s       A seq_file to dump info into.
  */
 static void print_histogram(struct nvgpu_mem_alloc_tracker *tracker,
+			    struct nvgpu_mem_alloc_stats *stats,
 			    struct seq_file *s)
 {
 	int i;
+	u32 shard_idx;
 	u64 pot_min, pot_max;
 	u64 nr_buckets;
 	unsigned int *buckets;
@@ -105,8 +108,8 @@ static void print_histogram(struct nvgpu_mem_alloc_tracker *tracker,
 	 * nearest power of two. Each histogram bucket is one power of two so
 	 * the histogram buckets are exponential.
 	 */
-	pot_min = (u64)rounddown_pow_of_two(tracker->min_alloc);
-	pot_max = (u64)roundup_pow_of_two(tracker->max_alloc);
+	pot_min = (u64)rounddown_pow_of_two(stats->min_alloc);
+	pot_max = (u64)roundup_pow_of_two(stats->max_alloc);
 
 	nr_buckets = __ffs(pot_max) - __ffs(pot_min);
 
@@ -121,32 +124,41 @@ static void print_histogram(struct nvgpu_mem_alloc_tracker *tracker,
 	 * should go in. Round the size down to the nearest power of two to
 	 * find the right bucket.
 	 */
-	nvgpu_rbtree_enum_start(0, &node, tracker->allocs);
-	while (node) {
-		int b;
-		u64 bucket_min;
-		struct nvgpu_mem_alloc *alloc =
-			nvgpu_mem_alloc_from_rbtree_node(node);
-
-		bucket_min = (u64)rounddown_pow_of_two(alloc->size);
-		if (bucket_min < tracker->min_alloc)
-			bucket_min = tracker->min_alloc;
-
-		b = __ffs(bucket_min) - __ffs(pot_min);
-
-		/*
-		 * Handle the one case were there's an alloc exactly as big as
-		 * the maximum bucket size of the largest bucket. Most of the
-		 * buckets have an inclusive minimum and exclusive maximum. But
-		 * the largest bucket needs to have an _inclusive_ maximum as
-		 * well.
-		 */
-		if (b == (int)nr_buckets)
-			b--;
-
-		buckets[b]++;
-
-		nvgpu_rbtree_enum_next(&node, node);
+	for (shard_idx = 0; shard_idx < NVGPU_KMEM_TRACKER_SHARDS;
+	     shard_idx++) {
+		struct nvgpu_mem_alloc_shard *shard =
+			&tracker->shards[shard_idx];
+
+		nvgpu_mutex_acquire(&shard->lock);
+		nvgpu_rbtree_enum_start(0, &node, shard->allocs);
+		while (node) {
+			int b;
+			u64 bucket_min;
+			struct nvgpu_mem_alloc *alloc =
+				nvgpu_mem_alloc_from_rbtree_node(node);
+
+			bucket_min = (u64)rounddown_pow_of_two(alloc->size);
+			if (bucket_min < stats->min_alloc)
+				bucket_min = stats->min_alloc;
+
+			b = __ffs(bucket_min) - __ffs(pot_min);
+
+			/*
+			 * Handle the one case were there's an alloc exactly as
+			 * big as the maximum bucket size of the largest bucket.
+			 * Most of the buckets have an inclusive minimum and
+			 * exclusive maximum. But the largest bucket needs to
+			 * have an _inclusive_ maximum as well. Allocs made
+			 * after @stats was sampled are clamped the same way.
+			 */
+			if (b >= (int)nr_buckets)
+				b = (int)nr_buckets - 1;
+
+			buckets[b]++;
+
+			nvgpu_rbtree_enum_next(&node, node);
+		}
+		nvgpu_mutex_release(&shard->lock);
 	}
 
 	total_allocs = 0;
@@ -197,28 +209,28 @@ static void print_histogram(struct nvgpu_mem_alloc_tracker *tracker,
 void nvgpu_kmem_print_stats(struct nvgpu_mem_alloc_tracker *tracker,
 			    struct seq_file *s)
 {
-	nvgpu_lock_tracker(tracker);
+	struct nvgpu_mem_alloc_stats stats;
+
+	nvgpu_kmem_tracker_stats(tracker, &stats);
 
 	__pstat(s, "Mem tracker: %s\n\n", tracker->name);
 
 	__pstat(s, "Basic Stats:\n");
 	__pstat(s,        "  Number of allocs        %lld\n",
-		tracker->nr_allocs);
+		stats.nr_allocs);
 	__pstat(s,        "  Number of frees         %lld\n",
-		tracker->nr_frees);
-	print_hr_bytes(s, "  Smallest alloc          ", tracker->min_alloc);
-	print_hr_bytes(s, "  Largest alloc           ", tracker->max_alloc);
-	print_hr_bytes(s, "  Bytes allocated         ", tracker->bytes_alloced);
-	print_hr_bytes(s, "  Bytes freed             ", tracker->bytes_freed);
+		stats.nr_frees);
+	print_hr_bytes(s, "  Smallest alloc          ", stats.min_alloc);
+	print_hr_bytes(s, "  Largest alloc           ", stats.max_alloc);
+	print_hr_bytes(s, "  Bytes allocated         ", stats.bytes_alloced);
+	print_hr_bytes(s, "  Bytes freed             ", stats.bytes_freed);
 	print_hr_bytes(s, "  Bytes allocated (real)  ",
-		       tracker->bytes_alloced_real);
+		       stats.bytes_alloced_real);
 	print_hr_bytes(s, "  Bytes freed (real)      ",
-		       tracker->bytes_freed_real);
+		       stats.bytes_freed_real);
 	__pstat(s, "\n");
 
-	print_histogram(tracker, s);
-
-	nvgpu_unlock_tracker(tracker);
+	print_histogram(tracker, &stats, s);
 }
 
 static int __kmem_tracking_show(struct seq_file *s, void *unused)
@@ -247,15 +259,22 @@ static int __kmem_traces_dump_tracker(struct gk20a *g,
 				      struct seq_file *s)
 {
 	struct nvgpu_rbtree_node *node;
+	u32 i;
 
-	nvgpu_rbtree_enum_start(0, &node, tracker->allocs);
-	while (node) {
-		struct nvgpu_mem_alloc *alloc =
-			nvgpu_mem_alloc_from_rbtree_node(node);
+	for (i = 0; i < NVGPU_KMEM_TRACKER_SHARDS; i++) {
+		struct nvgpu_mem_alloc_shard *shard = &tracker->shards[i];
 
-		kmem_print_mem_alloc(g, alloc, s);
+		nvgpu_mutex_acquire(&shard->lock);
+		nvgpu_rbtree_enum_start(0, &node, shard->allocs);
+		while (node) {
+			struct nvgpu_mem_alloc *alloc =
+				nvgpu_mem_alloc_from_rbtree_node(node);
 
-		nvgpu_rbtree_enum_next(&node, node);
+			kmem_print_mem_alloc(g, alloc, s);
+
+			nvgpu_rbtree_enum_next(&node, node);
+		}
+		nvgpu_mutex_release(&shard->lock);
 	}
 
 	return 0;
@@ -265,16 +284,12 @@ static int __kmem_traces_show(struct seq_file *s, void *unused)
 {
 	struct gk20a *g = s->private;
 
-	nvgpu_lock_tracker(g->vmallocs);
 	seq_puts(s, "Oustanding vmallocs:\n");
 	__kmem_traces_dump_tracker(g, g->vmallocs, s);
 	seq_puts(s, "\n");
-	nvgpu_unlock_tracker(g->vmallocs);
 
-	nvgpu_lock_tracker(g->kmallocs);
 	seq_puts(s, "Oustanding kmallocs:\n");
 	__kmem_traces_dump_tracker(g, g->kmallocs, s);
-	nvgpu_unlock_tracker(g->kmallocs);
 
 	return 0;
 }
@@ -291,6 +306,60 @@ static const struct file_operations __kmem_traces_fops = {
 	.release = single_release,
 };
 
+static void __kmem_callsites_dump_tracker(
+	struct nvgpu_mem_alloc_tracker *tracker, struct seq_file *s)
+{
+	u32 i;
+
+	for (i = 0; i < NVGPU_KMEM_TRACKER_CALLSITES; i++) {
+		struct nvgpu_mem_alloc_callsite *site = &tracker->callsites[i];
+		long ip = nvgpu_atomic64_read(&site->ip);
+		long nr = nvgpu_atomic64_read(&site->nr_allocs);
+
+		if (ip == 0 || nr == 0)
+			continue;
+
+		seq_printf(s, "  %10ld %8ld  %pS\n",
+			   nvgpu_atomic64_read(&site->bytes), nr,
+			   (void *)(uintptr_t)ip);
+	}
+
+	if (nvgpu_atomic64_read(&tracker->callsite_overflow_allocs) != 0)
+		seq_printf(s, "  %10ld %8ld  (overflow)\n",
+			   nvgpu_atomic64_read(
+				   &tracker->callsite_overflow_bytes),
+			   nvgpu_atomic64_read(
+				   &tracker->callsite_overflow_allocs));
+}
+
+static int __kmem_callsites_show(struct seq_file *s, void *unused)
+{
+	struct gk20a *g = s->private;
+
+	seq_puts(s, "Outstanding vmallocs by callsite:\n");
+	seq_puts(s, "       bytes   allocs  callsite\n");
+	__kmem_callsites_dump_tracker(g->vmallocs, s);
+	seq_puts(s, "\n");
+
+	seq_puts(s, "Outstanding kmallocs by callsite:\n");
+	seq_puts(s, "       bytes   allocs  callsite\n");
+	__kmem_callsites_dump_tracker(g->kmallocs, s);
+
+	return 0;
+}
+
+static int __kmem_callsites_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, __kmem_callsites_show, inode->i_private);
+}
+
+static const struct file_operations __kmem_callsites_fops = {
+	.open = __kmem_callsites_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 void nvgpu_kmem_debugfs_init(struct gk20a *g)
 {
 	struct nvgpu_os_linux *l = nvgpu_os_linux_from_gk20a(g);
@@ -309,4 +378,7 @@ void nvgpu_kmem_debugfs_init(struct gk20a *g)
 	node = debugfs_create_file("traces", S_IRUGO,
 				   l->debugfs_kmem,
 				   g, &__kmem_traces_fops);
+	node = debugfs_create_file("callsites", S_IRUGO,
+				   l->debugfs_kmem,
+				   g, &__kmem_callsites_fops);
 }
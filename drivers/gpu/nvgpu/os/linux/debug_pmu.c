@@ -395,6 +395,40 @@ static const struct file_operations perfmon_events_count_fops = {
 	.release	= single_release,
 };
 
+static int perfmon_load_samples_show(struct seq_file *s, void *data)
+{
+	struct gk20a *g = s->private;
+	struct nvgpu_pmu_load_sample *samples;
+	u32 count, i;
+
+	samples = nvgpu_kcalloc(g, PMU_LOAD_SAMPLES_NUM, sizeof(*samples));
+	if (!samples)
+		return -ENOMEM;
+
+	count = nvgpu_pmu_load_ring_read(&g->pmu.load_ring, samples,
+			PMU_LOAD_SAMPLES_NUM);
+
+	seq_puts(s, "timestamp_ns load\n");
+	for (i = 0; i < count; i++)
+		seq_printf(s, "%lld %u\n", samples[i].timestamp_ns,
+			samples[i].load);
+
+	nvgpu_kfree(g, samples);
+	return 0;
+}
+
+static int perfmon_load_samples_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, perfmon_load_samples_show, inode->i_private);
+}
+
+static const struct file_operations perfmon_load_samples_fops = {
+	.open		= perfmon_load_samples_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int security_show(struct seq_file *s, void *data)
 {
 	struct gk20a *g = s->private;
@@ -416,6 +450,44 @@ static const struct file_operations security_fops = {
 	.release	= single_release,
 };
 
+static int pmu_ipc_stats_show(struct seq_file *s, void *data)
+{
+	struct gk20a *g = s->private;
+	struct nvgpu_pmu *pmu = &g->pmu;
+	u32 unit;
+
+	seq_printf(s, "in flight: %u (peak %u) of %u sequences\n",
+		nvgpu_pmu_seq_inflight(pmu), pmu->seq_inflight_peak,
+		PMU_MAX_NUM_SEQUENCES);
+	seq_puts(s, "unit  completed      avg(us)      max(us)\n");
+
+	for (unit = 0; unit < PMU_UNIT_END; unit++) {
+		struct pmu_ipc_unit_stats *stats = &pmu->ipc_stats[unit];
+
+		if (stats->completed == 0ULL)
+			continue;
+
+		seq_printf(s, "0x%02x  %9llu %12llu %12llu\n", unit,
+			stats->completed,
+			div64_u64(stats->total_ns, stats->completed) / 1000ULL,
+			stats->max_ns / 1000ULL);
+	}
+
+	return 0;
+}
+
+static int pmu_ipc_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pmu_ipc_stats_show, inode->i_private);
+}
+
+static const struct file_operations pmu_ipc_stats_fops = {
+	.open		= pmu_ipc_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 int gk20a_pmu_debugfs_init(struct gk20a *g)
 {
 	struct dentry *d;
@@ -476,6 +548,18 @@ int gk20a_pmu_debugfs_init(struct gk20a *g)
 						&perfmon_events_count_fops);
 		if (!d)
 			goto err_out;
+
+		d = debugfs_create_file(
+			"perfmon_load_samples", S_IRUGO, l->debugfs, g,
+						&perfmon_load_samples_fops);
+		if (!d)
+			goto err_out;
+
+		d = debugfs_create_file(
+			"pmu_ipc_stats", S_IRUGO, l->debugfs, g,
+						&pmu_ipc_stats_fops);
+		if (!d)
+			goto err_out;
 	}
 	return 0;
 err_out:
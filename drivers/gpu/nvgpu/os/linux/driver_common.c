@@ -67,6 +67,8 @@ static void nvgpu_init_vars(struct gk20a *g)
 	nvgpu_mutex_init(&g->clk_arb_enable_lock);
 	nvgpu_mutex_init(&g->cg_pg_lock);
 
+	nvgpu_firmware_cache_init(g);
+
 	/* Init the clock req count to 0 */
 	nvgpu_atomic_set(&g->clk_arb_global_nr, 0);
 
@@ -291,6 +293,10 @@ int nvgpu_probe(struct gk20a *g,
 	g->dbg_regops_tmp_buf_ops =
 		SZ_4K / sizeof(g->dbg_regops_tmp_buf[0]);
 
+	/* without the shrinker the cache is only released at remove */
+	if (nvgpu_firmware_shrinker_init(g))
+		nvgpu_warn(g, "firmware cache shrinker not registered");
+
 	g->remove_support = gk20a_remove_support;
 
 	nvgpu_ref_init(&g->refcount);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2017-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * This program is free software; you can redistribute it and/or modify it
  * under the terms and conditions of the GNU General Public License,
@@ -71,6 +71,12 @@ struct nvgpu_firmware *nvgpu_request_firmware(struct gk20a *g,
 	if (!current->fs || !fw_name)
 		return NULL;
 
+	if (flags & NVGPU_REQUEST_FIRMWARE_CACHE) {
+		fw = nvgpu_firmware_cache_get(g, fw_name);
+		if (fw)
+			return fw;
+	}
+
 	fw = nvgpu_kzalloc(g, sizeof(*fw));
 	if (!fw)
 		return NULL;
@@ -98,6 +104,10 @@ struct nvgpu_firmware *nvgpu_request_firmware(struct gk20a *g,
 
 	release_firmware(linux_fw);
 
+	if ((flags & NVGPU_REQUEST_FIRMWARE_CACHE) &&
+	    nvgpu_firmware_cache_put(g, fw_name, fw))
+		nvgpu_warn(g, "failed to cache firmware %s", fw_name);
+
 	return fw;
 
 err_release:
@@ -115,3 +125,55 @@ void nvgpu_release_firmware(struct gk20a *g, struct nvgpu_firmware *fw)
 	nvgpu_kfree(g, fw->data);
 	nvgpu_kfree(g, fw);
 }
+
+static unsigned long nvgpu_firmware_shrink_count(struct shrinker *s,
+						 struct shrink_control *sc)
+{
+	struct nvgpu_os_linux *l = container_of(s, struct nvgpu_os_linux,
+						fw_cache_shrinker);
+
+	return READ_ONCE(l->g.fw_cache.bytes) >> PAGE_SHIFT;
+}
+
+static unsigned long nvgpu_firmware_shrink_scan(struct shrinker *s,
+						struct shrink_control *sc)
+{
+	struct nvgpu_os_linux *l = container_of(s, struct nvgpu_os_linux,
+						fw_cache_shrinker);
+	size_t freed;
+
+	/* don't wait on a cache user from reclaim context */
+	if (nvgpu_firmware_cache_shrink(&l->g,
+			(size_t)sc->nr_to_scan << PAGE_SHIFT, &freed) != 0)
+		return SHRINK_STOP;
+
+	if (freed == 0)
+		return SHRINK_STOP;
+
+	return DIV_ROUND_UP(freed, PAGE_SIZE);
+}
+
+int nvgpu_firmware_shrinker_init(struct gk20a *g)
+{
+	struct nvgpu_os_linux *l = nvgpu_os_linux_from_gk20a(g);
+	int err;
+
+	l->fw_cache_shrinker.count_objects = nvgpu_firmware_shrink_count;
+	l->fw_cache_shrinker.scan_objects = nvgpu_firmware_shrink_scan;
+	l->fw_cache_shrinker.seeks = DEFAULT_SEEKS;
+
+	err = register_shrinker(&l->fw_cache_shrinker);
+	if (err)
+		memset(&l->fw_cache_shrinker, 0, sizeof(l->fw_cache_shrinker));
+
+	return err;
+}
+
+void nvgpu_firmware_shrinker_deinit(struct gk20a *g)
+{
+	struct nvgpu_os_linux *l = nvgpu_os_linux_from_gk20a(g);
+
+	if (l->fw_cache_shrinker.scan_objects)
+		unregister_shrinker(&l->fw_cache_shrinker);
+	nvgpu_firmware_cache_deinit(g);
+}
@@ -43,6 +43,30 @@ void nvgpu_writel_relaxed(struct gk20a *g, u32 r, u32 v)
 	}
 }
 
+/*
+ * Write @count (addr, value) pairs packed in @stream. Each entry is @stride
+ * words long with the address in word 0 and the value in word @value_idx.
+ * The writes are posted back to back and ordered by a single barrier.
+ */
+void nvgpu_writel_stream(struct gk20a *g, const u32 *stream, u32 count,
+		u32 stride, u32 value_idx)
+{
+	struct nvgpu_os_linux *l = nvgpu_os_linux_from_gk20a(g);
+	u32 i;
+
+	if (unlikely(!l->regs)) {
+		__gk20a_warn_on_no_regs();
+		nvgpu_log(g, gpu_dbg_reg, "stream n=%u (failed)", count);
+		return;
+	}
+
+	for (i = 0; i < count; i++, stream += stride) {
+		writel_relaxed(stream[value_idx], l->regs + stream[0]);
+	}
+	nvgpu_wmb();
+	nvgpu_log(g, gpu_dbg_reg, "stream n=%u", count);
+}
+
 u32 nvgpu_readl(struct gk20a *g, u32 r)
 {
 	u32 v = __nvgpu_readl(g, r);
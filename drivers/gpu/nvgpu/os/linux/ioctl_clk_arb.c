@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * This software is licensed under the terms of the GNU General Public
  * License version 2, as published by the Free Software Foundation, and
@@ -441,6 +441,7 @@ int nvgpu_clk_arb_commit_request_fd(struct gk20a *g,
 	nvgpu_spinlock_acquire(&session->session_lock);
 	nvgpu_list_add(&dev->node, &session->targets);
 	nvgpu_spinlock_release(&session->session_lock);
+	nvgpu_clk_arb_session_post(arb, session);
 	nvgpu_clk_arb_worker_enqueue(g, &arb->update_arb_work_item);
 
 fdput_fd:
@@ -20,6 +20,8 @@
 #include <linux/seq_file.h>
 #include <linux/vmalloc.h>
 #include <linux/stacktrace.h>
+#include <linux/hash.h>
+#include <linux/log2.h>
 
 #include <nvgpu/lock.h>
 #include <nvgpu/kmem.h>
@@ -168,14 +170,120 @@ void __nvgpu_vfree(struct gk20a *g, void *addr)
 
 #ifdef CONFIG_NVGPU_TRACK_MEM_USAGE
 
-void nvgpu_lock_tracker(struct nvgpu_mem_alloc_tracker *tracker)
+static struct nvgpu_mem_alloc_shard *nvgpu_kmem_shard(
+	struct nvgpu_mem_alloc_tracker *tracker, u64 addr)
 {
-	nvgpu_mutex_acquire(&tracker->lock);
+	u32 idx = hash_64(addr, ilog2(NVGPU_KMEM_TRACKER_SHARDS));
+
+	return &tracker->shards[idx];
+}
+
+/*
+ * Find (or claim) the callsite slot for @ip. Returns NULL if the table is
+ * full, in which case the caller accounts the alloc as overflow.
+ */
+static struct nvgpu_mem_alloc_callsite *nvgpu_kmem_callsite(
+	struct nvgpu_mem_alloc_tracker *tracker, void *ip)
+{
+	long key = (long)(uintptr_t)ip;
+	u32 mask = NVGPU_KMEM_TRACKER_CALLSITES - 1U;
+	u32 idx = hash_64((u64)key, ilog2(NVGPU_KMEM_TRACKER_CALLSITES));
+	u32 i;
+
+	for (i = 0; i < NVGPU_KMEM_TRACKER_CALLSITES; i++) {
+		struct nvgpu_mem_alloc_callsite *site =
+			&tracker->callsites[(idx + i) & mask];
+		long cur = nvgpu_atomic64_read(&site->ip);
+
+		if (cur == 0)
+			cur = nvgpu_atomic64_cmpxchg(&site->ip, 0, key);
+		if (cur == 0 || cur == key)
+			return site;
+	}
+
+	return NULL;
+}
+
+static void nvgpu_kmem_callsite_add(struct nvgpu_mem_alloc_tracker *tracker,
+				    struct nvgpu_mem_alloc *alloc)
+{
+	if (alloc->callsite) {
+		nvgpu_atomic64_add(alloc->size, &alloc->callsite->bytes);
+		nvgpu_atomic64_inc(&alloc->callsite->nr_allocs);
+	} else {
+		nvgpu_atomic64_add(alloc->size,
+				   &tracker->callsite_overflow_bytes);
+		nvgpu_atomic64_inc(&tracker->callsite_overflow_allocs);
+	}
+}
+
+static void nvgpu_kmem_callsite_sub(struct nvgpu_mem_alloc_tracker *tracker,
+				    struct nvgpu_mem_alloc *alloc)
+{
+	if (alloc->callsite) {
+		nvgpu_atomic64_sub(alloc->size, &alloc->callsite->bytes);
+		nvgpu_atomic64_dec(&alloc->callsite->nr_allocs);
+	} else {
+		nvgpu_atomic64_sub(alloc->size,
+				   &tracker->callsite_overflow_bytes);
+		nvgpu_atomic64_dec(&tracker->callsite_overflow_allocs);
+	}
+}
+
+static struct nvgpu_mem_alloc *nvgpu_kmem_alloc_meta(
+	struct nvgpu_mem_alloc_tracker *tracker)
+{
+	struct nvgpu_mem_alloc *alloc;
+
+	/*
+	 * The allocs_cache is itself created with nvgpu_kzalloc() so the first
+	 * couple of allocs have to fall back to a plain kzalloc().
+	 */
+	if (!tracker->allocs_cache)
+		return kzalloc(sizeof(*alloc), GFP_KERNEL);
+
+	alloc = nvgpu_kmem_cache_alloc(tracker->allocs_cache);
+	if (alloc) {
+		memset(alloc, 0, sizeof(*alloc));
+		alloc->cached = true;
+	}
+
+	return alloc;
+}
+
+static void nvgpu_kmem_free_meta(struct nvgpu_mem_alloc_tracker *tracker,
+				 struct nvgpu_mem_alloc *alloc)
+{
+	if (alloc->cached)
+		nvgpu_kmem_cache_free(tracker->allocs_cache, alloc);
+	else
+		kfree(alloc);
 }
 
-void nvgpu_unlock_tracker(struct nvgpu_mem_alloc_tracker *tracker)
+void nvgpu_kmem_tracker_stats(struct nvgpu_mem_alloc_tracker *tracker,
+			      struct nvgpu_mem_alloc_stats *stats)
 {
-	nvgpu_mutex_release(&tracker->lock);
+	u32 i;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->min_alloc = ULONG_MAX;
+
+	for (i = 0; i < NVGPU_KMEM_TRACKER_SHARDS; i++) {
+		struct nvgpu_mem_alloc_shard *shard = &tracker->shards[i];
+
+		nvgpu_mutex_acquire(&shard->lock);
+		stats->bytes_alloced += shard->stats.bytes_alloced;
+		stats->bytes_freed += shard->stats.bytes_freed;
+		stats->bytes_alloced_real += shard->stats.bytes_alloced_real;
+		stats->bytes_freed_real += shard->stats.bytes_freed_real;
+		stats->nr_allocs += shard->stats.nr_allocs;
+		stats->nr_frees += shard->stats.nr_frees;
+		stats->min_alloc = min(stats->min_alloc,
+				       shard->stats.min_alloc);
+		stats->max_alloc = max(stats->max_alloc,
+				       shard->stats.max_alloc);
+		nvgpu_mutex_release(&shard->lock);
+	}
 }
 
 void kmem_print_mem_alloc(struct gk20a *g,
@@ -198,29 +306,29 @@ void kmem_print_mem_alloc(struct gk20a *g,
 #endif
 }
 
-static int nvgpu_add_alloc(struct nvgpu_mem_alloc_tracker *tracker,
+static int nvgpu_add_alloc(struct nvgpu_mem_alloc_shard *shard,
 			   struct nvgpu_mem_alloc *alloc)
 {
 	alloc->allocs_entry.key_start = alloc->addr;
 	alloc->allocs_entry.key_end = alloc->addr + alloc->size;
 
-	nvgpu_rbtree_insert(&alloc->allocs_entry, &tracker->allocs);
+	nvgpu_rbtree_insert(&alloc->allocs_entry, &shard->allocs);
 	return 0;
 }
 
 static struct nvgpu_mem_alloc *nvgpu_rem_alloc(
-	struct nvgpu_mem_alloc_tracker *tracker, u64 alloc_addr)
+	struct nvgpu_mem_alloc_shard *shard, u64 alloc_addr)
 {
 	struct nvgpu_mem_alloc *alloc;
 	struct nvgpu_rbtree_node *node = NULL;
 
-	nvgpu_rbtree_search(alloc_addr, &node, tracker->allocs);
+	nvgpu_rbtree_search(alloc_addr, &node, shard->allocs);
 	if (!node)
 		return NULL;
 
 	alloc = nvgpu_mem_alloc_from_rbtree_node(node);
 
-	nvgpu_rbtree_unlink(node, &tracker->allocs);
+	nvgpu_rbtree_unlink(node, &shard->allocs);
 
 	return alloc;
 }
@@ -231,15 +339,17 @@ static int __nvgpu_save_kmem_alloc(struct nvgpu_mem_alloc_tracker *tracker,
 {
 	int ret;
 	struct nvgpu_mem_alloc *alloc;
+	struct nvgpu_mem_alloc_shard *shard = nvgpu_kmem_shard(tracker, addr);
 #ifdef __NVGPU_SAVE_KALLOC_STACK_TRACES
 	struct stack_trace stack_trace;
 #endif
 
-	alloc = kzalloc(sizeof(*alloc), GFP_KERNEL);
+	alloc = nvgpu_kmem_alloc_meta(tracker);
 	if (!alloc)
 		return -ENOMEM;
 
 	alloc->owner = tracker;
+	alloc->callsite = nvgpu_kmem_callsite(tracker, ip);
 	alloc->size = size;
 	alloc->real_size = real_size;
 	alloc->addr = addr;
@@ -265,25 +375,28 @@ static int __nvgpu_save_kmem_alloc(struct nvgpu_mem_alloc_tracker *tracker,
 	alloc->stack_length = stack_trace.nr_entries;
 #endif
 
-	nvgpu_lock_tracker(tracker);
-	tracker->bytes_alloced += size;
-	tracker->bytes_alloced_real += real_size;
-	tracker->nr_allocs++;
+	nvgpu_kmem_callsite_add(tracker, alloc);
+
+	nvgpu_mutex_acquire(&shard->lock);
+	shard->stats.bytes_alloced += size;
+	shard->stats.bytes_alloced_real += real_size;
+	shard->stats.nr_allocs++;
 
 	/* Keep track of this for building a histogram later on. */
-	if (tracker->max_alloc < size)
-		tracker->max_alloc = size;
-	if (tracker->min_alloc > size)
-		tracker->min_alloc = size;
+	if (shard->stats.max_alloc < size)
+		shard->stats.max_alloc = size;
+	if (shard->stats.min_alloc > size)
+		shard->stats.min_alloc = size;
 
-	ret = nvgpu_add_alloc(tracker, alloc);
+	ret = nvgpu_add_alloc(shard, alloc);
 	if (ret) {
 		WARN(1, "Duplicate alloc??? 0x%llx\n", addr);
-		kfree(alloc);
-		nvgpu_unlock_tracker(tracker);
+		nvgpu_mutex_release(&shard->lock);
+		nvgpu_kmem_callsite_sub(tracker, alloc);
+		nvgpu_kmem_free_meta(tracker, alloc);
 		return ret;
 	}
-	nvgpu_unlock_tracker(tracker);
+	nvgpu_mutex_release(&shard->lock);
 
 	return 0;
 }
@@ -292,20 +405,27 @@ static int __nvgpu_free_kmem_alloc(struct nvgpu_mem_alloc_tracker *tracker,
 				   u64 addr)
 {
 	struct nvgpu_mem_alloc *alloc;
+	struct nvgpu_mem_alloc_shard *shard = nvgpu_kmem_shard(tracker, addr);
 
-	nvgpu_lock_tracker(tracker);
-	alloc = nvgpu_rem_alloc(tracker, addr);
+	nvgpu_mutex_acquire(&shard->lock);
+	alloc = nvgpu_rem_alloc(shard, addr);
 	if (WARN(!alloc, "Possible double-free detected: 0x%llx!", addr)) {
-		nvgpu_unlock_tracker(tracker);
+		nvgpu_mutex_release(&shard->lock);
 		return -EINVAL;
 	}
 
-	memset((void *)alloc->addr, 0, alloc->size);
+	shard->stats.nr_frees++;
+	shard->stats.bytes_freed += alloc->size;
+	shard->stats.bytes_freed_real += alloc->real_size;
+	nvgpu_mutex_release(&shard->lock);
 
-	tracker->nr_frees++;
-	tracker->bytes_freed += alloc->size;
-	tracker->bytes_freed_real += alloc->real_size;
-	nvgpu_unlock_tracker(tracker);
+	/*
+	 * Once unlinked nobody else can see this alloc so the poisoning and
+	 * metadata release can happen outside of the shard lock.
+	 */
+	memset((void *)alloc->addr, 0, alloc->size);
+	nvgpu_kmem_callsite_sub(tracker, alloc);
+	nvgpu_kmem_free_meta(tracker, alloc);
 
 	return 0;
 }
@@ -438,17 +558,22 @@ static int __do_check_for_outstanding_allocs(
 {
 	struct nvgpu_rbtree_node *node;
 	int count = 0;
+	u32 i;
+
+	for (i = 0; i < NVGPU_KMEM_TRACKER_SHARDS; i++) {
+		struct nvgpu_mem_alloc_shard *shard = &tracker->shards[i];
 
-	nvgpu_rbtree_enum_start(0, &node, tracker->allocs);
-	while (node) {
-		struct nvgpu_mem_alloc *alloc =
-			nvgpu_mem_alloc_from_rbtree_node(node);
+		nvgpu_rbtree_enum_start(0, &node, shard->allocs);
+		while (node) {
+			struct nvgpu_mem_alloc *alloc =
+				nvgpu_mem_alloc_from_rbtree_node(node);
 
-		if (!silent)
-			kmem_print_mem_alloc(g, alloc, NULL);
+			if (!silent)
+				kmem_print_mem_alloc(g, alloc, NULL);
 
-		count++;
-		nvgpu_rbtree_enum_next(&node, node);
+			count++;
+			nvgpu_rbtree_enum_next(&node, node);
+		}
 	}
 
 	return count;
@@ -478,19 +603,25 @@ static void do_nvgpu_kmem_cleanup(struct nvgpu_mem_alloc_tracker *tracker,
 				  void (*force_free_func)(const void *))
 {
 	struct nvgpu_rbtree_node *node;
+	u32 i;
 
-	nvgpu_rbtree_enum_start(0, &node, tracker->allocs);
-	while (node) {
-		struct nvgpu_mem_alloc *alloc =
-			nvgpu_mem_alloc_from_rbtree_node(node);
+	for (i = 0; i < NVGPU_KMEM_TRACKER_SHARDS; i++) {
+		struct nvgpu_mem_alloc_shard *shard = &tracker->shards[i];
 
-		if (force_free_func)
-			force_free_func((void *)alloc->addr);
+		nvgpu_rbtree_enum_start(0, &node, shard->allocs);
+		while (node) {
+			struct nvgpu_mem_alloc *alloc =
+				nvgpu_mem_alloc_from_rbtree_node(node);
 
-		nvgpu_rbtree_unlink(node, &tracker->allocs);
-		kfree(alloc);
+			if (force_free_func)
+				force_free_func((void *)alloc->addr);
 
-		nvgpu_rbtree_enum_start(0, &node, tracker->allocs);
+			nvgpu_rbtree_unlink(node, &shard->allocs);
+			nvgpu_kmem_callsite_sub(tracker, alloc);
+			nvgpu_kmem_free_meta(tracker, alloc);
+
+			nvgpu_rbtree_enum_start(0, &node, shard->allocs);
+		}
 	}
 }
 
@@ -547,6 +678,22 @@ void nvgpu_kmem_fini(struct gk20a *g, int flags)
 	}
 }
 
+static void nvgpu_kmem_tracker_init(struct nvgpu_mem_alloc_tracker *tracker,
+				    const char *name, unsigned long min_alloc)
+{
+	u32 i;
+
+	tracker->name = name;
+
+	for (i = 0; i < NVGPU_KMEM_TRACKER_SHARDS; i++) {
+		struct nvgpu_mem_alloc_shard *shard = &tracker->shards[i];
+
+		shard->allocs = NULL;
+		nvgpu_mutex_init(&shard->lock);
+		shard->stats.min_alloc = min_alloc;
+	}
+}
+
 int nvgpu_kmem_init(struct gk20a *g)
 {
 	int err;
@@ -559,17 +706,8 @@ int nvgpu_kmem_init(struct gk20a *g)
 		goto fail;
 	}
 
-	g->vmallocs->name = "vmalloc";
-	g->kmallocs->name = "kmalloc";
-
-	g->vmallocs->allocs = NULL;
-	g->kmallocs->allocs = NULL;
-
-	nvgpu_mutex_init(&g->vmallocs->lock);
-	nvgpu_mutex_init(&g->kmallocs->lock);
-
-	g->vmallocs->min_alloc = PAGE_SIZE;
-	g->kmallocs->min_alloc = KMALLOC_MIN_SIZE;
+	nvgpu_kmem_tracker_init(g->vmallocs, "vmalloc", PAGE_SIZE);
+	nvgpu_kmem_tracker_init(g->kmallocs, "kmalloc", KMALLOC_MIN_SIZE);
 
 	/*
 	 * This needs to go after all the other initialization since they use
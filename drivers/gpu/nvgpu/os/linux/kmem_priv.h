@@ -19,6 +19,7 @@
 
 #include <nvgpu/rbtree.h>
 #include <nvgpu/lock.h>
+#include <nvgpu/atomic.h>
 
 struct seq_file;
 
@@ -50,8 +51,33 @@ struct nvgpu_kmem_cache {
 
 #ifdef CONFIG_NVGPU_TRACK_MEM_USAGE
 
+/*
+ * Outstanding allocations are spread across shards by address hash so that
+ * unrelated allocs and frees don't serialize on a single lock. Must be a
+ * power of two.
+ */
+#define NVGPU_KMEM_TRACKER_SHARDS		16U
+
+/*
+ * Size of the per-tracker callsite table. Callsites that don't fit are
+ * accounted in the tracker's overflow counters instead.
+ */
+#define NVGPU_KMEM_TRACKER_CALLSITES		512U
+
+/*
+ * Aggregated outstanding allocations for a single caller. Slots are claimed
+ * with a cmpxchg on @ip and never released so the counters can be updated
+ * without taking any lock.
+ */
+struct nvgpu_mem_alloc_callsite {
+	nvgpu_atomic64_t ip;
+	nvgpu_atomic64_t bytes;
+	nvgpu_atomic64_t nr_allocs;
+};
+
 struct nvgpu_mem_alloc {
 	struct nvgpu_mem_alloc_tracker *owner;
+	struct nvgpu_mem_alloc_callsite *callsite;
 
 	void *ip;
 #ifdef __NVGPU_SAVE_KALLOC_STACK_TRACES
@@ -64,6 +90,9 @@ struct nvgpu_mem_alloc {
 	unsigned long size;
 	unsigned long real_size;
 
+	/* Set when this struct came from the owner's allocs_cache. */
+	bool cached;
+
 	struct nvgpu_rbtree_node allocs_entry;
 };
 
@@ -75,14 +104,10 @@ nvgpu_mem_alloc_from_rbtree_node(struct nvgpu_rbtree_node *node)
 };
 
 /*
- * Linux specific tracking of vmalloc, kmalloc, etc.
+ * Allocation stats. Each shard keeps its own copy under the shard lock; the
+ * tracker wide numbers are the sum over all shards.
  */
-struct nvgpu_mem_alloc_tracker {
-	const char *name;
-	struct nvgpu_kmem_cache *allocs_cache;
-	struct nvgpu_rbtree_node *allocs;
-	struct nvgpu_mutex lock;
-
+struct nvgpu_mem_alloc_stats {
 	u64 bytes_alloced;
 	u64 bytes_freed;
 	u64 bytes_alloced_real;
@@ -94,8 +119,28 @@ struct nvgpu_mem_alloc_tracker {
 	unsigned long max_alloc;
 };
 
-void nvgpu_lock_tracker(struct nvgpu_mem_alloc_tracker *tracker);
-void nvgpu_unlock_tracker(struct nvgpu_mem_alloc_tracker *tracker);
+struct nvgpu_mem_alloc_shard {
+	struct nvgpu_mutex lock;
+	struct nvgpu_rbtree_node *allocs;
+	struct nvgpu_mem_alloc_stats stats;
+};
+
+/*
+ * Linux specific tracking of vmalloc, kmalloc, etc.
+ */
+struct nvgpu_mem_alloc_tracker {
+	const char *name;
+	struct nvgpu_kmem_cache *allocs_cache;
+
+	struct nvgpu_mem_alloc_shard shards[NVGPU_KMEM_TRACKER_SHARDS];
+
+	struct nvgpu_mem_alloc_callsite callsites[NVGPU_KMEM_TRACKER_CALLSITES];
+	nvgpu_atomic64_t callsite_overflow_bytes;
+	nvgpu_atomic64_t callsite_overflow_allocs;
+};
+
+void nvgpu_kmem_tracker_stats(struct nvgpu_mem_alloc_tracker *tracker,
+			      struct nvgpu_mem_alloc_stats *stats);
 
 void kmem_print_mem_alloc(struct gk20a *g,
 			 struct nvgpu_mem_alloc *alloc,
@@ -763,6 +763,8 @@ void gk20a_remove_support(struct gk20a *g)
 
 	nvgpu_free_enabled_flags(g);
 
+	nvgpu_firmware_shrinker_deinit(g);
+
 	gk20a_lockout_registers(g);
 }
 
@@ -20,6 +20,7 @@
 #include <linux/cdev.h>
 #include <linux/iommu.h>
 #include <linux/hashtable.h>
+#include <linux/shrinker.h>
 
 #include <nvgpu/gk20a.h>
 
@@ -107,6 +108,9 @@ struct nvgpu_os_linux {
 
 	struct device_dma_parameters dma_parms;
 
+	/* releases g->fw_cache under memory pressure */
+	struct shrinker fw_cache_shrinker;
+
 	atomic_t hw_irq_stall_count;
 	atomic_t hw_irq_nonstall_count;
 
@@ -180,6 +184,9 @@ static inline struct device *dev_from_gk20a(struct gk20a *g)
 	return nvgpu_os_linux_from_gk20a(g)->dev;
 }
 
+int nvgpu_firmware_shrinker_init(struct gk20a *g);
+void nvgpu_firmware_shrinker_deinit(struct gk20a *g);
+
 #define INTERFACE_NAME "nvhost%s-gpu"
 
 #define totalram_size_in_mb (totalram_pages >> (10 - (PAGE_SHIFT - 10)))
@@ -18,6 +18,7 @@
 
 #include <linux/devfreq.h>
 #include <linux/export.h>
+#include <linux/math64.h>
 #include <soc/tegra/chip-id.h>
 #include <linux/pm_qos.h>
 
@@ -210,6 +211,67 @@ static int gk20a_scale_target(struct device *dev, unsigned long *freq,
 	return 0;
 }
 
+/*
+ * gk20a_scale_submit_boost(g, profile, t, dt)
+ *
+ * Busy cycles only tell how loaded the GPU was. Work that has been
+ * submitted but not run yet shows up in the submit path first: a jump
+ * in the submit rate, a deep job queue or many jobs stalled on
+ * pre-fences. Report at least busy_pct load while any of those hold, and
+ * for hold_ms after, so that the governor ramps up before the burst
+ * lands and does not drop the clock between frames. While boosting,
+ * the load over the last hold_ms from the PMU load ring is reported if
+ * it is higher, so the idle gaps between frames do not pull it down.
+ */
+
+static void gk20a_scale_submit_boost(struct gk20a *g,
+				     struct gk20a_scale_profile *profile,
+				     ktime_t t, unsigned long dt)
+{
+	struct gk20a_scale_submit_boost *boost = &profile->submit_boost;
+	u64 submits, rate;
+	int jobs, waits;
+	u32 load;
+	bool trigger = false;
+
+	if (!dt)
+		return;
+
+	submits = (u64)nvgpu_atomic64_read(&g->fifo.activity.submits);
+	jobs = nvgpu_atomic_read(&g->fifo.activity.jobs);
+	waits = nvgpu_atomic_read(&g->fifo.activity.waits);
+
+	/* submits per second over the last polling interval */
+	rate = div64_u64((submits - boost->last_submits) * USEC_PER_SEC, dt);
+	boost->last_submits = submits;
+
+	if (boost->rate_up_pct &&
+	    rate * 100ULL > boost->rate_avg * boost->rate_up_pct)
+		trigger = true;
+	if (boost->jobs && jobs >= (int)boost->jobs)
+		trigger = true;
+	if (boost->waits && waits >= (int)boost->waits)
+		trigger = true;
+
+	boost->rate_avg = (7ULL * boost->rate_avg + rate) / 8ULL;
+
+	if (trigger)
+		boost->hold_until = ktime_add_ms(t, boost->hold_ms);
+
+	if (!ktime_before(t, boost->hold_until))
+		return;
+
+	profile->dev_stat.busy_time =
+		max_t(unsigned long, profile->dev_stat.busy_time,
+		      (dt * boost->busy_pct) / 100UL);
+
+	if (!nvgpu_pmu_load_window(g, (s64)boost->hold_ms * NSEC_PER_MSEC,
+				   &load))
+		profile->dev_stat.busy_time =
+			max_t(unsigned long, profile->dev_stat.busy_time,
+			      (dt * load) / PMU_BUSY_CYCLES_NORM_MAX);
+}
+
 /*
  * update_load_estimate_busy_cycles(dev)
  *
@@ -233,6 +295,9 @@ static void update_load_estimate_busy_cycles(struct device *dev)
 	nvgpu_pmu_busy_cycles_norm(g, &busy_cycles_norm);
 	profile->dev_stat.busy_time =
 		(busy_cycles_norm * dt) / PMU_BUSY_CYCLES_NORM_MAX;
+
+	if (profile->submit_boost.enabled)
+		gk20a_scale_submit_boost(g, profile, t, dt);
 }
 
 /*
@@ -353,6 +418,13 @@ void gk20a_scale_init(struct device *dev)
 	profile->qos_min_freq = 0;
 	profile->qos_max_freq = UINT_MAX;
 
+	profile->submit_boost.rate_up_pct =
+		GK20A_SCALE_BOOST_RATE_UP_PCT_DEFAULT;
+	profile->submit_boost.jobs = GK20A_SCALE_BOOST_JOBS_DEFAULT;
+	profile->submit_boost.waits = GK20A_SCALE_BOOST_WAITS_DEFAULT;
+	profile->submit_boost.busy_pct = GK20A_SCALE_BOOST_BUSY_PCT_DEFAULT;
+	profile->submit_boost.hold_ms = GK20A_SCALE_BOOST_HOLD_MS_DEFAULT;
+
 	/* Store device profile so we can access it if devfreq governor
 	 * init needs that */
 	g->scale_profile = profile;
@@ -432,4 +504,6 @@ void gk20a_scale_hw_init(struct device *dev)
 
 	profile->dev_stat.total_time = 0;
 	profile->last_event_time = ktime_get();
+	profile->submit_boost.last_submits = (u64)nvgpu_atomic64_read(
+			&platform->g->fifo.activity.submits);
 }
@@ -1,7 +1,7 @@
 /*
  * gk20a clock scaling profile
  *
- * Copyright (c) 2013-2016, NVIDIA Corporation. All rights reserved.
+ * Copyright (c) 2013-2019, NVIDIA Corporation. All rights reserved.
  *
  * This program is free software; you can redistribute it and/or modify it
  * under the terms and conditions of the GNU General Public License,
@@ -23,6 +23,35 @@
 
 struct clk;
 
+/* submit boost defaults, see gk20a_scale_submit_boost() */
+#define GK20A_SCALE_BOOST_RATE_UP_PCT_DEFAULT	150U
+#define GK20A_SCALE_BOOST_JOBS_DEFAULT		8U
+#define GK20A_SCALE_BOOST_WAITS_DEFAULT		4U
+#define GK20A_SCALE_BOOST_BUSY_PCT_DEFAULT	90U
+#define GK20A_SCALE_BOOST_HOLD_MS_DEFAULT	50U
+
+/*
+ * Raise the load reported to devfreq ahead of a submit burst. A zero
+ * threshold disables that trigger.
+ */
+struct gk20a_scale_submit_boost {
+	bool				enabled;
+	/* submit rate vs. its running average, in percent */
+	u32				rate_up_pct;
+	/* jobs in flight */
+	u32				jobs;
+	/* jobs in flight that wait on a pre-fence */
+	u32				waits;
+	/* lowest load reported while boosting, in percent */
+	u32				busy_pct;
+	/* keep boosting this long after the last trigger */
+	u32				hold_ms;
+
+	u64				last_submits;
+	u64				rate_avg;
+	ktime_t				hold_until;
+};
+
 struct gk20a_scale_profile {
 	struct device			*dev;
 	ktime_t				last_event_time;
@@ -31,6 +60,7 @@ struct gk20a_scale_profile {
 	struct notifier_block		qos_notify_block;
 	unsigned long			qos_min_freq;
 	unsigned long			qos_max_freq;
+	struct gk20a_scale_submit_boost	submit_boost;
 	void				*private_data;
 };
 
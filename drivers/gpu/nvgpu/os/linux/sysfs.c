@@ -27,6 +27,7 @@
 #include "os_linux.h"
 #include "sysfs.h"
 #include "platform_gk20a.h"
+#include "scale.h"
 #include "gk20a/gr_gk20a.h"
 #include "gv11b/gr_gv11b.h"
 
@@ -634,6 +635,95 @@ static ssize_t aelpg_param_read(struct device *dev,
 static DEVICE_ATTR(aelpg_param, ROOTRW,
 		aelpg_param_read, aelpg_param_store);
 
+static ssize_t submit_boost_enable_store(struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct gk20a *g = get_gk20a(dev);
+	unsigned long val = 0;
+
+	if (!g->scale_profile)
+		return -ENODEV;
+
+	if (kstrtoul(buf, 10, &val) < 0)
+		return -EINVAL;
+
+	g->scale_profile->submit_boost.enabled = val ? true : false;
+
+	return count;
+}
+
+static ssize_t submit_boost_enable_read(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct gk20a *g = get_gk20a(dev);
+
+	if (!g->scale_profile)
+		return -ENODEV;
+
+	return snprintf(buf, PAGE_SIZE, "%d\n",
+		g->scale_profile->submit_boost.enabled ? 1 : 0);
+}
+
+static DEVICE_ATTR(submit_boost_enable, ROOTRW,
+		submit_boost_enable_read, submit_boost_enable_store);
+
+static ssize_t submit_boost_param_store(struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct gk20a *g = get_gk20a(dev);
+	struct gk20a_scale_submit_boost *boost;
+	u32 param[5];
+
+	if (!g->scale_profile)
+		return -ENODEV;
+
+	boost = &g->scale_profile->submit_boost;
+
+	/* rate_up_pct jobs waits busy_pct hold_ms */
+	if (sscanf(buf, "%u %u %u %u %u", &param[0], &param[1],
+			&param[2], &param[3], &param[4]) != 5)
+		return -EINVAL;
+
+	/* All zero resets to SW default values */
+	if ((param[0] | param[1] | param[2] | param[3] | param[4]) == 0U) {
+		param[0] = GK20A_SCALE_BOOST_RATE_UP_PCT_DEFAULT;
+		param[1] = GK20A_SCALE_BOOST_JOBS_DEFAULT;
+		param[2] = GK20A_SCALE_BOOST_WAITS_DEFAULT;
+		param[3] = GK20A_SCALE_BOOST_BUSY_PCT_DEFAULT;
+		param[4] = GK20A_SCALE_BOOST_HOLD_MS_DEFAULT;
+	}
+
+	if (param[3] > 100U)
+		return -EINVAL;
+
+	boost->rate_up_pct = param[0];
+	boost->jobs = param[1];
+	boost->waits = param[2];
+	boost->busy_pct = param[3];
+	boost->hold_ms = param[4];
+
+	return count;
+}
+
+static ssize_t submit_boost_param_read(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct gk20a *g = get_gk20a(dev);
+	struct gk20a_scale_submit_boost *boost;
+
+	if (!g->scale_profile)
+		return -ENODEV;
+
+	boost = &g->scale_profile->submit_boost;
+
+	return snprintf(buf, PAGE_SIZE, "%u %u %u %u %u\n",
+		boost->rate_up_pct, boost->jobs, boost->waits,
+		boost->busy_pct, boost->hold_ms);
+}
+
+static DEVICE_ATTR(submit_boost_param, ROOTRW,
+		submit_boost_param_read, submit_boost_param_store);
+
 static ssize_t aelpg_enable_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t count)
 {
@@ -1187,6 +1277,8 @@ void nvgpu_remove_sysfs(struct device *dev)
 #endif
 	device_remove_file(dev, &dev_attr_aelpg_param);
 	device_remove_file(dev, &dev_attr_aelpg_enable);
+	device_remove_file(dev, &dev_attr_submit_boost_enable);
+	device_remove_file(dev, &dev_attr_submit_boost_param);
 	device_remove_file(dev, &dev_attr_allow_all);
 	device_remove_file(dev, &dev_attr_tpc_fs_mask);
 	device_remove_file(dev, &dev_attr_tpc_pg_mask);
@@ -1242,6 +1334,8 @@ int nvgpu_create_sysfs(struct device *dev)
 #endif
 	error |= device_create_file(dev, &dev_attr_aelpg_param);
 	error |= device_create_file(dev, &dev_attr_aelpg_enable);
+	error |= device_create_file(dev, &dev_attr_submit_boost_enable);
+	error |= device_create_file(dev, &dev_attr_submit_boost_param);
 	error |= device_create_file(dev, &dev_attr_allow_all);
 	error |= device_create_file(dev, &dev_attr_tpc_fs_mask);
 	error |= device_create_file(dev, &dev_attr_tpc_pg_mask);
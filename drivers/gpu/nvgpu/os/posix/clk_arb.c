@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -156,6 +156,18 @@ void nvgpu_clk_arb_schedule_vf_table_update(struct gk20a *g)
 {
 }
 
+void nvgpu_clk_arb_session_post(struct nvgpu_clk_arb *arb,
+				struct nvgpu_clk_session *session)
+{
+}
+
+void nvgpu_clk_arb_aggregate_targets(struct nvgpu_clk_arb *arb,
+				     u16 *gpc2clk_target, u16 *mclk_target)
+{
+	*gpc2clk_target = 0;
+	*mclk_target = 0;
+}
+
 int nvgpu_clk_arb_get_current_pstate(struct gk20a *g)
 {
 	return -ENOSYS;
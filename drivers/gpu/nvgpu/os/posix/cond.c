@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -24,32 +24,89 @@
 
 #include <nvgpu/posix/cond.h>
 
+/*
+ * Deadlines are absolute CLOCK_MONOTONIC times, the condvar clock is set
+ * accordingly in nvgpu_cond_init().
+ */
+void __nvgpu_cond_timeout(struct timespec *ts, long timeout_ms)
+{
+	clock_gettime(CLOCK_MONOTONIC, ts);
+
+	ts->tv_sec += timeout_ms / 1000;
+	ts->tv_nsec += (timeout_ms % 1000) * 1000000;
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
 int nvgpu_cond_init(struct nvgpu_cond *cond)
 {
-	return -ENOSYS;
+	pthread_condattr_t attr;
+	int ret;
+
+	ret = pthread_mutex_init(&cond->mutex, NULL);
+	if (ret != 0) {
+		return -ret;
+	}
+
+	(void) pthread_condattr_init(&attr);
+	(void) pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	ret = pthread_cond_init(&cond->cond, &attr);
+	(void) pthread_condattr_destroy(&attr);
+	if (ret != 0) {
+		(void) pthread_mutex_destroy(&cond->mutex);
+		return -ret;
+	}
+
+	cond->initialized = true;
+
+	return 0;
 }
 
 int nvgpu_cond_signal(struct nvgpu_cond *cond)
 {
-	return -ENOSYS;
+	if (cond == NULL || !cond->initialized) {
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&cond->mutex);
+	pthread_cond_signal(&cond->cond);
+	pthread_mutex_unlock(&cond->mutex);
+
+	return 0;
 }
 
 int nvgpu_cond_signal_interruptible(struct nvgpu_cond *cond)
 {
-	return -ENOSYS;
+	return nvgpu_cond_signal(cond);
 }
 
 int nvgpu_cond_broadcast(struct nvgpu_cond *cond)
 {
-	return -ENOSYS;
+	if (cond == NULL || !cond->initialized) {
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&cond->mutex);
+	pthread_cond_broadcast(&cond->cond);
+	pthread_mutex_unlock(&cond->mutex);
+
+	return 0;
 }
 
 int nvgpu_cond_broadcast_interruptible(struct nvgpu_cond *cond)
 {
-	return -ENOSYS;
+	return nvgpu_cond_broadcast(cond);
 }
 
 void nvgpu_cond_destroy(struct nvgpu_cond *cond)
 {
+	if (!cond->initialized) {
+		return;
+	}
 
+	(void) pthread_cond_destroy(&cond->cond);
+	(void) pthread_mutex_destroy(&cond->mutex);
+	cond->initialized = false;
 }
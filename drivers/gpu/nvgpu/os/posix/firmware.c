@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -21,15 +21,30 @@
  */
 
 #include <nvgpu/firmware.h>
+#include <nvgpu/kmem.h>
 
+/*
+ * There is no filesystem to load from; only images already placed in the
+ * firmware cache can be returned.
+ */
 struct nvgpu_firmware *nvgpu_request_firmware(struct gk20a *g,
 					      const char *fw_name,
 					      int flags)
 {
-	return NULL;
+	if (fw_name == NULL ||
+	    (flags & NVGPU_REQUEST_FIRMWARE_CACHE) == 0) {
+		return NULL;
+	}
+
+	return nvgpu_firmware_cache_get(g, fw_name);
 }
 
 void nvgpu_release_firmware(struct gk20a *g, struct nvgpu_firmware *fw)
 {
-	/* Noop. */
+	if (fw == NULL) {
+		return;
+	}
+
+	nvgpu_kfree(g, fw->data);
+	nvgpu_kfree(g, fw);
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -20,6 +20,8 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdio.h>
+
 #include <nvgpu/io.h>
 #include <nvgpu/io_usermode.h>
 #include <nvgpu/bug.h>
@@ -67,7 +69,17 @@ void nvgpu_writel(struct gk20a *g, u32 r, u32 v)
 
 void nvgpu_writel_relaxed(struct gk20a *g, u32 r, u32 v)
 {
-	BUG();
+	nvgpu_writel(g, r, v);
+}
+
+void nvgpu_writel_stream(struct gk20a *g, const u32 *stream, u32 count,
+		u32 stride, u32 value_idx)
+{
+	u32 i;
+
+	for (i = 0; i < count; i++, stream += stride) {
+		nvgpu_writel(g, stream[0], stream[value_idx]);
+	}
 }
 
 u32 nvgpu_readl(struct gk20a *g, u32 r)
@@ -176,14 +188,30 @@ bool nvgpu_io_valid_reg(struct gk20a *g, u32 r)
 	return false;
 }
 
+static void nvgpu_posix_io_free_reg_spaces(struct gk20a *g)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	u32 i;
+
+	for (i = 0; i < p->nr_reg_spaces; i++) {
+		nvgpu_vfree(g, p->reg_spaces[i]->data);
+		nvgpu_kfree(g, p->reg_spaces[i]);
+	}
+	nvgpu_kfree(g, p->reg_spaces);
+
+	p->reg_spaces = NULL;
+	p->nr_reg_spaces = 0;
+	p->max_reg_spaces = 0;
+	p->last_reg_space = NULL;
+}
+
 void nvgpu_posix_io_init_reg_space(struct gk20a *g)
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
 
-	p->recording = false;
 	p->error_code = 0;
-	nvgpu_init_list_node(&p->reg_space_head);
-	nvgpu_init_list_node(&p->recorder_head);
+	nvgpu_posix_io_free_reg_spaces(g);
+	nvgpu_posix_io_reset_recorder(g);
 }
 
 int nvgpu_posix_io_get_error_code(struct gk20a *g)
@@ -201,15 +229,101 @@ void nvgpu_posix_io_reset_error_code(struct gk20a *g)
 }
 
 /*
- * Add a new register space to the list of spaces, defined by a base
- * address and a size.
+ * Return the index of the first register space whose base is above @addr.
+ * The space that could contain @addr, if any, is the one just before it.
+ */
+static u32 nvgpu_posix_io_reg_space_upper_bound(struct nvgpu_os_posix *p,
+		u32 addr)
+{
+	u32 lo = 0, hi = p->nr_reg_spaces;
+
+	while (lo < hi) {
+		u32 mid = lo + ((hi - lo) / 2U);
+
+		if (p->reg_spaces[mid]->base <= addr) {
+			lo = mid + 1U;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static inline bool nvgpu_posix_io_reg_space_contains(
+		struct nvgpu_posix_io_reg_space *space, u32 addr)
+{
+	return (addr >= space->base) && ((addr - space->base) < space->size);
+}
+
+/*
+ * Find the index of the register space containing @addr. Returns false if
+ * there is none; unlike nvgpu_posix_io_get_reg_space() this is not an error.
+ */
+static bool nvgpu_posix_io_find_reg_space(struct nvgpu_os_posix *p, u32 addr,
+		u32 *idx)
+{
+	u32 i = nvgpu_posix_io_reg_space_upper_bound(p, addr);
+
+	if ((i == 0U) ||
+	    !nvgpu_posix_io_reg_space_contains(p->reg_spaces[i - 1U], addr)) {
+		return false;
+	}
+
+	*idx = i - 1U;
+	return true;
+}
+
+static int nvgpu_posix_io_grow_reg_spaces(struct gk20a *g)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	struct nvgpu_posix_io_reg_space **spaces;
+	u32 max = (p->max_reg_spaces == 0U) ? 8U : (p->max_reg_spaces * 2U);
+
+	spaces = nvgpu_kcalloc(g, max, sizeof(*spaces));
+	if (spaces == NULL) {
+		return -ENOMEM;
+	}
+
+	if (p->nr_reg_spaces != 0U) {
+		(void) memcpy(spaces, p->reg_spaces,
+			p->nr_reg_spaces * sizeof(*spaces));
+	}
+	nvgpu_kfree(g, p->reg_spaces);
+
+	p->reg_spaces = spaces;
+	p->max_reg_spaces = max;
+	return 0;
+}
+
+/*
+ * Add a new register space to the set of spaces, defined by a base
+ * address and a size. Spaces may not overlap.
  */
 int nvgpu_posix_io_add_reg_space(struct gk20a *g, u32 base, u32 size)
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
-	struct nvgpu_posix_io_reg_space *new_reg_space =
-		nvgpu_kzalloc(g, sizeof(struct nvgpu_posix_io_reg_space));
+	struct nvgpu_posix_io_reg_space *new_reg_space;
+	u32 i;
+
+	if ((size == 0U) || ((base + size - 1U) < base)) {
+		return -EINVAL;
+	}
+
+	i = nvgpu_posix_io_reg_space_upper_bound(p, base);
+	if (((i > 0U) && nvgpu_posix_io_reg_space_contains(
+			p->reg_spaces[i - 1U], base)) ||
+	    ((i < p->nr_reg_spaces) &&
+	     (p->reg_spaces[i]->base <= (base + size - 1U)))) {
+		return -EINVAL;
+	}
 
+	if ((p->nr_reg_spaces == p->max_reg_spaces) &&
+	    (nvgpu_posix_io_grow_reg_spaces(g) != 0)) {
+		return -ENOMEM;
+	}
+
+	new_reg_space = nvgpu_kzalloc(g, sizeof(struct nvgpu_posix_io_reg_space));
 	if (new_reg_space == NULL) {
 		return -ENOMEM;
 	}
@@ -219,22 +333,38 @@ int nvgpu_posix_io_add_reg_space(struct gk20a *g, u32 base, u32 size)
 
 	new_reg_space->data = nvgpu_vzalloc(g, size);
 	if (new_reg_space->data == NULL) {
+		nvgpu_kfree(g, new_reg_space);
 		return -ENOMEM;
 	}
 
-	nvgpu_list_add_tail(&new_reg_space->link, &p->reg_space_head);
+	(void) memmove(&p->reg_spaces[i + 1U], &p->reg_spaces[i],
+		(p->nr_reg_spaces - i) * sizeof(*p->reg_spaces));
+	p->reg_spaces[i] = new_reg_space;
+	p->nr_reg_spaces++;
+
 	return 0;
 }
 
 void nvgpu_posix_io_delete_reg_space(struct gk20a *g, u32 base)
 {
-	struct nvgpu_posix_io_reg_space *reg_space =
-		nvgpu_posix_io_get_reg_space(g, base);
-	if (reg_space == NULL) {
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	struct nvgpu_posix_io_reg_space *reg_space;
+	u32 i;
+
+	if (!nvgpu_posix_io_find_reg_space(p, base, &i)) {
 		/* Invalid space, or already de-allocated */
 		return;
 	}
-	nvgpu_list_del(&reg_space->link);
+
+	reg_space = p->reg_spaces[i];
+	(void) memmove(&p->reg_spaces[i], &p->reg_spaces[i + 1U],
+		(p->nr_reg_spaces - i - 1U) * sizeof(*p->reg_spaces));
+	p->nr_reg_spaces--;
+
+	if (p->last_reg_space == reg_space) {
+		p->last_reg_space = NULL;
+	}
+
 	nvgpu_vfree(g, reg_space->data);
 	nvgpu_kfree(g, reg_space);
 }
@@ -247,16 +377,18 @@ struct nvgpu_posix_io_reg_space *nvgpu_posix_io_get_reg_space(struct gk20a *g,
 		u32 addr)
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
-	struct nvgpu_posix_io_reg_space *reg_space;
+	u32 i;
 
-	nvgpu_list_for_each_entry(reg_space, &p->reg_space_head,
-			nvgpu_posix_io_reg_space, link) {
-		u32 offset = addr - reg_space->base;
+	if ((p->last_reg_space != NULL) &&
+	    nvgpu_posix_io_reg_space_contains(p->last_reg_space, addr)) {
+		return p->last_reg_space;
+	}
 
-		if ((addr >= reg_space->base) && (offset <= reg_space->size)) {
-			return reg_space;
-		}
+	if (nvgpu_posix_io_find_reg_space(p, addr, &i)) {
+		p->last_reg_space = p->reg_spaces[i];
+		return p->last_reg_space;
 	}
+
 	p->error_code = -EFAULT;
 	nvgpu_err(g, "ABORT for address 0x%x", addr);
 	return NULL;
@@ -288,39 +420,156 @@ u32 nvgpu_posix_io_readl_reg_space(struct gk20a *g, u32 addr)
 	}
 }
 
+#define NVGPU_POSIX_IO_RECORDER_MIN	1024U
+
 /*
  * Start recording register writes. If this function is called again,
- * it will free all previously recorded events.
+ * it will drop all previously recorded events.
  */
 void nvgpu_posix_io_start_recorder(struct gk20a *g)
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
-	struct nvgpu_posix_io_reg_access *ptr;
-
-	/* If list already has events, delete them all */
-	if (p->recording == true) {
-		while (!nvgpu_list_empty(&p->recorder_head)) {
-			ptr = nvgpu_list_first_entry(&p->recorder_head,
-				nvgpu_posix_io_reg_access, link);
-			nvgpu_list_del(&ptr->link);
-			nvgpu_kfree(g, ptr);
-		}
-	}
+
+	p->nr_recorded = 0;
 	p->recording = true;
 }
 
+/*
+ * Stop recording and release the recording buffer.
+ */
+void nvgpu_posix_io_reset_recorder(struct gk20a *g)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+
+	nvgpu_vfree(g, p->recorder);
+	p->recorder = NULL;
+	p->nr_recorded = 0;
+	p->max_recorded = 0;
+	p->recorder_filter_base = 0;
+	p->recorder_filter_size = 0;
+	p->recording = false;
+}
+
+/*
+ * Number of accesses recorded since the recorder was last started.
+ */
+u32 nvgpu_posix_io_get_recorded_count(struct gk20a *g)
+{
+	return nvgpu_os_posix_from_gk20a(g)->nr_recorded;
+}
+
+/*
+ * Only record accesses within [base, base + size). A size of 0 records
+ * everything.
+ */
+void nvgpu_posix_io_set_recorder_filter(struct gk20a *g, u32 base, u32 size)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+
+	p->recorder_filter_base = base;
+	p->recorder_filter_size = size;
+}
+
+static int nvgpu_posix_io_grow_recorder(struct gk20a *g)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	struct nvgpu_reg_access *recorder;
+	u32 max = (p->max_recorded == 0U) ?
+		NVGPU_POSIX_IO_RECORDER_MIN : (p->max_recorded * 2U);
+
+	recorder = nvgpu_vmalloc(g, max * sizeof(*recorder));
+	if (recorder == NULL) {
+		return -ENOMEM;
+	}
+
+	if (p->nr_recorded != 0U) {
+		(void) memcpy(recorder, p->recorder,
+			p->nr_recorded * sizeof(*recorder));
+	}
+	nvgpu_vfree(g, p->recorder);
+
+	p->recorder = recorder;
+	p->max_recorded = max;
+	return 0;
+}
+
 void nvgpu_posix_io_record_access(struct gk20a *g,
 		struct nvgpu_reg_access *access)
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
 
-	if (p->recording == true) {
-		struct nvgpu_posix_io_reg_access *new_event = nvgpu_kzalloc(g,
-			sizeof(struct nvgpu_posix_io_reg_access));
-		(void) memcpy(&(new_event->access), access,
-			sizeof(struct nvgpu_reg_access));
-		nvgpu_list_add_tail(&new_event->link, &p->recorder_head);
+	if (p->recording == false) {
+		return;
+	}
+
+	if ((p->recorder_filter_size != 0U) &&
+	    ((access->addr < p->recorder_filter_base) ||
+	     ((access->addr - p->recorder_filter_base) >=
+	      p->recorder_filter_size))) {
+		return;
+	}
+
+	if ((p->nr_recorded == p->max_recorded) &&
+	    (nvgpu_posix_io_grow_recorder(g) != 0)) {
+		p->error_code = -ENOMEM;
+		return;
+	}
+
+	p->recorder[p->nr_recorded++] = *access;
+}
+
+/*
+ * Walk the recording and match it against the expected accesses handed out by
+ * @next. In strict mode every recorded access must be the next expected one;
+ * otherwise extra accesses may be interleaved. Either way all expected
+ * accesses must be seen, in order.
+ */
+static bool nvgpu_posix_io_match_recording(struct nvgpu_os_posix *p,
+		bool (*next)(void *ctx, struct nvgpu_reg_access *expected),
+		void *ctx, bool strict)
+{
+	struct nvgpu_reg_access expected;
+	bool have_expected;
+	u32 i;
+
+	if (p->recording == false) {
+		return false;
+	}
+
+	have_expected = next(ctx, &expected);
+
+	for (i = 0; i < p->nr_recorded; i++) {
+		struct nvgpu_reg_access *rec = &p->recorder[i];
+
+		if (have_expected && (rec->addr == expected.addr) &&
+		    (rec->value == expected.value)) {
+			have_expected = next(ctx, &expected);
+		} else if (strict) {
+			return false;
+		}
+	}
+
+	/* Anything left over in the expected sequence is a missing access. */
+	return !have_expected;
+}
+
+struct nvgpu_posix_io_seq_iter {
+	struct nvgpu_reg_access *sequence;
+	u32 size;
+	u32 i;
+};
+
+static bool nvgpu_posix_io_seq_next(void *ctx,
+		struct nvgpu_reg_access *expected)
+{
+	struct nvgpu_posix_io_seq_iter *it = ctx;
+
+	if (it->i == it->size) {
+		return false;
 	}
+
+	*expected = it->sequence[it->i++];
+	return true;
 }
 
 /*
@@ -333,39 +582,162 @@ bool nvgpu_posix_io_check_sequence(struct gk20a *g,
 		struct nvgpu_reg_access *sequence, u32 size, bool strict)
 {
 	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
-	struct nvgpu_posix_io_reg_access *ptr;
-	u32 i = 0;
+	struct nvgpu_posix_io_seq_iter it = {
+		.sequence = sequence,
+		.size = size,
+		.i = 0,
+	};
 
-	if (p->recording == false) {
-		return false;
+	return nvgpu_posix_io_match_recording(p, nvgpu_posix_io_seq_next,
+			&it, strict);
+}
+
+/*
+ * Read the next access from a trace file. Returns 1 if an access was read, 0
+ * at end of file and -EINVAL on a malformed line.
+ */
+static int nvgpu_posix_io_read_access(FILE *f, struct nvgpu_reg_access *access)
+{
+	char line[128];
+
+	while (fgets(line, (int)sizeof(line), f) != NULL) {
+		unsigned int addr, value;
+		char *s = line;
+
+		while ((*s == ' ') || (*s == '\t')) {
+			s++;
+		}
+		if ((*s == '#') || (*s == '\n') || (*s == '\0')) {
+			continue;
+		}
+
+		if (sscanf(s, "%x %x", &addr, &value) != 2) {
+			return -EINVAL;
+		}
+
+		access->addr = addr;
+		access->value = value;
+		return 1;
 	}
 
-	nvgpu_list_for_each_entry(ptr, &p->recorder_head,
-			nvgpu_posix_io_reg_access, link) {
-		if ((sequence[i].addr == ptr->access.addr) &&
-			(sequence[i].value == ptr->access.value)) {
-			i++;
-		} else {
-			if (strict == true) {
-				return false;
+	return 0;
+}
+
+int nvgpu_posix_io_export_recording(struct gk20a *g, const char *path)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	FILE *f;
+	u32 i;
+	int err = 0;
+
+	f = fopen(path, "w");
+	if (f == NULL) {
+		return -EIO;
+	}
+
+	(void) fprintf(f, "# nvgpu register trace: %u accesses\n",
+		p->nr_recorded);
+	for (i = 0; i < p->nr_recorded; i++) {
+		if (fprintf(f, "0x%08x 0x%08x\n", p->recorder[i].addr,
+				p->recorder[i].value) < 0) {
+			err = -EIO;
+			break;
+		}
+	}
+
+	if (fclose(f) != 0) {
+		err = -EIO;
+	}
+
+	return err;
+}
+
+/*
+ * Load a trace file into a newly allocated array. The caller frees
+ * *sequence with nvgpu_vfree().
+ */
+int nvgpu_posix_io_import_sequence(struct gk20a *g, const char *path,
+		struct nvgpu_reg_access **sequence, u32 *size)
+{
+	struct nvgpu_reg_access *seq = NULL, *tmp;
+	struct nvgpu_reg_access access;
+	u32 nr = 0, max = 0;
+	FILE *f;
+	int ret;
+
+	f = fopen(path, "r");
+	if (f == NULL) {
+		return -EIO;
+	}
+
+	while ((ret = nvgpu_posix_io_read_access(f, &access)) == 1) {
+		if (nr == max) {
+			max = (max == 0U) ? NVGPU_POSIX_IO_RECORDER_MIN :
+				(max * 2U);
+			tmp = nvgpu_vmalloc(g, max * sizeof(*seq));
+			if (tmp == NULL) {
+				ret = -ENOMEM;
+				break;
+			}
+			if (nr != 0U) {
+				(void) memcpy(tmp, seq, nr * sizeof(*seq));
 			}
+			nvgpu_vfree(g, seq);
+			seq = tmp;
 		}
+		seq[nr++] = access;
 	}
 
-	if (i != size) {
-		/* Either missing or too many accesses */
-		return false;
+	(void) fclose(f);
+
+	if (ret != 0) {
+		nvgpu_vfree(g, seq);
+		return ret;
 	}
 
-	if (&ptr->link == &p->recorder_head) {
-		/* Identical match */
-		return true;
+	*sequence = seq;
+	*size = nr;
+	return 0;
+}
+
+struct nvgpu_posix_io_file_iter {
+	FILE *f;
+	int err;
+};
+
+static bool nvgpu_posix_io_file_next(void *ctx,
+		struct nvgpu_reg_access *expected)
+{
+	struct nvgpu_posix_io_file_iter *it = ctx;
+	int ret = nvgpu_posix_io_read_access(it->f, expected);
+
+	if (ret < 0) {
+		it->err = ret;
 	}
 
-	/* Not an identical match */
-	if (strict) {
+	return ret == 1;
+}
+
+/*
+ * Like nvgpu_posix_io_check_sequence() but the expected sequence is streamed
+ * from a trace file, so arbitrarily long traces can be checked without
+ * loading them first.
+ */
+bool nvgpu_posix_io_check_sequence_file(struct gk20a *g, const char *path,
+		bool strict)
+{
+	struct nvgpu_os_posix *p = nvgpu_os_posix_from_gk20a(g);
+	struct nvgpu_posix_io_file_iter it = { .f = NULL, .err = 0 };
+	bool match;
+
+	it.f = fopen(path, "r");
+	if (it.f == NULL) {
 		return false;
-	} else {
-		return true;
 	}
+
+	match = nvgpu_posix_io_match_recording(p, nvgpu_posix_io_file_next,
+			&it, strict);
+	(void) fclose(it.f);
+
+	return match && (it.err == 0);
 }
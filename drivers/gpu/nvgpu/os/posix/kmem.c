@@ -21,47 +21,179 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <nvgpu/bug.h>
 #include <nvgpu/kmem.h>
+#include <nvgpu/lock.h>
 #include <nvgpu/types.h>
 
 #include <nvgpu/posix/kmem.h>
 
-struct nvgpu_kmem_cache {
-	size_t alloc_size;
+/*
+ * Objects are carved out of chunks of this many bytes (or a single object if
+ * the object is bigger than this).
+ */
+#define NVGPU_KMEM_CACHE_CHUNK_SIZE	(64U * 1024U)
+#define NVGPU_KMEM_CACHE_ALIGN		16U
+
+struct nvgpu_kmem_cache_chunk {
+	struct nvgpu_kmem_cache_chunk *next;
+	/* Keep the objects that follow aligned. */
+	u8 pad[NVGPU_KMEM_CACHE_ALIGN - sizeof(void *)];
 };
 
 /*
- * kmem cache emulation: basically just do a regular malloc(). This is slower
- * but should not affect a user of kmem cache in the slightest bit.
+ * Free objects are threaded onto the free list through their first word.
  */
+struct nvgpu_kmem_cache_obj {
+	struct nvgpu_kmem_cache_obj *next;
+};
+
+/*
+ * Simple slab-style cache: fixed size objects are handed out from a free list
+ * which is refilled a whole chunk at a time. Chunks are only returned to the
+ * system when the cache is destroyed, just like an idle kernel slab.
+ */
+struct nvgpu_kmem_cache {
+	struct gk20a *g;
+	size_t alloc_size;
+	size_t obj_size;
+	u32 objs_per_chunk;
+
+	struct nvgpu_mutex lock;
+	struct nvgpu_kmem_cache_chunk *chunks;
+	struct nvgpu_kmem_cache_obj *free_list;
+
+	struct nvgpu_posix_kmem_cache_stats stats;
+};
+
 struct nvgpu_kmem_cache *nvgpu_kmem_cache_create(struct gk20a *g, size_t size)
 {
 	struct nvgpu_kmem_cache *cache =
-		malloc(sizeof(struct nvgpu_kmem_cache));
+		calloc(1, sizeof(struct nvgpu_kmem_cache));
 
-	if (cache != NULL)
+	if (cache == NULL)
 		return NULL;
 
+	cache->g = g;
 	cache->alloc_size = size;
+	cache->obj_size = ALIGN(max(size, sizeof(struct nvgpu_kmem_cache_obj)),
+				NVGPU_KMEM_CACHE_ALIGN);
+	cache->objs_per_chunk = (u32)max((size_t)1U,
+		(NVGPU_KMEM_CACHE_CHUNK_SIZE -
+		 sizeof(struct nvgpu_kmem_cache_chunk)) / cache->obj_size);
+
+	nvgpu_mutex_init(&cache->lock);
+
+	cache->stats.obj_size = cache->obj_size;
+	cache->stats.objs_per_chunk = cache->objs_per_chunk;
 
 	return cache;
 }
 
 void nvgpu_kmem_cache_destroy(struct nvgpu_kmem_cache *cache)
 {
+	struct nvgpu_kmem_cache_chunk *chunk, *next;
+
+	if (cache == NULL)
+		return;
+
+	for (chunk = cache->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+
+	nvgpu_mutex_destroy(&cache->lock);
 	free(cache);
 }
 
+/*
+ * Must be called with the cache lock held.
+ */
+static int nvgpu_kmem_cache_grow(struct nvgpu_kmem_cache *cache)
+{
+	struct nvgpu_kmem_cache_chunk *chunk;
+	u8 *objs;
+	u32 i;
+
+	chunk = malloc(sizeof(*chunk) +
+		       (size_t)cache->objs_per_chunk * cache->obj_size);
+	if (chunk == NULL)
+		return -ENOMEM;
+
+	chunk->next = cache->chunks;
+	cache->chunks = chunk;
+
+	/*
+	 * Push the objects in reverse so that the free list hands them out in
+	 * address order.
+	 */
+	objs = (u8 *)(chunk + 1);
+	for (i = cache->objs_per_chunk; i > 0U; i--) {
+		struct nvgpu_kmem_cache_obj *obj = (struct nvgpu_kmem_cache_obj *)
+			(objs + (size_t)(i - 1U) * cache->obj_size);
+
+		obj->next = cache->free_list;
+		cache->free_list = obj;
+	}
+
+	cache->stats.nr_chunks++;
+
+	return 0;
+}
+
 void *nvgpu_kmem_cache_alloc(struct nvgpu_kmem_cache *cache)
 {
-	return malloc(cache->alloc_size);
+	struct nvgpu_kmem_cache_obj *obj;
+
+	nvgpu_mutex_acquire(&cache->lock);
+
+	if (cache->free_list == NULL &&
+	    nvgpu_kmem_cache_grow(cache) != 0) {
+		nvgpu_mutex_release(&cache->lock);
+		return NULL;
+	}
+
+	obj = cache->free_list;
+	cache->free_list = obj->next;
+
+	cache->stats.nr_allocs++;
+	cache->stats.objs_active++;
+	if (cache->stats.objs_active > cache->stats.objs_peak)
+		cache->stats.objs_peak = cache->stats.objs_active;
+
+	nvgpu_mutex_release(&cache->lock);
+
+	return obj;
 }
 
 void nvgpu_kmem_cache_free(struct nvgpu_kmem_cache *cache, void *ptr)
 {
-	free(ptr);
+	struct nvgpu_kmem_cache_obj *obj = ptr;
+
+	if (ptr == NULL)
+		return;
+
+	nvgpu_mutex_acquire(&cache->lock);
+
+	BUG_ON(cache->stats.objs_active == 0ULL);
+
+	obj->next = cache->free_list;
+	cache->free_list = obj;
+
+	cache->stats.nr_frees++;
+	cache->stats.objs_active--;
+
+	nvgpu_mutex_release(&cache->lock);
+}
+
+void nvgpu_posix_kmem_cache_get_stats(struct nvgpu_kmem_cache *cache,
+				      struct nvgpu_posix_kmem_cache_stats *stats)
+{
+	nvgpu_mutex_acquire(&cache->lock);
+	*stats = cache->stats;
+	nvgpu_mutex_release(&cache->lock);
 }
 
 void *__nvgpu_kmalloc(struct gk20a *g, size_t size, void *ip)
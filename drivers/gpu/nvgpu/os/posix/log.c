@@ -60,6 +60,11 @@ static void __nvgpu_really_print_log(const char *gpu_name,
 	printf(LOG_FMT, name, func_name, line, log_type, log);
 }
 
+int nvgpu_log_mask_enabled(struct gk20a *g, u64 log_mask)
+{
+	return !!(g->log_mask & log_mask);
+}
+
 __attribute__((format (printf, 5, 6)))
 void __nvgpu_log_msg(struct gk20a *g, const char *func_name, int line,
 		     enum nvgpu_log_type type, const char *fmt, ...)
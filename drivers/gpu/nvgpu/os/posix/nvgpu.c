@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -125,7 +125,7 @@ struct gk20a *nvgpu_posix_probe(void)
 	struct nvgpu_os_posix *p;
 	int err;
 
-	p = malloc(sizeof(*p));
+	p = calloc(1, sizeof(*p));
 	if (p == NULL)
 		return NULL;
 
@@ -135,6 +135,8 @@ struct gk20a *nvgpu_posix_probe(void)
 	if (err != 0)
 		goto fail;
 
+	nvgpu_firmware_cache_init(g);
+
 	return g;
 
 fail:
@@ -145,5 +147,6 @@ fail:
 
 void nvgpu_posix_cleanup(struct gk20a *g)
 {
+	nvgpu_firmware_cache_deinit(g);
 	nvgpu_kmem_fini(g, 0);
 }
@@ -26,6 +26,8 @@
 #include <nvgpu/gk20a.h>
 
 struct nvgpu_posix_io_callbacks;
+struct nvgpu_posix_io_reg_space;
+struct nvgpu_reg_access;
 
 struct nvgpu_os_posix {
 	struct gk20a g;
@@ -37,16 +39,26 @@ struct nvgpu_os_posix {
 	struct nvgpu_posix_io_callbacks *callbacks;
 
 	/*
-	 * Memory-mapped register space for unit tests.
+	 * Memory-mapped register space for unit tests. Kept sorted by base
+	 * address so lookups can bisect; last_reg_space caches the most
+	 * recent hit since accesses tend to stay within one unit.
 	 */
-	struct nvgpu_list_node reg_space_head;
+	struct nvgpu_posix_io_reg_space **reg_spaces;
+	u32 nr_reg_spaces;
+	u32 max_reg_spaces;
+	struct nvgpu_posix_io_reg_space *last_reg_space;
 	int error_code;
 
 
 	/*
-	 * List to record sequence of register writes.
+	 * Recorded sequence of register accesses. The array only ever grows
+	 * so restarting the recorder doesn't have to allocate again.
 	 */
-	struct nvgpu_list_node recorder_head;
+	struct nvgpu_reg_access *recorder;
+	u32 nr_recorded;
+	u32 max_recorded;
+	u32 recorder_filter_base;
+	u32 recorder_filter_size;
 	bool recording;
 };
 
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <nvgpu/types.h>
+#include <nvgpu/sort.h>
+
+/*
+ * Introsort: quicksort with a median of three pivot, falling back to heapsort
+ * if the recursion gets too deep and to insertion sort for short runs. Every
+ * element move goes through the swap callback so that callers passing their
+ * own swap (to keep side tables in sync, say) see the same behavior as with
+ * the kernel's sort().
+ */
+
+#define SORT_INSERTION_THRESHOLD	16U
+
+typedef int (*sort_cmp_func_t)(const void *, const void *);
+typedef void (*sort_swap_func_t)(void *, void *, int);
+
+struct sort_ctx {
+	char *base;
+	size_t size;
+	sort_cmp_func_t cmp;
+	sort_swap_func_t swap;
+};
+
+static void sort_swap_u32(void *a, void *b, int size)
+{
+	u32 t = *(u32 *)a;
+
+	*(u32 *)a = *(u32 *)b;
+	*(u32 *)b = t;
+}
+
+static void sort_swap_u64(void *a, void *b, int size)
+{
+	u64 t = *(u64 *)a;
+
+	*(u64 *)a = *(u64 *)b;
+	*(u64 *)b = t;
+}
+
+static void sort_swap_bytes(void *a, void *b, int size)
+{
+	char *x = a, *y = b;
+
+	while (size-- > 0) {
+		char t = *x;
+
+		*x++ = *y;
+		*y++ = t;
+	}
+}
+
+static inline void *sort_elem(struct sort_ctx *c, size_t i)
+{
+	return c->base + (i * c->size);
+}
+
+static inline int sort_cmp(struct sort_ctx *c, size_t a, size_t b)
+{
+	return c->cmp(sort_elem(c, a), sort_elem(c, b));
+}
+
+static inline void sort_swap(struct sort_ctx *c, size_t a, size_t b)
+{
+	c->swap(sort_elem(c, a), sort_elem(c, b), (int)c->size);
+}
+
+static void sort_insertion(struct sort_ctx *c, size_t num)
+{
+	size_t i, j;
+
+	for (i = 1; i < num; i++) {
+		for (j = i; j > 0 && sort_cmp(c, j - 1, j) > 0; j--) {
+			sort_swap(c, j - 1, j);
+		}
+	}
+}
+
+static void sort_sift_down(struct sort_ctx *c, size_t root, size_t num)
+{
+	for (;;) {
+		size_t child = (2 * root) + 1;
+
+		if (child >= num) {
+			break;
+		}
+		if ((child + 1 < num) && (sort_cmp(c, child, child + 1) < 0)) {
+			child++;
+		}
+		if (sort_cmp(c, root, child) >= 0) {
+			break;
+		}
+
+		sort_swap(c, root, child);
+		root = child;
+	}
+}
+
+static void sort_heap(struct sort_ctx *c, size_t num)
+{
+	size_t i;
+
+	for (i = num / 2; i-- > 0;) {
+		sort_sift_down(c, i, num);
+	}
+
+	for (i = num - 1; i > 0; i--) {
+		sort_swap(c, 0, i);
+		sort_sift_down(c, 0, i);
+	}
+}
+
+/*
+ * Partition around the median of the first, middle and last elements. The
+ * pivot is parked in slot 0 and the last element is known to be >= the pivot,
+ * so neither scan needs a bounds check. Returns the pivot's final index.
+ */
+static size_t sort_partition(struct sort_ctx *c, size_t num)
+{
+	size_t mid = num / 2, last = num - 1;
+	size_t i = 1, j = last;
+
+	if (sort_cmp(c, mid, 0) < 0) {
+		sort_swap(c, mid, 0);
+	}
+	if (sort_cmp(c, last, 0) < 0) {
+		sort_swap(c, last, 0);
+	}
+	if (sort_cmp(c, last, mid) < 0) {
+		sort_swap(c, last, mid);
+	}
+	sort_swap(c, 0, mid);
+
+	for (;;) {
+		while (sort_cmp(c, i, 0) < 0) {
+			i++;
+		}
+		while (sort_cmp(c, 0, j) < 0) {
+			j--;
+		}
+		if (i >= j) {
+			break;
+		}
+		sort_swap(c, i, j);
+		i++;
+		j--;
+	}
+
+	sort_swap(c, 0, j);
+
+	return j;
+}
+
+static void sort_intro(struct sort_ctx *c, size_t num, u32 depth)
+{
+	while (num > SORT_INSERTION_THRESHOLD) {
+		char *base = c->base;
+		size_t p;
+
+		if (depth == 0U) {
+			sort_heap(c, num);
+			return;
+		}
+		depth--;
+
+		p = sort_partition(c, num);
+
+		/* Recurse on the smaller side to bound the stack depth. */
+		if (p < num - p - 1) {
+			sort_intro(c, p, depth);
+			c->base = base + ((p + 1) * c->size);
+			num = num - p - 1;
+		} else {
+			c->base = base + ((p + 1) * c->size);
+			sort_intro(c, num - p - 1, depth);
+			c->base = base;
+			num = p;
+		}
+	}
+
+	sort_insertion(c, num);
+}
+
+void sort(void *base, size_t num, size_t size,
+	  int (*cmp)(const void *, const void *),
+	  void (*swap)(void *, void *, int))
+{
+	struct sort_ctx c = {
+		.base = base,
+		.size = size,
+		.cmp = cmp,
+		.swap = swap,
+	};
+	u32 depth = 0;
+	size_t n;
+
+	if (num < 2 || size == 0) {
+		return;
+	}
+
+	if (c.swap == NULL) {
+		if (size == sizeof(u32) &&
+		    ((uintptr_t)base % sizeof(u32)) == 0) {
+			c.swap = sort_swap_u32;
+		} else if (size == sizeof(u64) &&
+			   ((uintptr_t)base % sizeof(u64)) == 0) {
+			c.swap = sort_swap_u64;
+		} else {
+			c.swap = sort_swap_bytes;
+		}
+	}
+
+	for (n = num; n > 1; n >>= 1) {
+		depth += 2U;
+	}
+
+	sort_intro(&c, num, depth);
+}
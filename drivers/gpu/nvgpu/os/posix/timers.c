@@ -21,6 +21,7 @@
  */
 
 #include <sys/time.h>
+#include <time.h>
 
 #include <nvgpu/bug.h>
 #include <nvgpu/log.h>
@@ -163,6 +164,16 @@ s64 nvgpu_current_time_ms(void)
 	return __nvgpu_current_time_us() / (s64)1000;
 }
 
+s64 nvgpu_current_time_ns(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		BUG();
+
+	return ((s64)ts.tv_sec * (s64)1000000000) + (s64)ts.tv_nsec;
+}
+
 u64 nvgpu_hr_timestamp(void)
 {
 	return __nvgpu_current_time_us();
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/types.h>
+#include <nvgpu/kmem.h>
+#include <nvgpu/clk_arb.h>
+#include <nvgpu/gk20a.h>
+
+static struct nvgpu_clk_arb_agg test_agg;
+
+static int expect_max(struct unit_module *m, u16 gpc2clk, u16 mclk)
+{
+	u16 got_gpc2clk, got_mclk;
+
+	nvgpu_clk_arb_agg_max(&test_agg, &got_gpc2clk, &got_mclk);
+	if (got_gpc2clk != gpc2clk || got_mclk != mclk) {
+		unit_err(m, "max %u/%u expected %u/%u\n",
+			 got_gpc2clk, got_mclk, gpc2clk, mclk);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int test_agg_max(struct unit_module *m, struct gk20a *g, void *args)
+{
+	u32 a, b, c;
+	int fails = 0;
+
+	if (nvgpu_clk_arb_agg_init(g, &test_agg) != 0) {
+		unit_return_fail(m, "init failed\n");
+	}
+
+	if (nvgpu_clk_arb_agg_alloc_slot(g, &test_agg, &a) != 0 ||
+	    nvgpu_clk_arb_agg_alloc_slot(g, &test_agg, &b) != 0 ||
+	    nvgpu_clk_arb_agg_alloc_slot(g, &test_agg, &c) != 0 ||
+	    a == b || b == c || a == c) {
+		nvgpu_clk_arb_agg_deinit(g, &test_agg);
+		unit_return_fail(m, "slot allocation failed\n");
+	}
+
+	fails += expect_max(m, 0, 0);
+
+	if (!nvgpu_clk_arb_agg_set(&test_agg, a, 1000, 3000)) {
+		fails++;
+	}
+	/* below the current max in both domains */
+	if (nvgpu_clk_arb_agg_set(&test_agg, b, 800, 2000)) {
+		fails++;
+	}
+	if (!nvgpu_clk_arb_agg_set(&test_agg, c, 1500, 1000)) {
+		fails++;
+	}
+	fails += expect_max(m, 1500, 3000);
+
+	/* dropping the holder of a max falls back to the next session */
+	nvgpu_clk_arb_agg_free_slot(&test_agg, c);
+	fails += expect_max(m, 1000, 3000);
+	if (!nvgpu_clk_arb_agg_set(&test_agg, a, 0, 0)) {
+		fails++;
+	}
+	fails += expect_max(m, 800, 2000);
+
+	nvgpu_clk_arb_agg_deinit(g, &test_agg);
+
+	if (fails != 0) {
+		unit_return_fail(m, "%d checks failed\n", fails);
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static int test_agg_grow(struct unit_module *m, struct gk20a *g, void *args)
+{
+	const u32 nr = 300;
+	u32 *slots;
+	u32 i;
+	int fails = 0;
+
+	slots = nvgpu_kcalloc(g, nr, sizeof(u32));
+	if (slots == NULL ||
+	    nvgpu_clk_arb_agg_init(g, &test_agg) != 0) {
+		nvgpu_kfree(g, slots);
+		unit_return_fail(m, "init failed\n");
+	}
+
+	for (i = 0; i < nr; i++) {
+		if (nvgpu_clk_arb_agg_alloc_slot(g, &test_agg,
+						 &slots[i]) != 0) {
+			fails++;
+			break;
+		}
+		nvgpu_clk_arb_agg_set(&test_agg, slots[i],
+				      (u16)(i + 1U), (u16)(nr - i));
+	}
+
+	if (fails == 0) {
+		if (test_agg.nr_slots < nr) {
+			unit_err(m, "tree did not grow: %u\n",
+				 test_agg.nr_slots);
+			fails++;
+		}
+		fails += expect_max(m, (u16)nr, (u16)nr);
+
+		/* targets set before a grow must survive it */
+		nvgpu_clk_arb_agg_free_slot(&test_agg, slots[0]);
+		fails += expect_max(m, (u16)nr, (u16)(nr - 1U));
+		nvgpu_clk_arb_agg_free_slot(&test_agg, slots[nr - 1U]);
+		fails += expect_max(m, (u16)(nr - 1U), (u16)(nr - 1U));
+	}
+
+	nvgpu_clk_arb_agg_deinit(g, &test_agg);
+	nvgpu_kfree(g, slots);
+
+	if (fails != 0) {
+		unit_return_fail(m, "%d checks failed\n", fails);
+	}
+
+	return UNIT_SUCCESS;
+}
+
+struct unit_module_test clk_arb_agg_tests[] = {
+	UNIT_TEST(max,		test_agg_max, NULL),
+	UNIT_TEST(grow,		test_agg_grow, NULL),
+};
+
+UNIT_MODULE(clk_arb_agg, clk_arb_agg_tests, UNIT_PRIO_NVGPU_TEST);
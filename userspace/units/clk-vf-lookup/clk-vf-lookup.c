@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/types.h>
+#include <nvgpu/gk20a.h>
+
+#include "clk/clk.h"
+
+static struct clk_vf_curve test_curve;
+
+/*
+ * Two CLK_PROG segments: 100..400 MHz and 500..700 MHz. The second segment
+ * has a zero voltage at its first point.
+ */
+static void build_curve(struct clk_vf_curve *curve)
+{
+	static const u16 mhz[] = { 100, 200, 200, 400, 500, 600, 700 };
+	static const u32 uv[] = { 600000, 650000, 660000, 700000,
+				  0, 800000, 850000 };
+	u32 i;
+
+	(void) memset(curve, 0, sizeof(*curve));
+	for (i = 0; i < ARRAY_SIZE(mhz); i++) {
+		curve->mhz[i] = mhz[i];
+		curve->uv[i] = uv[i];
+	}
+	curve->num_points = ARRAY_SIZE(mhz);
+	curve->seg_end[0] = 4;
+	curve->seg_end[1] = ARRAY_SIZE(mhz);
+	curve->num_segs = 2;
+	curve->valid = true;
+}
+
+static int expect_uv(struct unit_module *m, u16 mhz, int err, u32 uv)
+{
+	u32 got = 0;
+	int ret = clk_vf_curve_f_to_v(&test_curve, mhz, &got);
+
+	if (ret != err || (err == 0 && got != uv)) {
+		unit_err(m, "%u MHz: got %d/%u expected %d/%u\n",
+			 mhz, ret, got, err, uv);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int test_vf_lookup_f_to_v(struct unit_module *m, struct gk20a *g,
+				 void *args)
+{
+	int fails = 0;
+
+	build_curve(&test_curve);
+
+	/* lowest point at or above the request */
+	fails += expect_uv(m, 1, 0, 600000);
+	fails += expect_uv(m, 100, 0, 600000);
+	fails += expect_uv(m, 101, 0, 650000);
+	/* duplicate frequencies resolve to the first of them */
+	fails += expect_uv(m, 200, 0, 650000);
+	fails += expect_uv(m, 400, 0, 700000);
+
+	/* past the first segment the second one answers */
+	fails += expect_uv(m, 501, 0, 800000);
+	fails += expect_uv(m, 700, 0, 850000);
+	fails += expect_uv(m, 701, -EINVAL, 0);
+	fails += expect_uv(m, 0, -EINVAL, 0);
+
+	if (fails != 0) {
+		unit_return_fail(m, "%d lookups failed\n", fails);
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static int test_vf_lookup_zero_uv(struct unit_module *m, struct gk20a *g,
+				  void *args)
+{
+	build_curve(&test_curve);
+
+	/* 450 MHz lands on a point with no voltage, like the boardobj walk */
+	if (expect_uv(m, 450, -EINVAL, 0) != 0) {
+		unit_return_fail(m, "zero voltage accepted\n");
+	}
+
+	test_curve.valid = false;
+	if (expect_uv(m, 300, -EINVAL, 0) != 0) {
+		unit_return_fail(m, "invalid curve used\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+struct unit_module_test clk_vf_lookup_tests[] = {
+	UNIT_TEST(f_to_v,	test_vf_lookup_f_to_v, NULL),
+	UNIT_TEST(zero_uv,	test_vf_lookup_zero_uv, NULL),
+};
+
+UNIT_MODULE(clk_vf_lookup, clk_vf_lookup_tests, UNIT_PRIO_NVGPU_TEST);
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/types.h>
+#include <nvgpu/gk20a.h>
+#include <nvgpu/firmware.h>
+
+#define TEST_FW_NAME	"test_fw.bin"
+#define TEST_FW_SIZE	256U
+
+static u8 test_image[TEST_FW_SIZE];
+
+static int test_firmware_cache_hit(struct unit_module *m, struct gk20a *g,
+				   void *args)
+{
+	struct nvgpu_firmware src = {
+		.data = test_image,
+		.size = sizeof(test_image),
+	};
+	struct nvgpu_firmware *fw;
+	u32 hits = g->fw_cache.hits;
+	u32 misses = g->fw_cache.misses;
+	u32 i;
+
+	for (i = 0; i < TEST_FW_SIZE; i++) {
+		test_image[i] = (u8)i;
+	}
+
+	if (nvgpu_request_firmware(g, TEST_FW_NAME,
+			NVGPU_REQUEST_FIRMWARE_CACHE) != NULL) {
+		unit_return_fail(m, "hit on an empty cache\n");
+	}
+
+	if (nvgpu_firmware_cache_put(g, TEST_FW_NAME, &src) != 0) {
+		unit_return_fail(m, "put failed\n");
+	}
+
+	/* callers patch their copy; that must not leak into the cache */
+	fw = nvgpu_request_firmware(g, TEST_FW_NAME,
+			NVGPU_REQUEST_FIRMWARE_CACHE);
+	if (fw == NULL || fw->size != TEST_FW_SIZE ||
+	    memcmp(fw->data, test_image, TEST_FW_SIZE) != 0) {
+		unit_return_fail(m, "bad cached copy\n");
+	}
+	fw->data[0] ^= 0xffU;
+	nvgpu_release_firmware(g, fw);
+
+	fw = nvgpu_request_firmware(g, TEST_FW_NAME,
+			NVGPU_REQUEST_FIRMWARE_CACHE);
+	if (fw == NULL || memcmp(fw->data, test_image, TEST_FW_SIZE) != 0) {
+		unit_return_fail(m, "cached image was modified\n");
+	}
+	nvgpu_release_firmware(g, fw);
+
+	if (g->fw_cache.hits - hits != 2U ||
+	    g->fw_cache.misses - misses != 1U) {
+		unit_return_fail(m, "bad stats %u/%u\n",
+				 g->fw_cache.hits - hits,
+				 g->fw_cache.misses - misses);
+	}
+
+	if (nvgpu_firmware_cache_release(g) != TEST_FW_SIZE) {
+		unit_return_fail(m, "release freed the wrong size\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static int test_firmware_cache_validate(struct unit_module *m,
+					struct gk20a *g, void *args)
+{
+	struct nvgpu_firmware src = {
+		.data = test_image,
+		.size = sizeof(test_image),
+	};
+	struct nvgpu_firmware_cache_entry *entry;
+
+	if (nvgpu_firmware_cache_put(g, TEST_FW_NAME, &src) != 0) {
+		unit_return_fail(m, "put failed\n");
+	}
+
+	entry = nvgpu_list_first_entry(&g->fw_cache.entries,
+			nvgpu_firmware_cache_entry, list);
+	entry->data[TEST_FW_SIZE - 1U] ^= 0x1U;
+
+	if (nvgpu_firmware_cache_get(g, TEST_FW_NAME) != NULL) {
+		unit_return_fail(m, "corrupted image served\n");
+	}
+
+	if (!nvgpu_list_empty(&g->fw_cache.entries) ||
+	    g->fw_cache.bytes != 0U) {
+		unit_return_fail(m, "corrupted entry not dropped\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static int test_firmware_cache_replace(struct unit_module *m,
+				       struct gk20a *g, void *args)
+{
+	struct nvgpu_firmware src = {
+		.data = test_image,
+		.size = sizeof(test_image),
+	};
+	struct nvgpu_firmware *fw;
+
+	if (nvgpu_firmware_cache_put(g, TEST_FW_NAME, &src) != 0) {
+		unit_return_fail(m, "put failed\n");
+	}
+
+	src.size = TEST_FW_SIZE / 2U;
+	if (nvgpu_firmware_cache_put(g, TEST_FW_NAME, &src) != 0) {
+		unit_return_fail(m, "second put failed\n");
+	}
+
+	if (g->fw_cache.bytes != TEST_FW_SIZE / 2U) {
+		unit_return_fail(m, "old entry not replaced\n");
+	}
+
+	fw = nvgpu_firmware_cache_get(g, TEST_FW_NAME);
+	if (fw == NULL || fw->size != TEST_FW_SIZE / 2U) {
+		unit_return_fail(m, "got the old entry\n");
+	}
+	nvgpu_release_firmware(g, fw);
+
+	nvgpu_firmware_cache_release(g);
+
+	return UNIT_SUCCESS;
+}
+
+/*
+ * The shrinker must not block on the cache lock, and should drop only as
+ * much as it is asked to, oldest first.
+ */
+static int test_firmware_cache_shrink(struct unit_module *m,
+				      struct gk20a *g, void *args)
+{
+	struct nvgpu_firmware src = {
+		.data = test_image,
+		.size = sizeof(test_image),
+	};
+	struct nvgpu_firmware *fw;
+	size_t freed;
+	int ret = UNIT_FAIL;
+	int err;
+
+	if (nvgpu_firmware_cache_put(g, "old_fw.bin", &src) != 0 ||
+	    nvgpu_firmware_cache_put(g, TEST_FW_NAME, &src) != 0) {
+		unit_err(m, "put failed\n");
+		goto done;
+	}
+
+	nvgpu_mutex_acquire(&g->fw_cache.lock);
+	err = nvgpu_firmware_cache_shrink(g, 1U, &freed);
+	nvgpu_mutex_release(&g->fw_cache.lock);
+	if (err != -EBUSY || freed != 0U) {
+		unit_err(m, "shrink did not back off: %d\n", err);
+		goto done;
+	}
+
+	if (nvgpu_firmware_cache_shrink(g, 1U, &freed) != 0 ||
+	    freed != TEST_FW_SIZE ||
+	    g->fw_cache.bytes != TEST_FW_SIZE) {
+		unit_err(m, "shrink freed %zu bytes\n", freed);
+		goto done;
+	}
+
+	fw = nvgpu_firmware_cache_get(g, TEST_FW_NAME);
+	if (fw == NULL) {
+		unit_err(m, "shrink dropped the newest entry\n");
+		goto done;
+	}
+	nvgpu_release_firmware(g, fw);
+
+	if (nvgpu_firmware_cache_shrink(g, 2U * TEST_FW_SIZE, &freed) != 0 ||
+	    freed != TEST_FW_SIZE || g->fw_cache.bytes != 0U) {
+		unit_err(m, "shrink did not empty the cache\n");
+		goto done;
+	}
+
+	ret = UNIT_SUCCESS;
+
+done:
+	nvgpu_firmware_cache_release(g);
+	return ret;
+}
+
+struct unit_module_test firmware_cache_tests[] = {
+	UNIT_TEST(hit,		test_firmware_cache_hit, NULL),
+	UNIT_TEST(validate,	test_firmware_cache_validate, NULL),
+	UNIT_TEST(replace,	test_firmware_cache_replace, NULL),
+	UNIT_TEST(shrink,	test_firmware_cache_shrink, NULL),
+};
+
+UNIT_MODULE(firmware_cache, firmware_cache_tests, UNIT_PRIO_NVGPU_TEST);
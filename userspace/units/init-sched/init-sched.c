@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/types.h>
+#include <nvgpu/atomic.h>
+#include <nvgpu/barrier.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/init_sched.h>
+
+/* How long a parallel stage waits for its sibling to show up. */
+#define RENDEZVOUS_TIMEOUT_NS	(2LL * 1000LL * 1000LL * 1000LL)
+
+static struct nvgpu_init_sched test_sched;
+
+static nvgpu_atomic_t order_cnt;
+static int order[8];
+static nvgpu_atomic_t arrived;
+
+#define ORDER_STAGE(n)						\
+static int stage_##n(struct gk20a *g)				\
+{								\
+	order[n] = nvgpu_atomic_inc_return(&order_cnt);		\
+	return 0;						\
+}
+
+ORDER_STAGE(0)
+ORDER_STAGE(1)
+ORDER_STAGE(2)
+ORDER_STAGE(3)
+
+static int stage_fail(struct gk20a *g)
+{
+	return -EIO;
+}
+
+/*
+ * Returns only once both parallel stages are running at the same time, so
+ * the test can not pass if the scheduler serializes them.
+ */
+static int stage_rendezvous(struct gk20a *g)
+{
+	s64 deadline = nvgpu_current_time_ns() + RENDEZVOUS_TIMEOUT_NS;
+
+	nvgpu_atomic_inc(&arrived);
+	while (nvgpu_atomic_read(&arrived) < 2) {
+		if (nvgpu_current_time_ns() > deadline) {
+			return -ETIMEDOUT;
+		}
+		nvgpu_smp_rmb();
+	}
+
+	return 0;
+}
+
+static void reset_order(void)
+{
+	nvgpu_atomic_set(&order_cnt, 0);
+	nvgpu_atomic_set(&arrived, 0);
+	(void) memset(order, 0, sizeof(order));
+}
+
+static int test_init_sched_order(struct unit_module *m, struct gk20a *g,
+				 void *args)
+{
+	struct nvgpu_init_sched *sched = &test_sched;
+	int a, b, c;
+
+	reset_order();
+	nvgpu_init_sched_init(sched, g);
+
+	/* c runs on a worker but still waits for b, which waits for a */
+	a = nvgpu_init_sched_add(sched, "a", stage_0, 0U, 0U);
+	b = nvgpu_init_sched_add(sched, "b", stage_1,
+			NVGPU_INIT_STAGE_DEP(a), 0U);
+	c = nvgpu_init_sched_add(sched, "c", stage_2,
+			NVGPU_INIT_STAGE_DEP(b), NVGPU_INIT_STAGE_PARALLEL);
+	if (a < 0 || b < 0 || c < 0) {
+		unit_return_fail(m, "add failed\n");
+	}
+
+	if (nvgpu_init_sched_add(sched, "bad", stage_3,
+			NVGPU_INIT_STAGE_DEP(c + 1), 0U) != -EINVAL) {
+		unit_return_fail(m, "forward dependency accepted\n");
+	}
+
+	if (nvgpu_init_sched_run(sched) != 0) {
+		unit_return_fail(m, "run failed\n");
+	}
+
+	if (order[0] != 1 || order[1] != 2 || order[2] != 3) {
+		unit_return_fail(m, "bad order %d %d %d\n",
+				 order[0], order[1], order[2]);
+	}
+
+	if (!sched->stages[c].on_worker) {
+		unit_return_fail(m, "parallel stage ran inline\n");
+	}
+
+	nvgpu_init_sched_report(sched);
+
+	return UNIT_SUCCESS;
+}
+
+static int test_init_sched_parallel(struct unit_module *m, struct gk20a *g,
+				    void *args)
+{
+	struct nvgpu_init_sched *sched = &test_sched;
+	int p0, p1, skip, join;
+
+	reset_order();
+	nvgpu_init_sched_init(sched, g);
+
+	p0 = nvgpu_init_sched_add(sched, "p0", stage_rendezvous, 0U,
+			NVGPU_INIT_STAGE_PARALLEL);
+	p1 = nvgpu_init_sched_add(sched, "p1", stage_rendezvous, 0U,
+			NVGPU_INIT_STAGE_PARALLEL);
+	skip = nvgpu_init_sched_add(sched, "skip", NULL, 0U, 0U);
+	join = nvgpu_init_sched_add(sched, "join", stage_0,
+			NVGPU_INIT_STAGE_DEP(p0) | NVGPU_INIT_STAGE_DEP(p1) |
+			NVGPU_INIT_STAGE_DEP(skip), 0U);
+	if (p0 < 0 || p1 < 0 || skip < 0 || join < 0) {
+		unit_return_fail(m, "add failed\n");
+	}
+
+	if (nvgpu_init_sched_run(sched) != 0) {
+		unit_return_fail(m, "parallel stages did not overlap\n");
+	}
+
+	if (order[0] != 1) {
+		unit_return_fail(m, "join stage did not run\n");
+	}
+
+	/* a second batch only runs the newly added stages */
+	if (nvgpu_init_sched_add(sched, "late", stage_1,
+			NVGPU_INIT_STAGE_DEP(join), 0U) < 0) {
+		unit_return_fail(m, "add failed\n");
+	}
+
+	if (nvgpu_init_sched_run(sched) != 0 || order[1] != 2 ||
+		nvgpu_atomic_read(&arrived) != 2) {
+		unit_return_fail(m, "second batch misbehaved\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static int test_init_sched_error(struct unit_module *m, struct gk20a *g,
+				 void *args)
+{
+	struct nvgpu_init_sched *sched = &test_sched;
+	int bad, side, after;
+
+	reset_order();
+	nvgpu_init_sched_init(sched, g);
+
+	side = nvgpu_init_sched_add(sched, "side", stage_0, 0U,
+			NVGPU_INIT_STAGE_PARALLEL);
+	bad = nvgpu_init_sched_add(sched, "bad", stage_fail, 0U, 0U);
+	after = nvgpu_init_sched_add(sched, "after", stage_1,
+			NVGPU_INIT_STAGE_DEP(bad), 0U);
+	if (side < 0 || bad < 0 || after < 0) {
+		unit_return_fail(m, "add failed\n");
+	}
+
+	if (nvgpu_init_sched_run(sched) != -EIO) {
+		unit_return_fail(m, "error not propagated\n");
+	}
+
+	if (order[1] != 0) {
+		unit_return_fail(m, "stage ran after a failed dependency\n");
+	}
+
+	/* the worker has to be joined before run() returns */
+	if (!sched->stages[side].finished) {
+		unit_return_fail(m, "worker left running\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+struct unit_module_test init_sched_tests[] = {
+	UNIT_TEST(order,	test_init_sched_order, NULL),
+	UNIT_TEST(parallel,	test_init_sched_parallel, NULL),
+	UNIT_TEST(error,	test_init_sched_error, NULL),
+};
+
+UNIT_MODULE(init_sched, init_sched_tests, UNIT_PRIO_NVGPU_TEST);
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/types.h>
+#include <nvgpu/log.h>
+#include <nvgpu/timers.h>
+#include <nvgpu/gk20a.h>
+
+static char line[160];
+
+/* the posix nvgpu_msleep() is not implemented, spin instead */
+static void wait_next_window(void)
+{
+	s64 end = nvgpu_current_time_ms() + 2 * NVGPU_LOG_RING_WINDOW_MS;
+
+	while (nvgpu_current_time_ms() < end) {
+	}
+}
+
+static int log_ring_setup(struct unit_module *m, struct gk20a *g)
+{
+	nvgpu_log_ring_deinit(g);
+	if (nvgpu_log_ring_init(g) != 0) {
+		unit_err(m, "ring alloc failed\n");
+		return -ENOMEM;
+	}
+	g->log_ring_mask = gpu_dbg_info;
+
+	return 0;
+}
+
+/*
+ * Records go in unformatted and come back out formatted with their
+ * arguments; categories outside log_ring_mask are not recorded.
+ */
+static int test_log_ring_decode(struct unit_module *m, struct gk20a *g,
+				void *args)
+{
+	u32 records, dropped;
+
+	if (log_ring_setup(m, g) != 0) {
+		return UNIT_FAIL;
+	}
+
+	nvgpu_log_bin(g, gpu_dbg_info, "ch %llu put %llx get %llu %lld",
+		      3, 0xabcU, 7, -1);
+	nvgpu_log_bin(g, gpu_dbg_map_v, "not recorded %llu", 0, 0, 0, 0);
+
+	nvgpu_log_ring_stats(g, &records, &dropped);
+	if (records != 1U || dropped != 0U) {
+		unit_return_fail(m, "records %u dropped %u\n",
+				 records, dropped);
+	}
+
+	if (nvgpu_log_ring_decode(g, 0U, line, sizeof(line)) != 0) {
+		unit_return_fail(m, "record 0 missing\n");
+	}
+	if (strstr(line, "test_log_ring_decode:") == NULL ||
+	    strstr(line, " ch 3 put abc get 7 -1") == NULL) {
+		unit_return_fail(m, "bad decode: %s\n", line);
+	}
+
+	if (nvgpu_log_ring_decode(g, 1U, line, sizeof(line)) != -ENOENT) {
+		unit_return_fail(m, "decoded a record not written yet\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+/*
+ * Only NVGPU_LOG_RING_WINDOW_LIMIT records are admitted per window, and
+ * once the ring wraps only the newest NVGPU_LOG_RING_ENTRIES records can
+ * still be decoded.
+ */
+static int test_log_ring_wrap(struct unit_module *m, struct gk20a *g,
+			      void *args)
+{
+	u32 batch = NVGPU_LOG_RING_WINDOW_LIMIT;
+	u32 nr_batches = NVGPU_LOG_RING_ENTRIES / batch + 1U;
+	u32 records, dropped, i, j, seq;
+	char want[32];
+
+	if (log_ring_setup(m, g) != 0) {
+		return UNIT_FAIL;
+	}
+
+	/* one record over the limit in a single burst */
+	for (i = 0U; i <= batch; i++) {
+		nvgpu_log_bin(g, gpu_dbg_info, "seq %llu", i, 0, 0, 0);
+	}
+	nvgpu_log_ring_stats(g, &records, &dropped);
+	if (records != batch || dropped != 1U) {
+		unit_return_fail(m, "burst: records %u dropped %u\n",
+				 records, dropped);
+	}
+
+	/* keep each batch in its own window until the ring has wrapped */
+	for (i = 1U; i < nr_batches; i++) {
+		wait_next_window();
+		for (j = 0U; j < batch; j++) {
+			nvgpu_log_bin(g, gpu_dbg_info, "seq %llu",
+				      i * batch + j, 0, 0, 0);
+		}
+	}
+
+	nvgpu_log_ring_stats(g, &records, &dropped);
+	if (records != nr_batches * batch || dropped != 1U) {
+		unit_return_fail(m, "records %u dropped %u\n",
+				 records, dropped);
+	}
+
+	seq = records - NVGPU_LOG_RING_ENTRIES;
+	if (nvgpu_log_ring_decode(g, seq - 1U, line, sizeof(line)) !=
+	    -ENOENT) {
+		unit_return_fail(m, "overwritten record %u decoded\n",
+				 seq - 1U);
+	}
+
+	for (; seq < records; seq++) {
+		if (nvgpu_log_ring_decode(g, seq, line, sizeof(line)) != 0) {
+			unit_return_fail(m, "record %u missing\n", seq);
+		}
+		(void) snprintf(want, sizeof(want), " seq %u", seq);
+		if (strstr(line, want) == NULL) {
+			unit_return_fail(m, "record %u: %s\n", seq, line);
+		}
+	}
+
+	nvgpu_log_ring_deinit(g);
+
+	return UNIT_SUCCESS;
+}
+
+struct unit_module_test log_ring_tests[] = {
+	UNIT_TEST(decode,	test_log_ring_decode, NULL),
+	UNIT_TEST(wrap,		test_log_ring_wrap, NULL),
+};
+
+UNIT_MODULE(log_ring, log_ring_tests, UNIT_PRIO_NVGPU_TEST);
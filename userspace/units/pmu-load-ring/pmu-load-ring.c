@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/types.h>
+#include <nvgpu/pmu.h>
+#include <nvgpu/gk20a.h>
+
+#define MS	1000000LL
+
+static struct nvgpu_pmu_load_ring test_ring;
+static struct nvgpu_pmu_load_sample test_samples[PMU_LOAD_SAMPLES_NUM];
+
+static int test_load_ring_read(struct unit_module *m, struct gk20a *g,
+			       void *args)
+{
+	u32 i, count;
+
+	nvgpu_pmu_load_ring_init(&test_ring);
+
+	count = nvgpu_pmu_load_ring_read(&test_ring, test_samples,
+					 PMU_LOAD_SAMPLES_NUM);
+	if (count != 0U) {
+		unit_return_fail(m, "empty ring returned %u samples\n", count);
+	}
+
+	/* wrap around once and a bit */
+	for (i = 0; i < PMU_LOAD_SAMPLES_NUM + 10U; i++) {
+		nvgpu_pmu_load_ring_add(&test_ring, (s64)i * MS, i);
+	}
+
+	count = nvgpu_pmu_load_ring_read(&test_ring, test_samples,
+					 PMU_LOAD_SAMPLES_NUM);
+	if (count != PMU_LOAD_SAMPLES_NUM) {
+		unit_return_fail(m, "read %u samples\n", count);
+	}
+	if (test_samples[0].timestamp_ns != 10 * MS ||
+	    test_samples[count - 1U].timestamp_ns !=
+	    (s64)(PMU_LOAD_SAMPLES_NUM + 9U) * MS) {
+		unit_return_fail(m, "samples not oldest first\n");
+	}
+
+	count = nvgpu_pmu_load_ring_read(&test_ring, test_samples, 4U);
+	if (count != 4U || test_samples[3].load != PMU_LOAD_SAMPLES_NUM + 9U) {
+		unit_return_fail(m, "partial read returned wrong samples\n");
+	}
+
+	/* load is clamped, time does not go backwards */
+	nvgpu_pmu_load_ring_add(&test_ring, 0, 5000U);
+	count = nvgpu_pmu_load_ring_read(&test_ring, test_samples, 1U);
+	if (count != 1U ||
+	    test_samples[0].load != PMU_BUSY_CYCLES_NORM_MAX ||
+	    test_samples[0].timestamp_ns !=
+	    (s64)(PMU_LOAD_SAMPLES_NUM + 9U) * MS) {
+		unit_return_fail(m, "sample not sanitized\n");
+	}
+
+	nvgpu_pmu_load_ring_reset(&test_ring);
+	count = nvgpu_pmu_load_ring_read(&test_ring, test_samples, 4U);
+	if (count != 0U) {
+		unit_return_fail(m, "reset ring returned %u samples\n", count);
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static int test_load_ring_window(struct unit_module *m, struct gk20a *g,
+				 void *args)
+{
+	u32 load = 0;
+
+	nvgpu_pmu_load_ring_init(&test_ring);
+
+	if (nvgpu_pmu_load_ring_window(&test_ring, 10 * MS, &load) !=
+	    -ENODATA) {
+		unit_return_fail(m, "empty ring gave a load\n");
+	}
+
+	/* 0..10ms idle, 10..30ms fully busy, 30..40ms half busy */
+	nvgpu_pmu_load_ring_add(&test_ring, 0, 0);
+	nvgpu_pmu_load_ring_add(&test_ring, 10 * MS, 0);
+	nvgpu_pmu_load_ring_add(&test_ring, 30 * MS, 1000);
+	nvgpu_pmu_load_ring_add(&test_ring, 40 * MS, 500);
+
+	if (nvgpu_pmu_load_ring_window(&test_ring, 10 * MS, &load) != 0 ||
+	    load != 500U) {
+		unit_return_fail(m, "10ms window: %u\n", load);
+	}
+	/* 10ms at 500 and 10ms at 1000 */
+	if (nvgpu_pmu_load_ring_window(&test_ring, 20 * MS, &load) != 0 ||
+	    load != 750U) {
+		unit_return_fail(m, "20ms window: %u\n", load);
+	}
+	/* (10 * 0 + 20 * 1000 + 10 * 500) / 40 */
+	if (nvgpu_pmu_load_ring_window(&test_ring, 100 * MS, &load) != 0 ||
+	    load != 625U) {
+		unit_return_fail(m, "whole ring: %u\n", load);
+	}
+	/* a window inside a single sample still gets that sample's load */
+	if (nvgpu_pmu_load_ring_window(&test_ring, 5 * MS, &load) != 0 ||
+	    load != 500U) {
+		unit_return_fail(m, "5ms window: %u\n", load);
+	}
+
+	return UNIT_SUCCESS;
+}
+
+/* 300 of every 1000 cycles busy */
+static u32 test_read_idle_counter(struct gk20a *g, u32 counter_id)
+{
+	return counter_id == 4U ? 300U : 1000U;
+}
+
+static void test_reset_idle_counter(struct gk20a *g, u32 counter_id)
+{
+}
+
+static u32 test_read_idle_intr_status(struct gk20a *g)
+{
+	return 0U;
+}
+
+static void test_clear_idle_intr_status(struct gk20a *g)
+{
+}
+
+static int test_load_ring_busy_cycles(struct unit_module *m,
+				      struct gk20a *g, void *args)
+{
+	struct nvgpu_pmu_load_ring *ring = &g->pmu.load_ring;
+	bool power_on = g->power_on;
+	u32 norm = 0U, load = 0U, count;
+
+	nvgpu_pmu_load_ring_init(ring);
+	g->ops.pmu.pmu_read_idle_counter = test_read_idle_counter;
+	g->ops.pmu.pmu_reset_idle_counter = test_reset_idle_counter;
+	g->ops.pmu.pmu_read_idle_intr_status = test_read_idle_intr_status;
+	g->ops.pmu.pmu_clear_idle_intr_status = test_clear_idle_intr_status;
+
+	/* nothing is sampled while the GPU is off */
+	g->power_on = false;
+	nvgpu_pmu_busy_cycles_norm(g, &norm);
+	count = nvgpu_pmu_load_ring_read(ring, test_samples,
+					 PMU_LOAD_SAMPLES_NUM);
+	if (norm != 0U || count != 0U) {
+		g->power_on = power_on;
+		unit_return_fail(m, "powered off: norm %u, %u samples\n",
+				 norm, count);
+	}
+
+	/* the devfreq path feeds the ring */
+	g->power_on = true;
+	nvgpu_pmu_busy_cycles_norm(g, &norm);
+	g->power_on = power_on;
+	count = nvgpu_pmu_load_ring_read(ring, test_samples,
+					 PMU_LOAD_SAMPLES_NUM);
+	if (norm != 300U || count != 1U || test_samples[0].load != norm) {
+		unit_return_fail(m, "norm %u, %u samples\n", norm, count);
+	}
+	if (nvgpu_pmu_load_window(g, 10 * MS, &load) != 0 || load != 300U) {
+		unit_return_fail(m, "window load %u\n", load);
+	}
+
+	return UNIT_SUCCESS;
+}
+
+struct unit_module_test pmu_load_ring_tests[] = {
+	UNIT_TEST(read,		test_load_ring_read, NULL),
+	UNIT_TEST(window,	test_load_ring_window, NULL),
+	UNIT_TEST(busy_cycles,	test_load_ring_busy_cycles, NULL),
+};
+
+UNIT_MODULE(pmu_load_ring, pmu_load_ring_tests, UNIT_PRIO_NVGPU_TEST);
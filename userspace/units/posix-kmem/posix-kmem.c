@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/kmem.h>
+#include <nvgpu/posix/kmem.h>
+
+struct kmem_cache_test_args {
+	size_t size;
+	u32 nr_objs;
+};
+
+static struct kmem_cache_test_args small_args = {
+	.size = 1, .nr_objs = 4096 };
+static struct kmem_cache_test_args odd_args = {
+	.size = 77, .nr_objs = 4096 };
+/* keep the large case at a few MB */
+static struct kmem_cache_test_args large_args = {
+	.size = 128 * 1024, .nr_objs = 64 };
+
+/*
+ * Allocate a bunch of objects, make sure they are aligned, usable and don't
+ * overlap, then free them all and check that the cache reuses the memory
+ * instead of growing.
+ */
+static int test_kmem_cache_alloc_free(struct unit_module *m,
+				      struct gk20a *g, void *__args)
+{
+	struct kmem_cache_test_args *args = __args;
+	u32 nr_objs = args->nr_objs;
+	struct nvgpu_posix_kmem_cache_stats stats;
+	struct nvgpu_kmem_cache *cache;
+	void **objs;
+	u64 nr_chunks;
+	int ret = UNIT_FAIL;
+	u32 i;
+
+	objs = calloc(nr_objs, sizeof(*objs));
+	if (objs == NULL)
+		unit_return_fail(m, "Failed to alloc obj array\n");
+
+	cache = nvgpu_kmem_cache_create(g, args->size);
+	if (cache == NULL) {
+		unit_err(m, "Failed to create cache\n");
+		goto done;
+	}
+
+	for (i = 0; i < nr_objs; i++) {
+		objs[i] = nvgpu_kmem_cache_alloc(cache);
+		if (objs[i] == NULL) {
+			unit_err(m, "alloc %u failed\n", i);
+			goto destroy;
+		}
+		if (((uintptr_t)objs[i] & 0x7UL) != 0UL) {
+			unit_err(m, "obj %u misaligned: %p\n", i, objs[i]);
+			goto destroy;
+		}
+		memset(objs[i], i & 0xff, args->size);
+	}
+
+	/* Every object must still hold the pattern it was given. */
+	for (i = 0; i < nr_objs; i++) {
+		u8 *p = objs[i];
+
+		if (p[0] != (u8)(i & 0xff) || p[args->size - 1] != p[0]) {
+			unit_err(m, "obj %u corrupted\n", i);
+			goto destroy;
+		}
+	}
+
+	nvgpu_posix_kmem_cache_get_stats(cache, &stats);
+	if (stats.obj_size < args->size ||
+	    stats.objs_active != nr_objs ||
+	    stats.objs_peak != nr_objs ||
+	    stats.nr_chunks * stats.objs_per_chunk < nr_objs) {
+		unit_err(m, "Bad stats after alloc\n");
+		goto destroy;
+	}
+	nr_chunks = stats.nr_chunks;
+
+	for (i = 0; i < nr_objs; i++)
+		nvgpu_kmem_cache_free(cache, objs[i]);
+
+	for (i = 0; i < nr_objs; i++) {
+		objs[i] = nvgpu_kmem_cache_alloc(cache);
+		if (objs[i] == NULL) {
+			unit_err(m, "realloc %u failed\n", i);
+			goto destroy;
+		}
+	}
+
+	nvgpu_posix_kmem_cache_get_stats(cache, &stats);
+	if (stats.nr_chunks != nr_chunks ||
+	    stats.nr_allocs != 2ULL * nr_objs ||
+	    stats.nr_frees != nr_objs ||
+	    stats.objs_active != nr_objs) {
+		unit_err(m, "Bad stats after realloc: chunks=%llu/%llu\n",
+			 (unsigned long long)stats.nr_chunks,
+			 (unsigned long long)nr_chunks);
+		goto destroy;
+	}
+
+	for (i = 0; i < nr_objs; i++)
+		nvgpu_kmem_cache_free(cache, objs[i]);
+
+	ret = UNIT_SUCCESS;
+
+destroy:
+	nvgpu_kmem_cache_destroy(cache);
+done:
+	free(objs);
+	return ret;
+}
+
+/*
+ * Caches must be independent of each other.
+ */
+static int test_kmem_cache_multi(struct unit_module *m,
+				 struct gk20a *g, void *args)
+{
+	struct nvgpu_posix_kmem_cache_stats stats_a, stats_b;
+	struct nvgpu_kmem_cache *a, *b;
+	void *obj_a, *obj_b;
+
+	a = nvgpu_kmem_cache_create(g, 32);
+	b = nvgpu_kmem_cache_create(g, 64);
+	if (a == NULL || b == NULL) {
+		nvgpu_kmem_cache_destroy(a);
+		nvgpu_kmem_cache_destroy(b);
+		unit_return_fail(m, "Failed to create caches\n");
+	}
+
+	obj_a = nvgpu_kmem_cache_alloc(a);
+	obj_b = nvgpu_kmem_cache_alloc(b);
+
+	nvgpu_posix_kmem_cache_get_stats(a, &stats_a);
+	nvgpu_posix_kmem_cache_get_stats(b, &stats_b);
+
+	nvgpu_kmem_cache_free(a, obj_a);
+	nvgpu_kmem_cache_free(b, obj_b);
+	nvgpu_kmem_cache_destroy(a);
+	nvgpu_kmem_cache_destroy(b);
+
+	if (obj_a == NULL || obj_b == NULL || obj_a == obj_b)
+		unit_return_fail(m, "Bad objects: %p %p\n", obj_a, obj_b);
+
+	if (stats_a.obj_size != 32 || stats_b.obj_size != 64 ||
+	    stats_a.objs_active != 1 || stats_b.objs_active != 1)
+		unit_return_fail(m, "Bad stats\n");
+
+	return UNIT_SUCCESS;
+}
+
+struct unit_module_test posix_kmem_tests[] = {
+	UNIT_TEST(cache_small,	test_kmem_cache_alloc_free, &small_args),
+	UNIT_TEST(cache_odd,	test_kmem_cache_alloc_free, &odd_args),
+	UNIT_TEST(cache_large,	test_kmem_cache_alloc_free, &large_args),
+	UNIT_TEST(cache_multi,	test_kmem_cache_multi, NULL),
+};
+
+UNIT_MODULE(posix_kmem, posix_kmem_tests, UNIT_PRIO_POSIX_TEST);
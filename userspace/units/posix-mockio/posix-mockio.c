@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2019, NVIDIA CORPORATION.  All rights reserved.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
  * copy of this software and associated documentation files (the "Software"),
@@ -21,12 +21,15 @@
  */
 
 #include <stdlib.h>
+#include <unistd.h>
 
 #include <unit/io.h>
 #include <unit/unit.h>
 
 #include <nvgpu/io.h>
+#include <nvgpu/kmem.h>
 #include <nvgpu/io_usermode.h>
+#include <nvgpu/timers.h>
 #include <nvgpu/posix/io.h>
 
 struct writel_test_args {
@@ -171,6 +174,11 @@ struct writel_test_args nvgpu_writel_args = {
 	.fn   = nvgpu_writel
 };
 
+struct writel_test_args nvgpu_writel_relaxed_args = {
+	.name = "nvgpu_writel_relaxed",
+	.fn   = nvgpu_writel_relaxed
+};
+
 struct writel_test_args nvgpu_writel_check_args = {
 	.name = "nvgpu_writel_check",
 	.fn   = nvgpu_writel_check
@@ -268,7 +276,13 @@ static int test_register_space(struct unit_module *m, struct gk20a *g,
 	if (value != 0x87654321) {
 		return UNIT_FAIL;
 	}
+
+	/* One past the end of a space must fault rather than corrupt memory. */
 	nvgpu_posix_io_writel_reg_space(g, 0x10000100, 0x2727);
+	if (nvgpu_posix_io_get_error_code(g) != -EFAULT) {
+		unit_return_fail(m, "Out of bounds access not caught\n");
+	}
+	nvgpu_posix_io_reset_error_code(g);
 
 	/* Now re-define the callbacks to perform our own testing */
 	struct nvgpu_posix_io_callbacks *old_cbs = nvgpu_posix_register_io(g,
@@ -320,10 +334,267 @@ static int test_register_space(struct unit_module *m, struct gk20a *g,
 	return UNIT_SUCCESS;
 }
 
+/*
+ * Stream a table laid out like the GR aiv lists (addr, index, value) and check
+ * that every entry reaches the register space, in order, as a plain write.
+ */
+static int test_writel_stream(struct unit_module *m, struct gk20a *g,
+			      void *__args)
+{
+	static const u32 stream[][3] = {
+		{ 0x10000000, 0x0, 0x11 },
+		{ 0x10000004, 0x1, 0x22 },
+		{ 0x10000004, 0x2, 0x33 },
+		{ 0x100000FC, 0x3, 0x44 },
+	};
+	struct nvgpu_reg_access sequence[] = {
+		{ .addr = 0x10000000, .value = 0x11 },
+		{ .addr = 0x10000004, .value = 0x22 },
+		{ .addr = 0x10000004, .value = 0x33 },
+		{ .addr = 0x100000FC, .value = 0x44 },
+	};
+	struct nvgpu_posix_io_callbacks *old_cbs;
+	int ret = UNIT_SUCCESS;
+
+	nvgpu_posix_io_init_reg_space(g);
+	if (nvgpu_posix_io_add_reg_space(g, 0x10000000, 0x100) != 0) {
+		return UNIT_FAIL;
+	}
+
+	old_cbs = nvgpu_posix_register_io(g, &test_reg_callbacks);
+	nvgpu_posix_io_start_recorder(g);
+
+	nvgpu_writel_stream(g, &stream[0][0],
+		sizeof(stream) / sizeof(stream[0]), 3U, 2U);
+
+	if (nvgpu_posix_io_get_error_code(g) != 0) {
+		unit_err(m, "IO Access Error\n");
+		ret = UNIT_FAIL;
+	} else if (!nvgpu_posix_io_check_sequence(g, sequence,
+			sizeof(sequence) / sizeof(sequence[0]), true)) {
+		unit_err(m, "Failed checking stream sequence\n");
+		ret = UNIT_FAIL;
+	} else if (nvgpu_readl(g, 0x10000004) != 0x33) {
+		unit_err(m, "Stream did not keep the last write\n");
+		ret = UNIT_FAIL;
+	}
+
+	nvgpu_posix_io_start_recorder(g);
+	nvgpu_posix_io_delete_reg_space(g, 0x10000000);
+	nvgpu_posix_register_io(g, old_cbs);
+
+	return ret;
+}
+
+/*
+ * Record enough accesses to force the recorder to grow, with a filter that
+ * drops everything outside one register space.
+ */
+static int test_recorder_filter(struct unit_module *m, struct gk20a *g,
+				void *__args)
+{
+	struct nvgpu_posix_io_callbacks *old_cbs;
+	struct nvgpu_reg_access sequence[2];
+	int ret = UNIT_SUCCESS;
+	u32 i;
+
+	nvgpu_posix_io_init_reg_space(g);
+	if (nvgpu_posix_io_add_reg_space(g, 0x10000000, 0x100) != 0 ||
+	    nvgpu_posix_io_add_reg_space(g, 0x80000000, 0x100) != 0) {
+		return UNIT_FAIL;
+	}
+
+	old_cbs = nvgpu_posix_register_io(g, &test_reg_callbacks);
+	nvgpu_posix_io_start_recorder(g);
+	nvgpu_posix_io_set_recorder_filter(g, 0x80000000, 0x100);
+
+	for (i = 0; i < 5000; i++) {
+		nvgpu_writel(g, 0x10000000 + (i % 0x40) * 4, i);
+		nvgpu_writel(g, 0x80000000 + (i % 0x40) * 4, i);
+	}
+
+	sequence[0].addr = 0x80000000;
+	sequence[0].value = 0;
+	sequence[1].addr = 0x80000000 + (4999 % 0x40) * 4;
+	sequence[1].value = 4999;
+
+	if (nvgpu_posix_io_get_error_code(g) != 0) {
+		unit_err(m, "IO Access Error\n");
+		ret = UNIT_FAIL;
+	} else if (nvgpu_posix_io_check_sequence(g, sequence, 2, true)) {
+		unit_err(m, "Strict check passed with missing accesses\n");
+		ret = UNIT_FAIL;
+	} else if (!nvgpu_posix_io_check_sequence(g, sequence, 2, false)) {
+		unit_err(m, "Relaxed check failed\n");
+		ret = UNIT_FAIL;
+	}
+
+	/* Nothing outside the filter may have been recorded. */
+	sequence[0].addr = 0x10000000;
+	if (ret == UNIT_SUCCESS &&
+	    nvgpu_posix_io_check_sequence(g, sequence, 1, false)) {
+		unit_err(m, "Filtered access was recorded\n");
+		ret = UNIT_FAIL;
+	}
+
+	nvgpu_posix_io_reset_recorder(g);
+	nvgpu_posix_io_init_reg_space(g);
+	nvgpu_posix_register_io(g, old_cbs);
+
+	return ret;
+}
+
+#define BENCH_NR_WRITES		4096U
+#define BENCH_SPACE		0x10000000U
+#define BENCH_SPACE_SIZE	0x1000U
+
+static u32 bench_list[BENCH_NR_WRITES][2];
+static struct nvgpu_reg_access bench_sequence[BENCH_NR_WRITES];
+
+/*
+ * Replay a sw_ctx_load sized (addr, value) list once with one nvgpu_writel()
+ * per entry, as the GR init lists used to be written, and once through
+ * nvgpu_writel_stream(). The recorder has to see the same number of
+ * accesses in the same order for both; the time per access is reported.
+ */
+static int test_writel_stream_bench(struct unit_module *m, struct gk20a *g,
+				    void *__args)
+{
+	struct nvgpu_posix_io_callbacks *old_cbs;
+	s64 start, loop_ns, stream_ns;
+	u32 i, loop_count, stream_count;
+	int ret = UNIT_SUCCESS;
+
+	for (i = 0; i < BENCH_NR_WRITES; i++) {
+		bench_list[i][0] = BENCH_SPACE + (i * 4U) % BENCH_SPACE_SIZE;
+		bench_list[i][1] = i * 0x9e3779b9U;
+		bench_sequence[i].addr = bench_list[i][0];
+		bench_sequence[i].value = bench_list[i][1];
+	}
+
+	nvgpu_posix_io_init_reg_space(g);
+	if (nvgpu_posix_io_add_reg_space(g, BENCH_SPACE,
+					 BENCH_SPACE_SIZE) != 0) {
+		return UNIT_FAIL;
+	}
+	old_cbs = nvgpu_posix_register_io(g, &test_reg_callbacks);
+
+	nvgpu_posix_io_start_recorder(g);
+	start = nvgpu_current_time_ns();
+	for (i = 0; i < BENCH_NR_WRITES; i++) {
+		nvgpu_writel(g, bench_list[i][0], bench_list[i][1]);
+	}
+	loop_ns = nvgpu_current_time_ns() - start;
+	loop_count = nvgpu_posix_io_get_recorded_count(g);
+	if (!nvgpu_posix_io_check_sequence(g, bench_sequence,
+			BENCH_NR_WRITES, true)) {
+		unit_err(m, "writel loop sequence mismatch\n");
+		ret = UNIT_FAIL;
+	}
+
+	nvgpu_posix_io_start_recorder(g);
+	start = nvgpu_current_time_ns();
+	nvgpu_writel_stream(g, &bench_list[0][0], BENCH_NR_WRITES, 2U, 1U);
+	stream_ns = nvgpu_current_time_ns() - start;
+	stream_count = nvgpu_posix_io_get_recorded_count(g);
+	if (ret == UNIT_SUCCESS &&
+	    !nvgpu_posix_io_check_sequence(g, bench_sequence,
+			BENCH_NR_WRITES, true)) {
+		unit_err(m, "stream sequence mismatch\n");
+		ret = UNIT_FAIL;
+	}
+
+	if (ret == UNIT_SUCCESS &&
+	    (loop_count != BENCH_NR_WRITES || stream_count != loop_count)) {
+		unit_err(m, "access count loop %u stream %u\n",
+			 loop_count, stream_count);
+		ret = UNIT_FAIL;
+	}
+	if (ret == UNIT_SUCCESS && nvgpu_posix_io_get_error_code(g) != 0) {
+		unit_err(m, "IO Access Error\n");
+		ret = UNIT_FAIL;
+	}
+
+	unit_info(m, "%u writes: writel loop %lld ns, stream %lld ns\n",
+		  BENCH_NR_WRITES, loop_ns, stream_ns);
+
+	nvgpu_posix_io_reset_recorder(g);
+	nvgpu_posix_io_delete_reg_space(g, BENCH_SPACE);
+	nvgpu_posix_register_io(g, old_cbs);
+
+	return ret;
+}
+
+/*
+ * Export a recording, then check it against itself both streamed from the
+ * file and after importing it.
+ */
+static int test_recorder_file(struct unit_module *m, struct gk20a *g,
+			      void *__args)
+{
+	char path[] = "/tmp/nvgpu-mockio-XXXXXX";
+	struct nvgpu_posix_io_callbacks *old_cbs;
+	struct nvgpu_reg_access *sequence = NULL;
+	u32 size = 0, i;
+	int ret = UNIT_SUCCESS;
+	int fd;
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		unit_return_fail(m, "Failed to create trace file\n");
+	}
+	close(fd);
+
+	nvgpu_posix_io_init_reg_space(g);
+	if (nvgpu_posix_io_add_reg_space(g, 0x10000000, 0x100) != 0) {
+		unlink(path);
+		return UNIT_FAIL;
+	}
+
+	old_cbs = nvgpu_posix_register_io(g, &test_reg_callbacks);
+	nvgpu_posix_io_start_recorder(g);
+
+	for (i = 0; i < 3000; i++) {
+		nvgpu_writel(g, 0x10000000 + (i % 0x40) * 4, i * 3);
+	}
+
+	if (nvgpu_posix_io_export_recording(g, path) != 0) {
+		unit_err(m, "Failed to export recording\n");
+		ret = UNIT_FAIL;
+	} else if (!nvgpu_posix_io_check_sequence_file(g, path, true)) {
+		unit_err(m, "Recording does not match its own trace\n");
+		ret = UNIT_FAIL;
+	} else if (nvgpu_posix_io_import_sequence(g, path, &sequence,
+						  &size) != 0 ||
+		   size != 3000 ||
+		   sequence[2999].addr != 0x10000000 + (2999 % 0x40) * 4 ||
+		   sequence[2999].value != 2999 * 3) {
+		unit_err(m, "Bad imported trace\n");
+		ret = UNIT_FAIL;
+	} else {
+		/* A diverging write must be caught in strict mode. */
+		nvgpu_writel(g, 0x10000000, 0xdead);
+		if (nvgpu_posix_io_check_sequence_file(g, path, true) ||
+		    !nvgpu_posix_io_check_sequence(g, sequence, size, false)) {
+			unit_err(m, "Bad compare after extra write\n");
+			ret = UNIT_FAIL;
+		}
+	}
+
+	nvgpu_vfree(g, sequence);
+	unlink(path);
+	nvgpu_posix_io_reset_recorder(g);
+	nvgpu_posix_io_init_reg_space(g);
+	nvgpu_posix_register_io(g, old_cbs);
+
+	return ret;
+}
 
 struct unit_module_test posix_mockio_tests[] = {
 	UNIT_TEST(register_io_callbacks, test_register_io_callbacks, NULL),
 	UNIT_TEST(writel,		 test_writel, &nvgpu_writel_args),
+	UNIT_TEST(writel_relaxed,	 test_writel,
+		  &nvgpu_writel_relaxed_args),
 	UNIT_TEST(writel_check,		 test_writel, &nvgpu_writel_check_args),
 	UNIT_TEST(bar1_writel,		 test_writel, &nvgpu_bar1_writel_args),
 	UNIT_TEST(usermode_writel,	 test_writel,
@@ -332,6 +603,10 @@ struct unit_module_test posix_mockio_tests[] = {
 	UNIT_TEST(__readl,		 test_readl, &__nvgpu_readl_args),
 	UNIT_TEST(bar1_readl,		 test_readl, &nvgpu_bar1_readl_args),
 	UNIT_TEST(test_register_space,	 test_register_space, NULL),
+	UNIT_TEST(writel_stream,	 test_writel_stream, NULL),
+	UNIT_TEST(writel_stream_bench,	 test_writel_stream_bench, NULL),
+	UNIT_TEST(recorder_filter,	 test_recorder_filter, NULL),
+	UNIT_TEST(recorder_file,	 test_recorder_file, NULL),
 };
 
 UNIT_MODULE(posix_mockio, posix_mockio_tests, UNIT_PRIO_POSIX_TEST);
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/io.h>
+#include <nvgpu/posix/io.h>
+
+/*
+ * Roughly what a full chip simulation registers: one space per unit, spread
+ * across the BAR0 aperture.
+ */
+#define NR_SPACES		64U
+#define SPACE_STRIDE		0x10000U
+#define SPACE_SIZE		0x1000U
+#define SPACE_BASE(i)		(0x100000U + ((u32)(i) * SPACE_STRIDE))
+
+#define BENCH_ACCESSES		(1U << 22)
+
+static void writel_access_reg_fn(struct gk20a *g,
+				 struct nvgpu_reg_access *access)
+{
+	nvgpu_posix_io_writel_reg_space(g, access->addr, access->value);
+}
+
+static void readl_access_reg_fn(struct gk20a *g,
+				struct nvgpu_reg_access *access)
+{
+	access->value = nvgpu_posix_io_readl_reg_space(g, access->addr);
+}
+
+static struct nvgpu_posix_io_callbacks regspace_callbacks = {
+	.writel = writel_access_reg_fn,
+	.readl  = readl_access_reg_fn,
+};
+
+static struct nvgpu_posix_io_callbacks *old_cbs;
+
+static int test_regspace_setup(struct unit_module *m, struct gk20a *g,
+			       void *args)
+{
+	u32 i;
+
+	nvgpu_posix_io_init_reg_space(g);
+
+	/* Add in a scrambled order so the spaces have to be sorted. */
+	for (i = 0; i < NR_SPACES; i++) {
+		u32 idx = (i * 37U) % NR_SPACES;
+
+		if (nvgpu_posix_io_add_reg_space(g, SPACE_BASE(idx),
+						 SPACE_SIZE) != 0) {
+			unit_return_fail(m, "Failed to add space %u\n", idx);
+		}
+	}
+
+	old_cbs = nvgpu_posix_register_io(g, &regspace_callbacks);
+
+	return UNIT_SUCCESS;
+}
+
+static int test_regspace_lookup(struct unit_module *m, struct gk20a *g,
+				void *args)
+{
+	u32 i;
+
+	for (i = 0; i < NR_SPACES; i++) {
+		u32 base = SPACE_BASE(i);
+
+		if (nvgpu_posix_io_get_reg_space(g, base)->base != base ||
+		    nvgpu_posix_io_get_reg_space(g, base + SPACE_SIZE - 4U)
+			    ->base != base) {
+			unit_return_fail(m, "Bad lookup in space %u\n", i);
+		}
+	}
+
+	/* Gaps, the byte past the end and addresses below the first space. */
+	if (nvgpu_posix_io_get_reg_space(g, SPACE_BASE(3) + SPACE_SIZE) ||
+	    nvgpu_posix_io_get_reg_space(g, SPACE_BASE(0) - 4U) ||
+	    nvgpu_posix_io_get_reg_space(g, SPACE_BASE(NR_SPACES))) {
+		unit_return_fail(m, "Lookup outside any space succeeded\n");
+	}
+	if (nvgpu_posix_io_get_error_code(g) != -EFAULT) {
+		unit_return_fail(m, "Bad access did not set error code\n");
+	}
+	nvgpu_posix_io_reset_error_code(g);
+
+	/* Overlapping spaces are rejected. */
+	if (nvgpu_posix_io_add_reg_space(g, SPACE_BASE(5) + SPACE_SIZE - 4U,
+					 8U) == 0 ||
+	    nvgpu_posix_io_add_reg_space(g, SPACE_BASE(5) - 4U, 8U) == 0) {
+		unit_return_fail(m, "Overlapping space was accepted\n");
+	}
+
+	/* Deleting a space drops it (and the last-hit cache) cleanly. */
+	nvgpu_writel(g, SPACE_BASE(7), 0x7);
+	nvgpu_posix_io_delete_reg_space(g, SPACE_BASE(7));
+	if (nvgpu_posix_io_get_reg_space(g, SPACE_BASE(7)) != NULL) {
+		unit_return_fail(m, "Deleted space still found\n");
+	}
+	nvgpu_posix_io_reset_error_code(g);
+	if (nvgpu_posix_io_add_reg_space(g, SPACE_BASE(7), SPACE_SIZE) != 0 ||
+	    nvgpu_readl(g, SPACE_BASE(7)) != 0U) {
+		unit_return_fail(m, "Failed to re-add deleted space\n");
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static double regspace_elapsed(struct timespec *start, struct timespec *end)
+{
+	return (double)(end->tv_sec - start->tv_sec) +
+		(double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/*
+ * Not a pass/fail test as such: report how many register accesses per second
+ * the mock IO layer sustains for a local pattern (a unit poking its own
+ * registers) and for one that hops between units on every access.
+ */
+static int test_regspace_bench(struct unit_module *m, struct gk20a *g,
+			       void *args)
+{
+	struct timespec start, end;
+	u32 i, sum = 0;
+	double secs;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < BENCH_ACCESSES; i++) {
+		u32 addr = SPACE_BASE((i >> 10) % NR_SPACES) +
+			((i * 4U) % SPACE_SIZE);
+
+		nvgpu_writel(g, addr, i);
+		sum += nvgpu_readl(g, addr);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	secs = regspace_elapsed(&start, &end);
+	unit_info(m, "local:  %u accesses in %.3fs (%.1f M/s)\n",
+		  2U * BENCH_ACCESSES, secs,
+		  (2.0 * BENCH_ACCESSES) / secs / 1e6);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < BENCH_ACCESSES; i++) {
+		u32 addr = SPACE_BASE((i * 37U) % NR_SPACES) +
+			((i * 4U) % SPACE_SIZE);
+
+		nvgpu_writel(g, addr, i);
+		sum += nvgpu_readl(g, addr);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	secs = regspace_elapsed(&start, &end);
+	unit_info(m, "random: %u accesses in %.3fs (%.1f M/s)\n",
+		  2U * BENCH_ACCESSES, secs,
+		  (2.0 * BENCH_ACCESSES) / secs / 1e6);
+
+	if (nvgpu_posix_io_get_error_code(g) != 0) {
+		unit_return_fail(m, "IO error during benchmark (sum %u)\n",
+				 sum);
+	}
+
+	return UNIT_SUCCESS;
+}
+
+static int test_regspace_teardown(struct unit_module *m, struct gk20a *g,
+				  void *args)
+{
+	nvgpu_posix_register_io(g, old_cbs);
+	nvgpu_posix_io_init_reg_space(g);
+
+	return UNIT_SUCCESS;
+}
+
+struct unit_module_test posix_regspace_tests[] = {
+	UNIT_TEST(setup,	test_regspace_setup, NULL),
+	UNIT_TEST(lookup,	test_regspace_lookup, NULL),
+	UNIT_TEST(bench,	test_regspace_bench, NULL),
+	UNIT_TEST(teardown,	test_regspace_teardown, NULL),
+};
+
+UNIT_MODULE(posix_regspace, posix_regspace_tests, UNIT_PRIO_POSIX_TEST);
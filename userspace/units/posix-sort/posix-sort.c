@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <unit/io.h>
+#include <unit/unit.h>
+
+#include <nvgpu/types.h>
+#include <nvgpu/sort.h>
+
+#define TEST_NR_ELEMS		5000U
+#define BENCH_NR_ELEMS		(1U << 20)
+
+enum sort_pattern {
+	PATTERN_RANDOM,
+	PATTERN_SORTED,
+	PATTERN_REVERSED,
+	PATTERN_EQUAL,
+	PATTERN_ORGAN_PIPE,
+	PATTERN_FEW_UNIQUE,
+	PATTERN_MAX,
+};
+
+static const char *pattern_names[PATTERN_MAX] = {
+	"random", "sorted", "reversed", "equal", "organ-pipe", "few-unique",
+};
+
+/* 12 bytes: exercises the generic byte swap. */
+struct sort_test_elem {
+	u32 key;
+	u32 idx;
+	u32 check;
+};
+
+static u64 pattern_value(enum sort_pattern pattern, u32 i, u32 n)
+{
+	switch (pattern) {
+	case PATTERN_SORTED:
+		return i;
+	case PATTERN_REVERSED:
+		return n - i;
+	case PATTERN_EQUAL:
+		return 7;
+	case PATTERN_ORGAN_PIPE:
+		return (i < n / 2) ? i : n - i;
+	case PATTERN_FEW_UNIQUE:
+		return (u64)rand() % 4;
+	default:
+		return ((u64)rand() << 31) ^ (u64)rand();
+	}
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int cmp_elem(const void *a, const void *b)
+{
+	return cmp_u32(&((const struct sort_test_elem *)a)->key,
+		       &((const struct sort_test_elem *)b)->key);
+}
+
+static unsigned long nr_custom_swaps;
+
+static void swap_elem(void *a, void *b, int size)
+{
+	struct sort_test_elem t = *(struct sort_test_elem *)a;
+
+	*(struct sort_test_elem *)a = *(struct sort_test_elem *)b;
+	*(struct sort_test_elem *)b = t;
+	nr_custom_swaps++;
+}
+
+static int test_sort_u32(struct unit_module *m, struct gk20a *g, void *args)
+{
+	u32 *a = malloc(TEST_NR_ELEMS * sizeof(*a));
+	u64 sum, check;
+	u32 n, i;
+	int p;
+
+	if (a == NULL)
+		unit_return_fail(m, "OOM\n");
+
+	for (p = 0; p < PATTERN_MAX; p++) {
+		/* Odd sizes around the insertion sort cut-over too. */
+		for (n = 0; n <= TEST_NR_ELEMS; n += (n < 40) ? 1 : 997) {
+			sum = check = 0;
+			for (i = 0; i < n; i++) {
+				a[i] = (u32)pattern_value(p, i, n);
+				sum += a[i];
+			}
+
+			sort(a, n, sizeof(*a), cmp_u32, NULL);
+
+			for (i = 0; i < n; i++) {
+				check += a[i];
+				if (i > 0 && a[i - 1] > a[i]) {
+					free(a);
+					unit_return_fail(m, "%s/%u: unsorted\n",
+							 pattern_names[p], n);
+				}
+			}
+			if (check != sum) {
+				free(a);
+				unit_return_fail(m, "%s/%u: lost elements\n",
+						 pattern_names[p], n);
+			}
+		}
+	}
+
+	free(a);
+	return UNIT_SUCCESS;
+}
+
+static int test_sort_u64(struct unit_module *m, struct gk20a *g, void *args)
+{
+	u64 *a = malloc(TEST_NR_ELEMS * sizeof(*a));
+	u32 i;
+	int p;
+
+	if (a == NULL)
+		unit_return_fail(m, "OOM\n");
+
+	for (p = 0; p < PATTERN_MAX; p++) {
+		for (i = 0; i < TEST_NR_ELEMS; i++)
+			a[i] = pattern_value(p, i, TEST_NR_ELEMS) << 20;
+
+		sort(a, TEST_NR_ELEMS, sizeof(*a), cmp_u64, NULL);
+
+		for (i = 1; i < TEST_NR_ELEMS; i++) {
+			if (a[i - 1] > a[i]) {
+				free(a);
+				unit_return_fail(m, "%s: unsorted\n",
+						 pattern_names[p]);
+			}
+		}
+	}
+
+	free(a);
+	return UNIT_SUCCESS;
+}
+
+/*
+ * Sort records that aren't a word size, with and without a custom swap, and
+ * make sure each record travels as a unit.
+ */
+static int test_sort_custom(struct unit_module *m, struct gk20a *g,
+			    void *args)
+{
+	struct sort_test_elem *a = malloc(TEST_NR_ELEMS * sizeof(*a));
+	u32 i;
+	int pass;
+
+	if (a == NULL)
+		unit_return_fail(m, "OOM\n");
+
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < TEST_NR_ELEMS; i++) {
+			a[i].key = (u32)rand() % 1000;
+			a[i].idx = i;
+			a[i].check = a[i].key ^ i;
+		}
+
+		nr_custom_swaps = 0;
+		sort(a, TEST_NR_ELEMS, sizeof(*a), cmp_elem,
+		     pass ? swap_elem : NULL);
+
+		if (pass && nr_custom_swaps == 0) {
+			free(a);
+			unit_return_fail(m, "custom swap not used\n");
+		}
+
+		for (i = 0; i < TEST_NR_ELEMS; i++) {
+			if ((a[i].key ^ a[i].idx) != a[i].check ||
+			    (i > 0 && a[i - 1].key > a[i].key)) {
+				free(a);
+				unit_return_fail(m, "pass %d: bad elem %u\n",
+						 pass, i);
+			}
+		}
+	}
+
+	free(a);
+	return UNIT_SUCCESS;
+}
+
+static double sort_bench_one(u32 *a, u32 n,
+			     void (*fn)(void *, size_t, size_t,
+					int (*)(const void *, const void *)))
+{
+	struct timespec start, end;
+	u32 i;
+
+	srand(1);
+	for (i = 0; i < n; i++)
+		a[i] = (u32)rand();
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	fn(a, n, sizeof(*a), cmp_u32);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (double)(end.tv_sec - start.tv_sec) +
+		(double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static void nvgpu_sort_no_swap(void *base, size_t num, size_t size,
+			       int (*cmp)(const void *, const void *))
+{
+	sort(base, num, size, cmp, NULL);
+}
+
+/*
+ * Report sort() throughput next to libc's qsort() for reference.
+ */
+static int test_sort_bench(struct unit_module *m, struct gk20a *g,
+			   void *args)
+{
+	u32 *a = malloc(BENCH_NR_ELEMS * sizeof(*a));
+	double t_sort, t_qsort;
+
+	if (a == NULL)
+		unit_return_fail(m, "OOM\n");
+
+	t_sort = sort_bench_one(a, BENCH_NR_ELEMS, nvgpu_sort_no_swap);
+	t_qsort = sort_bench_one(a, BENCH_NR_ELEMS, qsort);
+
+	unit_info(m, "%u u32: sort() %.3fs, qsort() %.3fs\n",
+		  BENCH_NR_ELEMS, t_sort, t_qsort);
+
+	free(a);
+	return UNIT_SUCCESS;
+}
+
+struct unit_module_test posix_sort_tests[] = {
+	UNIT_TEST(sort_u32,	test_sort_u32, NULL),
+	UNIT_TEST(sort_u64,	test_sort_u64, NULL),
+	UNIT_TEST(sort_custom,	test_sort_custom, NULL),
+	UNIT_TEST(sort_bench,	test_sort_bench, NULL),
+};
+
+UNIT_MODULE(posix_sort, posix_sort_tests, UNIT_PRIO_POSIX_TEST);